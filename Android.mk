@@ -59,6 +59,7 @@ libMesa_SRC_FILES := \
     src/glsl/ir_import_prototypes.cpp \
     src/glsl/ir_print_visitor.cpp \
     src/glsl/ir_reader.cpp \
+    src/glsl/ir_serialize.cpp \
     src/glsl/ir_rvalue_visitor.cpp \
     src/glsl/ir_set_program_inouts.cpp \
     src/glsl/ir_validate.cpp \
@@ -105,14 +106,17 @@ libMesa_SRC_FILES := \
     src/mesa/program/prog_parameter.cpp \
     src/mesa/program/symbol_table.c \
     src/pixelflinger2/buffer.cpp \
+    src/pixelflinger2/deferred.cpp \
     src/pixelflinger2/format.cpp \
     src/pixelflinger2/llvm_scanline.cpp \
     src/pixelflinger2/llvm_texture.cpp \
     src/pixelflinger2/pixelflinger2.cpp \
     src/pixelflinger2/raster.cpp \
+    src/pixelflinger2/rect.cpp \
     src/pixelflinger2/scanline.cpp \
     src/pixelflinger2/shader.cpp \
     src/pixelflinger2/texture.cpp \
+    src/pixelflinger2/vertex_cache.cpp \
     src/talloc/hieralloc.c
 
 libMesa_C_INCLUDES := \
@@ -203,9 +207,75 @@ LOCAL_MODULE_CLASS := EXECUTABLES
 LOCAL_SRC_FILES := src/glsl/glsl_compiler.cpp
 LOCAL_C_INCLUDES := $(libMesa_C_INCLUDES)
 LOCAL_STATIC_LIBRARIES := libMesa
+LOCAL_LDLIBS := -lrt
 
 include $(BUILD_HOST_EXECUTABLE)
 
+# glsl_compiler with --bench timing the LLVM and bcc phases, for host
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -O3 -DGLSL_COMPILER_BENCH=1
+
+LOCAL_MODULE := glsl_compiler_bench
+LOCAL_MODULE_CLASS := EXECUTABLES
+LOCAL_SRC_FILES := src/glsl/glsl_compiler.cpp
+LOCAL_C_INCLUDES := $(libMesa_C_INCLUDES)
+LOCAL_STATIC_LIBRARIES := libMesa
+LOCAL_LDLIBS := -lrt -ldl -lpthread
+
+ifeq ($(USE_LLVM_EXECUTIONENGINE),true)
+LOCAL_STATIC_LIBRARIES += libLLVMX86CodeGen libLLVMX86Info $(libMesa_STATIC_LIBS)
+else
+LOCAL_SHARED_LIBRARIES := libbcc libbcinfo
+endif
+
+include $(LLVM_HOST_BUILD_MK)
+include $(BUILD_HOST_EXECUTABLE)
+
+# hash_table microbenchmark for host
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -O3
+
+LOCAL_MODULE := hash_table_bench
+LOCAL_MODULE_CLASS := EXECUTABLES
+LOCAL_SRC_FILES := src/mesa/program/hash_table_bench.c
+LOCAL_C_INCLUDES := $(libMesa_C_INCLUDES)
+LOCAL_STATIC_LIBRARIES := libMesa
+LOCAL_LDLIBS := -lrt
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# pixelflinger2 rendering benchmark for host
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS += -O3
+
+LOCAL_MODULE := pixelflinger2_bench
+LOCAL_MODULE_CLASS := EXECUTABLES
+LOCAL_SRC_FILES := src/pixelflinger2/pixelflinger2_bench.cpp
+LOCAL_C_INCLUDES := $(libMesa_C_INCLUDES)
+LOCAL_STATIC_LIBRARIES := libMesa
+LOCAL_LDLIBS := -lrt -ldl -lpthread
+
+ifeq ($(USE_LLVM_EXECUTIONENGINE),true)
+LOCAL_STATIC_LIBRARIES += libLLVMX86CodeGen libLLVMX86Info $(libMesa_STATIC_LIBS)
+else
+LOCAL_SHARED_LIBRARIES := libbcc libbcinfo
+endif
+
+include $(LLVM_HOST_BUILD_MK)
+include $(BUILD_HOST_EXECUTABLE)
+
 # Build children
 # ========================================================
 include $(call all-makefiles-under,$(LOCAL_PATH))
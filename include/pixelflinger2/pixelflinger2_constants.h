@@ -33,12 +33,19 @@
 
 #define GGL_FS_INPUT_OFFSET             1 // vector4 index of first fs input in VertexOut
 #define GGL_FS_INPUT_FRAGCOORD_INDEX    0
-#define GGL_FS_INPUT_VARYINGS_INDEX     (GGL_FS_INPUT_FRAGCOORD_INDEX + 1)
-#define GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX (GGL_FS_INPUT_VARYINGS_INDEX + GGL_MAXVARYINGVECTORS)
+#define GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX (GGL_FS_INPUT_FRAGCOORD_INDEX + 1)
+#define GGL_FS_INPUT_VARYINGS_INDEX     (GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX + 1)
 
-#define GGL_FS_OUTPUT_OFFSET            (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX + 1)
+#define GGL_FS_OUTPUT_OFFSET            (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_VARYINGS_INDEX + GGL_MAXVARYINGVECTORS)
 #define GGL_FS_OUTPUT_FRAGCOLOR_INDEX   0
 
 #define GGL_MAX_VIEWPORT_DIMS           4096
 
+// pixelflinger2 specific EnableDisable cap, outside the GLenum range
+#define GGL_REDUCED_PRECISION           0x10000
+// records triangles and clears, rasterizes them on worker threads at Flush/Finish
+#define GGL_DEFERRED_RENDERING          0x10001
+// keeps vertex shader outputs of DrawTriangles calls with a cache key for reuse
+#define GGL_VERTEX_CACHE                0x10002
+
 #endif // _PIXELFLINGER2_CONSTANTS_H_
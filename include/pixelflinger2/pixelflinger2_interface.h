@@ -34,12 +34,13 @@ __attribute__ ((aligned (16))) // LLVM generates movaps on X86, needs 16 bytes a
 #endif
 VertexInput_t;
 
-// the layout must NOT change, and must match the #defines in constants.h
+// the layout must match the #defines in constants.h; raster and scanline only use
+// the part up to the program's last varying, so varyings come after everything else they use
 typedef struct VertexOutput {
    Vector4 pointSize; // vert output
    Vector4 position; // vert output and frag input gl_FragCoord
-   Vector4 varyings[GGL_MAXVARYINGVECTORS];
    Vector4 frontFacingPointCoord; // frag input, gl_FrontFacing gl_PointCoord yzw
+   Vector4 varyings[GGL_MAXVARYINGVECTORS];
    Vector4 fragColor[GGL_MAXDRAWBUFFERS]; // frag output, gl_FragData
 }
 #ifndef __arm__
@@ -159,8 +160,21 @@ typedef struct GGLState {
 
    GGLTextureState_t textureState; // most affect vs/fs jit
 
+   // EnableDisable(GGL_REDUCED_PRECISION); lowp math in 16 bit fixed point with
+   // gl_FragColor handed to blending as integers, mediump rcp/rsqrt estimates;
+   // affects vs/fs jit
+unsigned reducedPrecision :
+   1;
 } GGLState_t;
 
+// shader JIT counters across all contexts, per linked shader stage
+typedef struct GGLShaderStatistics {
+   unsigned jitCount; // GGLShaderUse generated code for a new state key
+   unsigned cacheHits; // GGLShaderUse reused code generated for the same state key
+   double jitSeconds; // time spent in jitCount generations
+   double llvmSeconds; // part of jitSeconds building LLVM modules, the rest is bcc codegen
+} GGLShaderStatistics_t;
+
 // most functions are according to GL ES 2.0 spec and uses GLenum values
 // there is some error checking for invalid GLenum
 typedef struct GGLInterface GGLInterface_t;
@@ -171,6 +185,9 @@ struct GGLInterface {
    void (* DepthRangef)(GGLInterface_t * iface, GLclampf zNear, GLclampf zFar);
    void (* Viewport)(GGLInterface_t * iface, GLint x, GLint y, GLsizei width, GLsizei height);
    void (* ViewportTransform)(const GGLInterface_t * iface, Vector4 * v);
+   // box applied in triangle setup and Clear while GL_SCISSOR_TEST is enabled;
+   // y counts rows like Viewport, so scissor and viewport rectangles match
+   void (* Scissor)(GGLInterface_t * iface, GLint x, GLint y, GLsizei width, GLsizei height);
 
 
    void (* BlendColor)(GGLInterface_t * iface, GLclampf red, GLclampf green,
@@ -197,9 +214,19 @@ struct GGLInterface {
    void (* SetSampler)(GGLInterface_t * iface, const unsigned sampler, GGLTexture_t * texture);
 
    // shallow copy, surface data must remain valid; use GL_COLOR_BUFFER_BIT,
-   // GL_DEPTH_BUFFER_BIT, GL_STENCIL_BUFFER_BIT; format must be RGBA_8888, Z_32 or S_8
+   // GL_DEPTH_BUFFER_BIT, GL_STENCIL_BUFFER_BIT; format must be RGBA_8888 or RGB_565,
+   // Z_32, Z_16 or SZ_24 for depth, S_8 for stencil; SZ_24 keeps stencil in the high
+   // byte of each depth value and a separate stencil surface is then not used, so set
+   // the same surface for both depth and stencil
    void (* SetBuffer)(GGLInterface_t * iface, const GLenum type, GGLSurface_t * surface);
 
+   // with EnableDisable(GGL_DEFERRED_RENDERING), DrawTriangle, RasterTriangle, DrawRect
+   // and Clear only record; surfaces, textures and programs they use must stay valid until Finish.
+   // Flush starts rasterizing recorded commands on worker threads and returns,
+   // Finish also waits for them; both do nothing in immediate mode
+   void (* Flush)(const GGLInterface_t * iface);
+   void (* Finish)(const GGLInterface_t * iface);
+
 
    // runs active vertex shader using currently set program; no error checking
    void (* ProcessVertex)(const GGLInterface_t * iface, const VertexInput_t * input,
@@ -207,13 +234,28 @@ struct GGLInterface {
    // draws a triangle given 3 unprocessed vertices; should be moved into libAgl2
    void (* DrawTriangle)(const GGLInterface_t * iface, const VertexInput_t * v0,
                          const VertexInput_t * v1, const VertexInput_t * v2);
-   // rasters a vertex processed triangle using active program; scizors to frame surface
+   // DrawTriangle for count / 3 triangles of consecutive vertices; with
+   // EnableDisable(GGL_VERTEX_CACHE) and a non 0 cacheKey the vertex shader outputs are kept,
+   // and later calls with the same cacheKey, vertices and count reuse them while the program
+   // and its uniforms are unchanged; use another cacheKey (or 0) once vertices are modified
+   void (* DrawTriangles)(const GGLInterface_t * iface, const VertexInput_t * vertices,
+                          unsigned count, unsigned cacheKey);
+   // rasters a vertex processed triangle using active program; scizors to frame surface and Scissor box
    void (* RasterTriangle)(const GGLInterface_t * iface, const VertexOutput_t * v1,
                            const VertexOutput_t * v2, const VertexOutput_t * v3);
-   // rasters a vertex processed trapezoid using active program; scizors to frame surface
+   // rasters a vertex processed trapezoid using active program; scizors to frame surface and Scissor box
    void (* RasterTrapezoid)(const GGLInterface_t * iface, const VertexOutput_t * tl,
                             const VertexOutput_t * tr, const VertexOutput_t * bl,
                             const VertexOutput_t * br);
+   // 2D compositing fast path like OES_draw_texture: copies texels [u, u + cropWidth) x
+   // [v, v + cropHeight) of sampler unit to window rect [x, x + width) x [y, y + height),
+   // nearest sampled if scaled; texel rows go down like window rows. Ignores the program;
+   // Scissor and blending apply. Returns GL_FALSE without drawing if depth or stencil test,
+   // a blend function other than source over, texture or surface format, or scaling with
+   // GGL_LINEAR filter needs the general path, so the caller draws triangles instead
+   GLboolean (* DrawRect)(const GGLInterface_t * iface, const unsigned sampler,
+                          GLint x, GLint y, GLsizei width, GLsizei height,
+                          GLint u, GLint v, GLsizei cropWidth, GLsizei cropHeight);
 
    // scan line given left and right processed and scizored vertices
    void (* ScanLine)(const GGLInterface_t * iface, const VertexOutput_t * v1,
@@ -242,7 +284,14 @@ struct GGLInterface {
                          gl_shader_t * shader);
 
    // duplicates shaders to program, and links varyings / attributes
-   GLboolean (* ShaderProgramLink)(gl_shader_program_t * program, const char ** infoLog);
+   GLboolean (* ShaderProgramLink)(GGLInterface_t * iface, gl_shader_program_t * program,
+                                   const char ** infoLog);
+   // serializes linked program into binary; binary == NULL only returns size in length
+   GLboolean (* ShaderProgramGetBinary)(const gl_shader_program_t * program, GLsizei bufSize,
+                                        GLsizei * length, void * binary);
+   // restores program from ShaderProgramGetBinary instead of linking; GL_FALSE if rejected
+   GLboolean (* ShaderProgramBinary)(GGLInterface_t * iface, gl_shader_program_t * program,
+                                     const void * binary, GLsizei length);
    // frees program
    void (* ShaderProgramDelete)(GGLInterface_t * iface, gl_shader_program_t * program);
 
@@ -316,12 +365,24 @@ extern "C"
    // duplicates shaders to program, and links varyings / attributes;
    GLboolean GGLShaderProgramLink(gl_shader_program_t * program, const char ** infoLog);
 
+   // serializes linked program into binary; binary == NULL only returns size in length
+   GLboolean GGLShaderProgramGetBinary(const gl_shader_program_t * program, GLsizei bufSize,
+                                       GLsizei * length, void * binary);
+
+   // restores program from GGLShaderProgramGetBinary instead of linking, ready for GGLShaderUse;
+   // binary is only used during call, returns GL_FALSE if it is from another build or corrupt
+   GLboolean GGLShaderProgramBinary(gl_shader_program_t * program, const void * binary,
+                                    GLsizei length);
+
    // frees program
    void GGLShaderProgramDelete(gl_shader_program_t * program);
 
    // LLVM JIT and set as active program, also call after gglState change to re-JIT
    void GGLShaderUse(void * llvmCtx, const GGLState_t * gglState, gl_shader_program_t * program);
 
+   // copies JIT counters into stats, and zeroes them if reset
+   void GGLShaderGetStatistics(GGLShaderStatistics_t * stats, GLboolean reset);
+
    void GGLShaderGetiv(const gl_shader_t * shader, const GLenum pname, GLint * params);
 
    void GGLShaderGetInfoLog(const gl_shader_t * shader, GLsizei bufsize, GLsizei* length, GLchar* infolog);
@@ -353,7 +414,7 @@ extern "C"
                          VertexOutput_t * output, const float (*constants)[4]);
 
    // scan line given left and right processed and scizored vertices
-   // depth value bitcast float->int, if negative then ^= 0x7fffffff
+   // depthBuffer is Z_32 and stencilBuffer S_8; depth value bitcast float->int, if negative then ^= 0x7fffffff
    void GGLScanLine(const gl_shader_program_t * program, const enum GGLPixelFormat colorFormat,
                     void * frameBuffer, int * depthBuffer, unsigned char * stencilBuffer,
                     unsigned bufferWidth, unsigned bufferHeight, GGLActiveStencil_t * activeStencil,
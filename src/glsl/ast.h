@@ -318,9 +318,10 @@ public:
 
 
 enum {
-   ast_precision_high = 0, /**< Default precision. */
+   ast_precision_high = 0,
    ast_precision_medium,
-   ast_precision_low
+   ast_precision_low,
+   ast_precision_none /**< No qualifier, the default precision applies. */
 };
 
 struct ast_type_qualifier {
@@ -440,7 +441,7 @@ public:
    /** Construct a type specifier from a type name */
    ast_type_specifier(const char *name) 
       : type_specifier(ast_type_name), type_name(name), structure(NULL),
-	is_array(false), array_size(NULL), precision(ast_precision_high)
+	is_array(false), array_size(NULL), precision(ast_precision_none)
    {
       /* empty */
    }
@@ -448,7 +449,7 @@ public:
    /** Construct a type specifier from a structure definition */
    ast_type_specifier(ast_struct_specifier *s)
       : type_specifier(ast_struct), type_name(s->name), structure(s),
-	is_array(false), array_size(NULL), precision(ast_precision_high)
+	is_array(false), array_size(NULL), precision(ast_precision_none)
    {
       /* empty */
    }
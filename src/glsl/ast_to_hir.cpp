@@ -1795,6 +1795,67 @@ ast_type_specifier::glsl_type(const char **name,
 }
 
 
+/**
+ * Name under which the default precision of \c type is kept
+ *
+ * Vectors and matrices share the default of their scalar type and each
+ * sampler type has its own.  Types that cannot take a default return NULL.
+ */
+static const char *
+default_precision_type_name(const glsl_type *type)
+{
+   switch (type->base_type) {
+   case GLSL_TYPE_FLOAT:
+      return "float";
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_UINT:
+      return "int";
+   case GLSL_TYPE_SAMPLER:
+      return type->name;
+   default:
+      return NULL;
+   }
+}
+
+
+/**
+ * Set the GLSL ES precision of a declared variable
+ *
+ * Declarations without a qualifier take the default precision of their
+ * base type that is in scope.  Samplers default to \c lowp as in GLSL ES
+ * 1.00, everything else to \c highp.
+ */
+static void
+apply_precision_to_variable(const ast_type_specifier *spec, ir_variable *var,
+			    struct _mesa_glsl_parse_state *state)
+{
+   unsigned precision = spec->precision;
+
+   if (precision == ast_precision_none) {
+      const glsl_type *type = var->type;
+      while (type->is_array())
+	 type = type->fields.array;
+
+      const char *name = default_precision_type_name(type);
+      if (name == NULL
+	  || !state->symbols->get_default_precision_qualifier(name, &precision))
+	 precision = type->is_sampler() ? ast_precision_low : ast_precision_high;
+   }
+
+   switch (precision) {
+   case ast_precision_low:
+      var->precision = ir_precision_low;
+      break;
+   case ast_precision_medium:
+      var->precision = ir_precision_medium;
+      break;
+   default:
+      var->precision = ir_precision_high;
+      break;
+   }
+}
+
+
 static void
 apply_type_qualifier_to_variable(const struct ast_type_qualifier *qual,
 				 ir_variable *var,
@@ -2018,6 +2079,23 @@ ast_declarator_list::hir(exec_list *instructions,
        */
 
       if (decl_type != NULL) {
+	 const unsigned precision = this->type->specifier->precision;
+
+	 if (precision != ast_precision_none) {
+	    /* GLSL ES 1.00 section 4.5.3: the default precision can only be
+	     * declared for int, float or a sampler type.
+	     */
+	    if (decl_type->is_sampler()
+		|| (decl_type->is_scalar()
+		    && (decl_type->base_type == GLSL_TYPE_FLOAT
+			|| decl_type->base_type == GLSL_TYPE_INT)))
+	       state->symbols->add_default_precision_qualifier(
+		  default_precision_type_name(decl_type), precision);
+	    else
+	       _mesa_glsl_error(& loc, state,
+				"default precision can only be set for "
+				"`int', `float' or a sampler type");
+	 }
       } else {
 	    _mesa_glsl_error(& loc, state, "incomplete declaration");
       }
@@ -2052,6 +2130,7 @@ ast_declarator_list::hir(exec_list *instructions,
       }
 
       var = new(ctx) ir_variable(var_type, decl->identifier, ir_var_auto);
+      apply_precision_to_variable(this->type->specifier, var, state);
 
       /* From page 22 (page 28 of the PDF) of the GLSL 1.10 specification;
        *
@@ -2500,6 +2579,7 @@ ast_parameter_declarator::hir(exec_list *instructions,
 
    is_void = false;
    ir_variable *var = new(ctx) ir_variable(type, this->identifier, ir_var_in);
+   apply_precision_to_variable(this->type->specifier, var, state);
 
    /* Apply any specified qualifiers to the parameter declaration.  Note that
     * for function parameters the default mode is 'in'.
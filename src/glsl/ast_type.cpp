@@ -49,7 +49,7 @@ ast_type_specifier::print(void) const
 
 ast_type_specifier::ast_type_specifier(int specifier)
       : type_specifier(ast_types(specifier)), type_name(NULL), structure(NULL),
-	is_array(false), array_size(NULL), precision(ast_precision_high)
+	is_array(false), array_size(NULL), precision(ast_precision_none)
 {
    static const char *const names[] = {
       "void",
@@ -141,12 +141,135 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	return clean;
 }
 
+/* Matches the directive name following a '#' at the start of a line. */
+static int
+directive_is(const char *ptr, const char *name)
+{
+	size_t len = strlen(name);
+	return strncmp(ptr, name, len) == 0 && !isalnum((unsigned char)ptr[len])
+		&& ptr[len] != '_';
+}
+
+/* Fast path for shaders that need no preprocessing.
+ *
+ * When the only directives are #version, #extension and #pragma and no
+ * predefined macro (all named GL_* or __*) is referenced, glcpp's output is
+ * the source with comments replaced by whitespace.  Produce that directly in
+ * one pass instead of building and printing token lists.
+ *
+ * The GLSL lexer still rescans the text.  glcpp tokens are not handed to
+ * the GLSL parser directly because the two scanners have different token
+ * sets, and the GLSL lexer itself tracks #version, #extension and #pragma
+ * state, so doing so would mean merging the two scanners.
+ *
+ * Returns NULL if the shader needs the full preprocessor.
+ */
+static char *
+preprocess_trivial(void *ctx, const char *shader)
+{
+	char *const clean = hieralloc_size(ctx, strlen(shader) + 1);
+	const char *src = shader;
+	char *dst = clean;
+	int line_start = 1; /* -1 after a comment with a newline in it */
+
+	if (clean == NULL)
+		return NULL;
+
+	while (*src) {
+		if (*src == '\\')
+			goto full;
+
+		if (src[0] == '/' && src[1] == '/') {
+			while (*src && *src != '\n')
+				src++;
+			continue;
+		}
+
+		if (src[0] == '/' && src[1] == '*') {
+			const char *end = strstr(src + 2, "*/");
+			if (end == NULL)
+				goto full;
+			/* Keep the newlines so line numbers still match.  A
+			 * comment is whitespace, so one without a newline leaves
+			 * line_start alone; after one with a newline a '#' is left
+			 * to the full preprocessor.
+			 */
+			for (; src < end; src++)
+				if (*src == '\n') {
+					*dst++ = '\n';
+					line_start = -1;
+				}
+			*dst++ = ' ';
+			src = end + 2;
+			continue;
+		}
+
+		if (*src == '#' && line_start < 0)
+			goto full;
+
+		if (*src == '#' && line_start) {
+			const char *name = src + 1;
+			while (*name == ' ' || *name == '\t')
+				name++;
+			if (directive_is(name, "extension") ||
+			    directive_is(name, "pragma")) {
+				/* Passed through verbatim, as glcpp does. */
+				while (*src && *src != '\n')
+					*dst++ = *src++;
+				continue;
+			}
+			if (!directive_is(name, "version"))
+				goto full;
+		}
+
+		if (isalpha((unsigned char)*src) || *src == '_') {
+			if (strncmp(src, "GL_", 3) == 0 ||
+			    strncmp(src, "__", 2) == 0)
+				goto full;
+			while (isalnum((unsigned char)*src) || *src == '_')
+				*dst++ = *src++;
+			line_start = 0;
+			continue;
+		}
+
+		/* Numbers like 1e5 or 0xff are not identifiers. */
+		if (isdigit((unsigned char)*src) ||
+		    (*src == '.' && isdigit((unsigned char)src[1]))) {
+			while (isalnum((unsigned char)*src) || *src == '_' || *src == '.')
+				*dst++ = *src++;
+			line_start = 0;
+			continue;
+		}
+
+		if (*src == '\n')
+			line_start = 1;
+		else if (*src != ' ' && *src != '\t')
+			line_start = 0;
+		*dst++ = *src++;
+	}
+
+	*dst = '\0';
+	return clean;
+
+full:
+	hieralloc_free(clean);
+	return NULL;
+}
+
 int
 preprocess(void *hieralloc_ctx, const char **shader, char **info_log,
 	   const struct gl_extensions *extensions, int api)
 {
 	int errors;
-	glcpp_parser_t *parser = glcpp_parser_create (extensions, api);
+	glcpp_parser_t *parser;
+	char *clean = preprocess_trivial(hieralloc_ctx, *shader);
+
+	if (clean != NULL) {
+		*shader = clean;
+		return 0;
+	}
+
+	parser = glcpp_parser_create (extensions, api);
 	*shader = remove_line_continuations(parser, *shader);
 
 	glcpp_lex_set_source_string (parser, *shader);
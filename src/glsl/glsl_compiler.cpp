@@ -27,6 +27,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "ast.h"
@@ -37,6 +38,11 @@
 #include "program.h"
 #include "loop_analysis.h"
 #include "src/mesa/main/shaderobj.h"
+#include "src/mesa/program/prog_parameter.h"
+
+#if GLSL_COMPILER_BENCH
+#include "pixelflinger2/pixelflinger2_interface.h"
+#endif
 
 static void
 initialize_context(struct gl_context *ctx, gl_api api)
@@ -117,6 +123,8 @@ int dump_ast = 0;
 int dump_hir = 0;
 int dump_lir = 0;
 int do_link = 0;
+int bench_iterations = 0;
+int bench_uber = 0;
 
 const struct option compiler_opts[] = {
    { "glsl-es",  0, &glsl_es,  1 },
@@ -124,9 +132,61 @@ const struct option compiler_opts[] = {
    { "dump-hir", 0, &dump_hir, 1 },
    { "dump-lir", 0, &dump_lir, 1 },
    { "link",     0, &do_link,  1 },
+   { "bench",    1, NULL,      'b' },
+   { "uber",     1, NULL,      'u' },
    { NULL, 0, NULL, 0 }
 };
 
+/**
+ * Compiler phases timed by --bench
+ *
+ * The LLVM phases only run in the glsl_compiler_bench build, which links
+ * pixelflinger2 and bcc.
+ */
+enum bench_phase {
+   PHASE_PREPROCESS,
+   PHASE_PARSE,
+   PHASE_AST_TO_HIR,
+   PHASE_OPTIMIZE,
+   PHASE_LINK,
+   PHASE_IR_TO_LLVM,
+   PHASE_CODEGEN,
+   PHASE_COUNT
+};
+
+static const char *const phase_names[PHASE_COUNT] = {
+   "glcpp",
+   "lex/parse",
+   "ast_to_hir",
+   "optimize",
+   "link_shaders",
+   "ir_to_llvm",
+   "bcc codegen",
+};
+
+static double phase_seconds[PHASE_COUNT];
+static unsigned optimize_passes;
+static unsigned optimized_shaders;
+
+static double
+now_seconds(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Add the time since \c *start to \c phase, and restart \c *start
+ */
+static void
+end_phase(enum bench_phase phase, double *start)
+{
+   const double now = now_seconds();
+   phase_seconds[phase] += now - *start;
+   *start = now;
+}
+
 /**
  * \brief Print proper usage and exit with failure.
  */
@@ -136,12 +196,19 @@ usage_fail(const char *name)
 
    const char *header =
       "usage: %s [options] <file.vert | file.geom | file.frag>\n"
+      "       %s --bench=<iterations> [--uber=<functions>] [--glsl-es] <files>\n"
       "\n"
       "Possible options are:\n";
    printf(header, name, name);
    for (const struct option *o = compiler_opts; o->name != 0; ++o) {
-      printf("    --%s\n", o->name);
+      printf("    --%s%s\n", o->name, o->has_arg ? "=<n>" : "");
    }
+   printf("\n"
+	  "--bench compiles all files <iterations> times and prints time per\n"
+	  "phase.  .vert, .geom and .frag files sharing a base name are linked\n"
+	  "together, .glsl files are compiled as vertex shaders and .c files are\n"
+	  "only preprocessed.  --uber adds a generated vertex/fragment program\n"
+	  "with <functions> functions per stage.\n");
    exit(EXIT_FAILURE);
 }
 
@@ -152,15 +219,18 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
    struct _mesa_glsl_parse_state *state =
       new(shader) _mesa_glsl_parse_state(ctx, shader->Type, shader);
 
+   double start = now_seconds();
    const char *source = shader->Source;
    state->error = preprocess(state, &source, &state->info_log,
 			     state->extensions, ctx->API);
+   end_phase(PHASE_PREPROCESS, &start);
 
    if (!state->error) {
       _mesa_glsl_lexer_ctor(state, source);
       _mesa_glsl_parse(state);
       _mesa_glsl_lexer_dtor(state);
    }
+   end_phase(PHASE_PARSE, &start);
 
    if (dump_ast) {
       foreach_list_const(n, &state->translation_unit) {
@@ -170,9 +240,11 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
       printf("\n\n");
    }
 
+   start = now_seconds();
    shader->ir = new(shader) exec_list;
    if (!state->error && !state->translation_unit.is_empty())
       _mesa_ast_to_hir(shader->ir, state);
+   end_phase(PHASE_AST_TO_HIR, &start);
 
    /* Print out the unoptimized IR. */
    if (!state->error && dump_hir) {
@@ -183,9 +255,13 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
    /* Optimization passes */
    if (!state->error && !shader->ir->is_empty()) {
       bool progress;
+      start = now_seconds();
       do {
 	 progress = do_common_optimization(shader->ir, false, 32);
+	 optimize_passes++;
       } while (progress);
+      optimized_shaders++;
+      end_phase(PHASE_OPTIMIZE, &start);
 
       validate_ir_tree(shader->ir);
    }
@@ -216,6 +292,282 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
    return;
 }
 
+/**
+ * Create an empty program with the parameter lists link_shaders fills in
+ */
+static struct gl_shader_program *
+create_program(void)
+{
+   struct gl_shader_program *prog;
+
+   prog = hieralloc_zero(NULL, struct gl_shader_program);
+   assert(prog != NULL);
+   prog->Attributes = hieralloc_zero(prog, gl_program_parameter_list);
+   prog->Varying = hieralloc_zero(prog, gl_program_parameter_list);
+   return prog;
+}
+
+static struct gl_shader *
+add_shader(struct gl_shader_program *prog, GLenum type)
+{
+   prog->Shaders = (struct gl_shader **)
+      hieralloc_realloc(prog, prog->Shaders,
+			struct gl_shader *, prog->NumShaders + 1);
+   assert(prog->Shaders != NULL);
+
+   struct gl_shader *shader = hieralloc_zero(prog, gl_shader);
+   shader->Type = type;
+   prog->Shaders[prog->NumShaders++] = shader;
+   return shader;
+}
+
+/**
+ * Generate one stage of a synthetic uber-shader
+ *
+ * Each function does a little vector math, a branch and a small loop, then
+ * calls the previous one, so inlining produces one large main().
+ */
+static char *
+generate_uber_shader(void *mem_ctx, GLenum type, unsigned functions)
+{
+   char *src = hieralloc_strdup(mem_ctx,
+				"#ifdef GL_ES\n"
+				"precision mediump float;\n"
+				"#endif\n"
+				"uniform vec4 u_param[8];\n"
+				"uniform mat4 u_matrix;\n"
+				"varying vec4 v_color;\n"
+				"varying vec4 v_coord;\n");
+   if (type == GL_VERTEX_SHADER)
+      src = hieralloc_strdup_append(src,
+				    "attribute vec4 a_position;\n"
+				    "attribute vec4 a_color;\n");
+
+   for (unsigned i = 0; i < functions; i++) {
+      src = hieralloc_asprintf_append(src,
+				      "vec4 f%u(vec4 x)\n"
+				      "{\n"
+				      "   vec4 r = x * u_param[%u] + vec4(%u.0 / 64.0);\n"
+				      "   if (r.x > r.y)\n"
+				      "      r = sin(r) + cos(r.yzwx);\n"
+				      "   else\n"
+				      "      r = normalize(r + u_param[%u].wzyx);\n"
+				      "   for (int j = 0; j < 4; j++)\n"
+				      "      r += r.wzyx * 0.25;\n",
+				      i, i % 8, i % 64, (i + 3) % 8);
+      if (i > 0)
+	 src = hieralloc_asprintf_append(src, "   return f%u(r);\n}\n", i - 1);
+      else
+	 src = hieralloc_strdup_append(src, "   return r;\n}\n");
+   }
+
+   if (type == GL_VERTEX_SHADER)
+      return hieralloc_asprintf_append(src,
+				       "void main()\n"
+				       "{\n"
+				       "   v_coord = f%u(a_position);\n"
+				       "   v_color = a_color * v_coord;\n"
+				       "   gl_Position = u_matrix * a_position;\n"
+				       "}\n", functions - 1);
+   return hieralloc_asprintf_append(src,
+				    "void main()\n"
+				    "{\n"
+				    "   gl_FragColor = f%u(v_color) + v_coord;\n"
+				    "}\n", functions - 1);
+}
+
+/** A program in the --bench corpus */
+struct bench_program {
+   const char *base;		/**< file name without extension */
+   bool link;
+   unsigned num_shaders;
+   GLenum types[3];
+   const char *sources[3];
+};
+
+static void
+bench_add_shader(struct bench_program *program, GLenum type,
+		 const char *source, const char *name)
+{
+   if (program->num_shaders == 3) {
+      printf("Too many shaders for \"%s\".\n", name);
+      exit(EXIT_FAILURE);
+   }
+   program->types[program->num_shaders] = type;
+   program->sources[program->num_shaders] = source;
+   program->num_shaders++;
+}
+
+static int
+run_benchmark(struct gl_context *ctx, int argc, char **argv)
+{
+   void *corpus_ctx = hieralloc_new(NULL);
+   struct bench_program *programs =
+      hieralloc_array(corpus_ctx, struct bench_program, argc + 1);
+   const char **preprocess_only =
+      hieralloc_array(corpus_ctx, const char *, argc + 1);
+   unsigned num_programs = 0;
+   unsigned num_preprocess = 0;
+
+   for (/* empty */; argc > optind; optind++) {
+      const char *name = argv[optind];
+      const char *ext = strrchr(name, '.');
+      if (ext == NULL)
+	 usage_fail(argv[0]);
+
+      const char *source = load_text_file(corpus_ctx, name);
+      if (source == NULL) {
+	 printf("File \"%s\" does not exist.\n", name);
+	 exit(EXIT_FAILURE);
+      }
+
+      GLenum type = GL_VERTEX_SHADER;
+      bool link = true;
+      if (strcmp(ext, ".c") == 0) {
+	 preprocess_only[num_preprocess++] = source;
+	 continue;
+      } else if (strcmp(ext, ".glsl") == 0)
+	 link = false;
+      else if (strcmp(ext, ".geom") == 0)
+	 type = GL_GEOMETRY_SHADER;
+      else if (strcmp(ext, ".frag") == 0)
+	 type = GL_FRAGMENT_SHADER;
+      else if (strcmp(ext, ".vert") != 0)
+	 usage_fail(argv[0]);
+
+      const char *base = hieralloc_strndup(corpus_ctx, name, ext - name);
+      struct bench_program *program = NULL;
+      for (unsigned i = 0; link && i < num_programs; i++)
+	 if (programs[i].link && strcmp(programs[i].base, base) == 0)
+	    program = &programs[i];
+      if (program == NULL) {
+	 program = &programs[num_programs++];
+	 memset(program, 0, sizeof(*program));
+	 program->base = base;
+	 program->link = link;
+      }
+      bench_add_shader(program, type, source, name);
+   }
+
+   if (bench_uber > 0) {
+      struct bench_program *program = &programs[num_programs++];
+      memset(program, 0, sizeof(*program));
+      program->base = "uber";
+      program->link = true;
+      bench_add_shader(program, GL_VERTEX_SHADER,
+		       generate_uber_shader(corpus_ctx, GL_VERTEX_SHADER,
+					    bench_uber), "uber");
+      bench_add_shader(program, GL_FRAGMENT_SHADER,
+		       generate_uber_shader(corpus_ctx, GL_FRAGMENT_SHADER,
+					    bench_uber), "uber");
+   }
+
+#if GLSL_COMPILER_BENCH
+   /* ShaderUse JITs the vertex shader and the fragment shader's scanline */
+   static unsigned pixel;
+   GGLSurface_t surface = { 1, 1, GGL_PIXEL_FORMAT_RGBA_8888, &pixel, 1, 0 };
+   GGLInterface_t *iface = CreateGGLInterface();
+   iface->SetBuffer(iface, GL_COLOR_BUFFER_BIT, &surface);
+   GGLShaderStatistics_t jit;
+   GGLShaderGetStatistics(&jit, GL_TRUE);
+#endif
+
+   unsigned compile_failures = 0, link_failures = 0;
+   unsigned long baseline, peak;
+   hieralloc_usage(&baseline, NULL, 1);
+   memset(phase_seconds, 0, sizeof(phase_seconds));
+   const double total_start = now_seconds();
+
+   for (int iteration = 0; iteration < bench_iterations; iteration++) {
+      for (unsigned i = 0; i < num_preprocess; i++) {
+	 void *mem_ctx = hieralloc_new(NULL);
+	 const char *source = preprocess_only[i];
+	 char *info_log = hieralloc_strdup(mem_ctx, "");
+	 double start = now_seconds();
+	 preprocess(mem_ctx, &source, &info_log, &ctx->Extensions, ctx->API);
+	 end_phase(PHASE_PREPROCESS, &start);
+	 hieralloc_free(mem_ctx);
+      }
+
+      for (unsigned i = 0; i < num_programs; i++) {
+	 const struct bench_program *program = &programs[i];
+	 struct gl_shader_program *prog = create_program();
+	 bool compiled = true;
+
+	 for (unsigned j = 0; j < program->num_shaders; j++) {
+	    struct gl_shader *shader = add_shader(prog, program->types[j]);
+	    shader->Source = program->sources[j];
+	    compile_shader(ctx, shader);
+	    compiled = compiled && shader->CompileStatus;
+	 }
+
+	 if (compiled && program->link) {
+	    double start = now_seconds();
+	    link_shaders(ctx, prog);
+	    end_phase(PHASE_LINK, &start);
+#if GLSL_COMPILER_BENCH
+	    if (prog->LinkStatus) {
+	       iface->ShaderUse(iface, prog);
+	       iface->ShaderUse(iface, NULL);
+	    }
+#endif
+	 }
+
+	 if (iteration == 0) {
+	    compile_failures += !compiled;
+	    link_failures += compiled && program->link && !prog->LinkStatus;
+	 }
+
+	 for (unsigned j = 0; j < MESA_SHADER_TYPES; j++)
+#if GLSL_COMPILER_BENCH
+	    GGLShaderDelete(prog->_LinkedShaders[j]);
+#else
+	    hieralloc_free(prog->_LinkedShaders[j]);
+#endif
+	 hieralloc_free(prog);
+      }
+   }
+
+   const double total = now_seconds() - total_start;
+   hieralloc_usage(NULL, &peak, 0);
+
+   unsigned num_phases = PHASE_IR_TO_LLVM;
+#if GLSL_COMPILER_BENCH
+   GGLShaderGetStatistics(&jit, GL_TRUE);
+   phase_seconds[PHASE_IR_TO_LLVM] = jit.llvmSeconds;
+   phase_seconds[PHASE_CODEGEN] = jit.jitSeconds - jit.llvmSeconds;
+   num_phases = PHASE_COUNT;
+   DestroyGGLInterface(iface);
+#endif
+
+   printf("%u programs, %u preprocessor only files, %d iterations, "
+	  "%.3f ms per iteration\n", num_programs, num_preprocess,
+	  bench_iterations, total * 1000 / bench_iterations);
+   if (compile_failures || link_failures)
+      printf("%u programs failed to compile and %u failed to link\n",
+	     compile_failures, link_failures);
+
+   double phase_total = 0;
+   for (unsigned i = 0; i < num_phases; i++)
+      phase_total += phase_seconds[i];
+   printf("%-14s %12s %12s %7s\n", "phase", "total ms", "ms/iter", "%");
+   for (unsigned i = 0; i < num_phases; i++)
+      printf("%-14s %12.3f %12.4f %7.2f\n", phase_names[i],
+	     phase_seconds[i] * 1000,
+	     phase_seconds[i] * 1000 / bench_iterations,
+	     phase_total > 0 ? phase_seconds[i] * 100 / phase_total : 0.0);
+   printf("optimize: %.2f do_common_optimization passes per shader\n",
+	  optimized_shaders ? (double) optimize_passes / optimized_shaders : 0.0);
+   printf("hieralloc: %lu KiB peak above %lu KiB baseline\n",
+	  (peak - baseline) / 1024, baseline / 1024);
+
+   hieralloc_free(corpus_ctx);
+   _mesa_glsl_release_types();
+   _mesa_glsl_release_functions();
+
+   return EXIT_SUCCESS;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -225,45 +577,41 @@ main(int argc, char **argv)
 
    int c;
    int idx = 0;
-   while ((c = getopt_long(argc, argv, "", compiler_opts, &idx)) != -1)
-      /* empty */ ;
-
+   while ((c = getopt_long(argc, argv, "", compiler_opts, &idx)) != -1) {
+      if (c == 'b')
+	 bench_iterations = atoi(optarg);
+      else if (c == 'u')
+	 bench_uber = atoi(optarg);
+   }
 
-   if (argc <= optind)
+   if (argc <= optind && !(bench_iterations > 0 && bench_uber > 0))
       usage_fail(argv[0]);
 
    initialize_context(ctx, (glsl_es) ? API_OPENGLES2 : API_OPENGL);
 
-   struct gl_shader_program *whole_program;
+   if (bench_iterations > 0)
+      return run_benchmark(ctx, argc, argv);
 
-   whole_program = hieralloc_zero (NULL, struct gl_shader_program);
-   assert(whole_program != NULL);
+   struct gl_shader_program *whole_program = create_program();
 
    for (/* empty */; argc > optind; optind++) {
-      whole_program->Shaders = (struct gl_shader **)
-	 hieralloc_realloc(whole_program, whole_program->Shaders,
-			struct gl_shader *, whole_program->NumShaders + 1);
-      assert(whole_program->Shaders != NULL);
-
-      struct gl_shader *shader = hieralloc_zero(whole_program, gl_shader);
-
-      whole_program->Shaders[whole_program->NumShaders] = shader;
-      whole_program->NumShaders++;
-
       const unsigned len = strlen(argv[optind]);
       if (len < 6)
 	 usage_fail(argv[0]);
 
+      GLenum type;
       const char *const ext = & argv[optind][len - 5];
       if (strncmp(".vert", ext, 5) == 0)
-	 shader->Type = GL_VERTEX_SHADER;
+	 type = GL_VERTEX_SHADER;
       else if (strncmp(".geom", ext, 5) == 0)
-	 shader->Type = GL_GEOMETRY_SHADER;
+	 type = GL_GEOMETRY_SHADER;
       else if (strncmp(".frag", ext, 5) == 0)
-	 shader->Type = GL_FRAGMENT_SHADER;
+	 type = GL_FRAGMENT_SHADER;
       else
 	 usage_fail(argv[0]);
 
+      struct gl_shader *shader = add_shader(whole_program, type);
+
       shader->Source = load_text_file(whole_program, argv[optind]);
       if (shader->Source == NULL) {
 	 printf("File \"%s\" does not exist.\n", argv[optind]);
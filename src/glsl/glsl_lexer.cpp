@@ -1018,6 +1018,11 @@ static yyconst flex_int16_t yy_chk[1255] =
 
 #define IS_UINT (yytext[yyleng - 1] == 'u' || yytext[yyleng - 1] == 'U')
 
+/* Identifiers are interned in the parse state's symbol table, so repeated
+ * names share one copy and symbol lookups compare pointers.
+ */
+#define INTERN(name) ((char *) yyextra->symbols->intern(name))
+
 /* A macro for handling reserved words and keywords across language versions.
  *
  * Certain words start out as identifiers, become reserved words in
@@ -1040,7 +1045,7 @@ static yyconst flex_int16_t yy_chk[1255] =
 			  "Illegal use of reserved word `%s'", yytext);	\
 	 return ERROR_TOK;						\
       } else {								\
-	 yylval->identifier = strdup(yytext);				\
+	 yylval->identifier = INTERN(yytext);				\
 	 return IDENTIFIER;						\
       }									\
    } while (0)
@@ -1510,7 +1515,7 @@ case 17:
 YY_RULE_SETUP
 #line 156 "glsl_lexer.lpp"
 {
-				   yylval->identifier = strdup(yytext);
+				   yylval->identifier = INTERN(yytext);
 				   return IDENTIFIER;
 				}
 	YY_BREAK
@@ -1913,7 +1918,7 @@ YY_RULE_SETUP
 		      || (yyextra->ARB_fragment_coord_conventions_enable)){
 		      return LAYOUT_TOK;
 		   } else {
-		      yylval->identifier = strdup(yytext);
+		      yylval->identifier = INTERN(yytext);
 		      return IDENTIFIER;
 		   }
 		}
@@ -2510,9 +2515,7 @@ case 207:
 YY_RULE_SETUP
 #line 413 "glsl_lexer.lpp"
 {
-			    struct _mesa_glsl_parse_state *state = yyextra;
-			    void *ctx = state;	
-			    yylval->identifier = hieralloc_strdup(ctx, yytext);
+			    yylval->identifier = INTERN(yytext);
 			    return IDENTIFIER;
 			}
 	YY_BREAK
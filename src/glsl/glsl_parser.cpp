@@ -3494,21 +3494,24 @@ yyreduce:
 /* Line 1464 of yacc.c  */
 #line 688 "glsl_parser.ypp"
     {
-	   if (((yyvsp[(3) - (4)].type_specifier)->type_specifier != ast_float)
-	       && ((yyvsp[(3) - (4)].type_specifier)->type_specifier != ast_int)) {
-	      _mesa_glsl_error(& (yylsp[(3) - (4)]), state, "global precision qualifier can "
-			       "only be applied to `int' or `float'\n");
-	      YYERROR;
-	   }
-
-	   (yyval.node) = NULL; /* FINISHME */
+	   /* An empty declarator list sets the default precision of the type.
+	    * The type itself is checked once it has been resolved.
+	    */
+	   void *ctx = state;
+	   ast_fully_specified_type *const type =
+	      new(ctx) ast_fully_specified_type();
+	   type->set_location(yylloc);
+	   type->specifier = (yyvsp[(3) - (4)].type_specifier);
+	   type->specifier->precision = (yyvsp[(2) - (4)].n);
+	   (yyval.node) = new(ctx) ast_declarator_list(type);
+	   (yyval.node)->set_location(yylloc);
 	;}
     break;
 
   case 104:
 
 /* Line 1464 of yacc.c  */
-#line 711 "glsl_parser.ypp"
+#line 705 "glsl_parser.ypp"
     {
 	   (yyval.function) = (yyvsp[(1) - (2)].function);
 	   (yyval.function)->parameters.push_tail(& (yyvsp[(2) - (2)].parameter_declarator)->link);
@@ -3518,7 +3521,7 @@ yyreduce:
   case 105:
 
 /* Line 1464 of yacc.c  */
-#line 716 "glsl_parser.ypp"
+#line 710 "glsl_parser.ypp"
     {
 	   (yyval.function) = (yyvsp[(1) - (3)].function);
 	   (yyval.function)->parameters.push_tail(& (yyvsp[(3) - (3)].parameter_declarator)->link);
@@ -3528,7 +3531,7 @@ yyreduce:
   case 106:
 
 /* Line 1464 of yacc.c  */
-#line 724 "glsl_parser.ypp"
+#line 718 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.function) = new(ctx) ast_function();
@@ -3541,7 +3544,7 @@ yyreduce:
   case 107:
 
 /* Line 1464 of yacc.c  */
-#line 735 "glsl_parser.ypp"
+#line 729 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.parameter_declarator) = new(ctx) ast_parameter_declarator();
@@ -3556,7 +3559,7 @@ yyreduce:
   case 108:
 
 /* Line 1464 of yacc.c  */
-#line 745 "glsl_parser.ypp"
+#line 739 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.parameter_declarator) = new(ctx) ast_parameter_declarator();
@@ -3573,7 +3576,7 @@ yyreduce:
   case 109:
 
 /* Line 1464 of yacc.c  */
-#line 760 "glsl_parser.ypp"
+#line 754 "glsl_parser.ypp"
     {
 	   (yyvsp[(1) - (3)].type_qualifier).flags.i |= (yyvsp[(2) - (3)].type_qualifier).flags.i;
 
@@ -3585,7 +3588,7 @@ yyreduce:
   case 110:
 
 /* Line 1464 of yacc.c  */
-#line 767 "glsl_parser.ypp"
+#line 761 "glsl_parser.ypp"
     {
 	   (yyval.parameter_declarator) = (yyvsp[(2) - (2)].parameter_declarator);
 	   (yyval.parameter_declarator)->type->qualifier = (yyvsp[(1) - (2)].type_qualifier);
@@ -3595,7 +3598,7 @@ yyreduce:
   case 111:
 
 /* Line 1464 of yacc.c  */
-#line 772 "glsl_parser.ypp"
+#line 766 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyvsp[(1) - (3)].type_qualifier).flags.i |= (yyvsp[(2) - (3)].type_qualifier).flags.i;
@@ -3611,7 +3614,7 @@ yyreduce:
   case 112:
 
 /* Line 1464 of yacc.c  */
-#line 783 "glsl_parser.ypp"
+#line 777 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.parameter_declarator) = new(ctx) ast_parameter_declarator();
@@ -3625,7 +3628,7 @@ yyreduce:
   case 113:
 
 /* Line 1464 of yacc.c  */
-#line 795 "glsl_parser.ypp"
+#line 789 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	;}
@@ -3634,7 +3637,7 @@ yyreduce:
   case 114:
 
 /* Line 1464 of yacc.c  */
-#line 799 "glsl_parser.ypp"
+#line 793 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.in = 1;
@@ -3644,7 +3647,7 @@ yyreduce:
   case 115:
 
 /* Line 1464 of yacc.c  */
-#line 804 "glsl_parser.ypp"
+#line 798 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.out = 1;
@@ -3654,7 +3657,7 @@ yyreduce:
   case 116:
 
 /* Line 1464 of yacc.c  */
-#line 809 "glsl_parser.ypp"
+#line 803 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.in = 1;
@@ -3665,7 +3668,7 @@ yyreduce:
   case 119:
 
 /* Line 1464 of yacc.c  */
-#line 823 "glsl_parser.ypp"
+#line 817 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(3) - (3)].identifier), false, NULL, NULL);
@@ -3679,7 +3682,7 @@ yyreduce:
   case 120:
 
 /* Line 1464 of yacc.c  */
-#line 832 "glsl_parser.ypp"
+#line 826 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(3) - (5)].identifier), true, NULL, NULL);
@@ -3693,7 +3696,7 @@ yyreduce:
   case 121:
 
 /* Line 1464 of yacc.c  */
-#line 841 "glsl_parser.ypp"
+#line 835 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(3) - (6)].identifier), true, (yyvsp[(5) - (6)].expression), NULL);
@@ -3707,7 +3710,7 @@ yyreduce:
   case 122:
 
 /* Line 1464 of yacc.c  */
-#line 850 "glsl_parser.ypp"
+#line 844 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(3) - (7)].identifier), true, NULL, (yyvsp[(7) - (7)].expression));
@@ -3721,7 +3724,7 @@ yyreduce:
   case 123:
 
 /* Line 1464 of yacc.c  */
-#line 859 "glsl_parser.ypp"
+#line 853 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(3) - (8)].identifier), true, (yyvsp[(5) - (8)].expression), (yyvsp[(8) - (8)].expression));
@@ -3735,7 +3738,7 @@ yyreduce:
   case 124:
 
 /* Line 1464 of yacc.c  */
-#line 868 "glsl_parser.ypp"
+#line 862 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(3) - (5)].identifier), false, NULL, (yyvsp[(5) - (5)].expression));
@@ -3749,7 +3752,7 @@ yyreduce:
   case 125:
 
 /* Line 1464 of yacc.c  */
-#line 881 "glsl_parser.ypp"
+#line 875 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   if ((yyvsp[(1) - (1)].fully_specified_type)->specifier->type_specifier != ast_struct) {
@@ -3765,7 +3768,7 @@ yyreduce:
   case 126:
 
 /* Line 1464 of yacc.c  */
-#line 892 "glsl_parser.ypp"
+#line 886 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (2)].identifier), false, NULL, NULL);
@@ -3779,7 +3782,7 @@ yyreduce:
   case 127:
 
 /* Line 1464 of yacc.c  */
-#line 901 "glsl_parser.ypp"
+#line 895 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (4)].identifier), true, NULL, NULL);
@@ -3793,7 +3796,7 @@ yyreduce:
   case 128:
 
 /* Line 1464 of yacc.c  */
-#line 910 "glsl_parser.ypp"
+#line 904 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (5)].identifier), true, (yyvsp[(4) - (5)].expression), NULL);
@@ -3807,7 +3810,7 @@ yyreduce:
   case 129:
 
 /* Line 1464 of yacc.c  */
-#line 919 "glsl_parser.ypp"
+#line 913 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (6)].identifier), true, NULL, (yyvsp[(6) - (6)].expression));
@@ -3821,7 +3824,7 @@ yyreduce:
   case 130:
 
 /* Line 1464 of yacc.c  */
-#line 928 "glsl_parser.ypp"
+#line 922 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (7)].identifier), true, (yyvsp[(4) - (7)].expression), (yyvsp[(7) - (7)].expression));
@@ -3835,7 +3838,7 @@ yyreduce:
   case 131:
 
 /* Line 1464 of yacc.c  */
-#line 937 "glsl_parser.ypp"
+#line 931 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (4)].identifier), false, NULL, (yyvsp[(4) - (4)].expression));
@@ -3849,7 +3852,7 @@ yyreduce:
   case 132:
 
 /* Line 1464 of yacc.c  */
-#line 946 "glsl_parser.ypp"
+#line 940 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (2)].identifier), false, NULL, NULL);
@@ -3865,7 +3868,7 @@ yyreduce:
   case 133:
 
 /* Line 1464 of yacc.c  */
-#line 960 "glsl_parser.ypp"
+#line 954 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.fully_specified_type) = new(ctx) ast_fully_specified_type();
@@ -3877,7 +3880,7 @@ yyreduce:
   case 134:
 
 /* Line 1464 of yacc.c  */
-#line 967 "glsl_parser.ypp"
+#line 961 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.fully_specified_type) = new(ctx) ast_fully_specified_type();
@@ -3890,7 +3893,7 @@ yyreduce:
   case 135:
 
 /* Line 1464 of yacc.c  */
-#line 978 "glsl_parser.ypp"
+#line 972 "glsl_parser.ypp"
     {
 	  (yyval.type_qualifier) = (yyvsp[(3) - (4)].type_qualifier);
 	;}
@@ -3899,7 +3902,7 @@ yyreduce:
   case 137:
 
 /* Line 1464 of yacc.c  */
-#line 986 "glsl_parser.ypp"
+#line 980 "glsl_parser.ypp"
     {
 	   if (((yyvsp[(1) - (3)].type_qualifier).flags.i & (yyvsp[(3) - (3)].type_qualifier).flags.i) != 0) {
 	      _mesa_glsl_error(& (yylsp[(3) - (3)]), state,
@@ -3920,7 +3923,7 @@ yyreduce:
   case 138:
 
 /* Line 1464 of yacc.c  */
-#line 1005 "glsl_parser.ypp"
+#line 999 "glsl_parser.ypp"
     {
 	   bool got_one = false;
 
@@ -3954,7 +3957,7 @@ yyreduce:
   case 139:
 
 /* Line 1464 of yacc.c  */
-#line 1034 "glsl_parser.ypp"
+#line 1028 "glsl_parser.ypp"
     {
 	   bool got_one = false;
 
@@ -3997,7 +4000,7 @@ yyreduce:
   case 140:
 
 /* Line 1464 of yacc.c  */
-#line 1075 "glsl_parser.ypp"
+#line 1069 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.smooth = 1;
@@ -4007,7 +4010,7 @@ yyreduce:
   case 141:
 
 /* Line 1464 of yacc.c  */
-#line 1080 "glsl_parser.ypp"
+#line 1074 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.flat = 1;
@@ -4017,7 +4020,7 @@ yyreduce:
   case 142:
 
 /* Line 1464 of yacc.c  */
-#line 1085 "glsl_parser.ypp"
+#line 1079 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.noperspective = 1;
@@ -4027,7 +4030,7 @@ yyreduce:
   case 143:
 
 /* Line 1464 of yacc.c  */
-#line 1093 "glsl_parser.ypp"
+#line 1087 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.constant = 1;
@@ -4037,7 +4040,7 @@ yyreduce:
   case 146:
 
 /* Line 1464 of yacc.c  */
-#line 1103 "glsl_parser.ypp"
+#line 1097 "glsl_parser.ypp"
     {
 	   (yyval.type_qualifier) = (yyvsp[(1) - (2)].type_qualifier);
 	   (yyval.type_qualifier).flags.i |= (yyvsp[(2) - (2)].type_qualifier).flags.i;
@@ -4047,7 +4050,7 @@ yyreduce:
   case 148:
 
 /* Line 1464 of yacc.c  */
-#line 1109 "glsl_parser.ypp"
+#line 1103 "glsl_parser.ypp"
     {
 	   (yyval.type_qualifier) = (yyvsp[(1) - (2)].type_qualifier);
 	   (yyval.type_qualifier).flags.i |= (yyvsp[(2) - (2)].type_qualifier).flags.i;
@@ -4057,7 +4060,7 @@ yyreduce:
   case 149:
 
 /* Line 1464 of yacc.c  */
-#line 1114 "glsl_parser.ypp"
+#line 1108 "glsl_parser.ypp"
     {
 	   (yyval.type_qualifier) = (yyvsp[(2) - (2)].type_qualifier);
 	   (yyval.type_qualifier).flags.q.invariant = 1;
@@ -4067,7 +4070,7 @@ yyreduce:
   case 150:
 
 /* Line 1464 of yacc.c  */
-#line 1119 "glsl_parser.ypp"
+#line 1113 "glsl_parser.ypp"
     {
 	   (yyval.type_qualifier) = (yyvsp[(2) - (3)].type_qualifier);
 	   (yyval.type_qualifier).flags.i |= (yyvsp[(3) - (3)].type_qualifier).flags.i;
@@ -4078,7 +4081,7 @@ yyreduce:
   case 151:
 
 /* Line 1464 of yacc.c  */
-#line 1125 "glsl_parser.ypp"
+#line 1119 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.invariant = 1;
@@ -4088,7 +4091,7 @@ yyreduce:
   case 152:
 
 /* Line 1464 of yacc.c  */
-#line 1133 "glsl_parser.ypp"
+#line 1127 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.constant = 1;
@@ -4098,7 +4101,7 @@ yyreduce:
   case 153:
 
 /* Line 1464 of yacc.c  */
-#line 1138 "glsl_parser.ypp"
+#line 1132 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.attribute = 1;
@@ -4108,7 +4111,7 @@ yyreduce:
   case 154:
 
 /* Line 1464 of yacc.c  */
-#line 1143 "glsl_parser.ypp"
+#line 1137 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.varying = 1;
@@ -4118,7 +4121,7 @@ yyreduce:
   case 155:
 
 /* Line 1464 of yacc.c  */
-#line 1148 "glsl_parser.ypp"
+#line 1142 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.centroid = 1;
@@ -4129,7 +4132,7 @@ yyreduce:
   case 156:
 
 /* Line 1464 of yacc.c  */
-#line 1154 "glsl_parser.ypp"
+#line 1148 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.in = 1;
@@ -4139,7 +4142,7 @@ yyreduce:
   case 157:
 
 /* Line 1464 of yacc.c  */
-#line 1159 "glsl_parser.ypp"
+#line 1153 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.out = 1;
@@ -4149,7 +4152,7 @@ yyreduce:
   case 158:
 
 /* Line 1464 of yacc.c  */
-#line 1164 "glsl_parser.ypp"
+#line 1158 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.centroid = 1; (yyval.type_qualifier).flags.q.in = 1;
@@ -4159,7 +4162,7 @@ yyreduce:
   case 159:
 
 /* Line 1464 of yacc.c  */
-#line 1169 "glsl_parser.ypp"
+#line 1163 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.centroid = 1; (yyval.type_qualifier).flags.q.out = 1;
@@ -4169,7 +4172,7 @@ yyreduce:
   case 160:
 
 /* Line 1464 of yacc.c  */
-#line 1174 "glsl_parser.ypp"
+#line 1168 "glsl_parser.ypp"
     {
 	   memset(& (yyval.type_qualifier), 0, sizeof((yyval.type_qualifier)));
 	   (yyval.type_qualifier).flags.q.uniform = 1;
@@ -4179,7 +4182,7 @@ yyreduce:
   case 162:
 
 /* Line 1464 of yacc.c  */
-#line 1183 "glsl_parser.ypp"
+#line 1177 "glsl_parser.ypp"
     {
 	   (yyval.type_specifier) = (yyvsp[(2) - (2)].type_specifier);
 	   (yyval.type_specifier)->precision = (yyvsp[(1) - (2)].n);
@@ -4189,7 +4192,7 @@ yyreduce:
   case 164:
 
 /* Line 1464 of yacc.c  */
-#line 1192 "glsl_parser.ypp"
+#line 1186 "glsl_parser.ypp"
     {
 	   (yyval.type_specifier) = (yyvsp[(1) - (3)].type_specifier);
 	   (yyval.type_specifier)->is_array = true;
@@ -4200,7 +4203,7 @@ yyreduce:
   case 165:
 
 /* Line 1464 of yacc.c  */
-#line 1198 "glsl_parser.ypp"
+#line 1192 "glsl_parser.ypp"
     {
 	   (yyval.type_specifier) = (yyvsp[(1) - (4)].type_specifier);
 	   (yyval.type_specifier)->is_array = true;
@@ -4211,7 +4214,7 @@ yyreduce:
   case 166:
 
 /* Line 1464 of yacc.c  */
-#line 1207 "glsl_parser.ypp"
+#line 1201 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.type_specifier) = new(ctx) ast_type_specifier((yyvsp[(1) - (1)].n));
@@ -4222,7 +4225,7 @@ yyreduce:
   case 167:
 
 /* Line 1464 of yacc.c  */
-#line 1213 "glsl_parser.ypp"
+#line 1207 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.type_specifier) = new(ctx) ast_type_specifier((yyvsp[(1) - (1)].struct_specifier));
@@ -4233,7 +4236,7 @@ yyreduce:
   case 168:
 
 /* Line 1464 of yacc.c  */
-#line 1219 "glsl_parser.ypp"
+#line 1213 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.type_specifier) = new(ctx) ast_type_specifier((yyvsp[(1) - (1)].identifier));
@@ -4244,364 +4247,364 @@ yyreduce:
   case 169:
 
 /* Line 1464 of yacc.c  */
-#line 1227 "glsl_parser.ypp"
+#line 1221 "glsl_parser.ypp"
     { (yyval.n) = ast_void; ;}
     break;
 
   case 170:
 
 /* Line 1464 of yacc.c  */
-#line 1228 "glsl_parser.ypp"
+#line 1222 "glsl_parser.ypp"
     { (yyval.n) = ast_float; ;}
     break;
 
   case 171:
 
 /* Line 1464 of yacc.c  */
-#line 1229 "glsl_parser.ypp"
+#line 1223 "glsl_parser.ypp"
     { (yyval.n) = ast_int; ;}
     break;
 
   case 172:
 
 /* Line 1464 of yacc.c  */
-#line 1230 "glsl_parser.ypp"
+#line 1224 "glsl_parser.ypp"
     { (yyval.n) = ast_uint; ;}
     break;
 
   case 173:
 
 /* Line 1464 of yacc.c  */
-#line 1231 "glsl_parser.ypp"
+#line 1225 "glsl_parser.ypp"
     { (yyval.n) = ast_bool; ;}
     break;
 
   case 174:
 
 /* Line 1464 of yacc.c  */
-#line 1232 "glsl_parser.ypp"
+#line 1226 "glsl_parser.ypp"
     { (yyval.n) = ast_vec2; ;}
     break;
 
   case 175:
 
 /* Line 1464 of yacc.c  */
-#line 1233 "glsl_parser.ypp"
+#line 1227 "glsl_parser.ypp"
     { (yyval.n) = ast_vec3; ;}
     break;
 
   case 176:
 
 /* Line 1464 of yacc.c  */
-#line 1234 "glsl_parser.ypp"
+#line 1228 "glsl_parser.ypp"
     { (yyval.n) = ast_vec4; ;}
     break;
 
   case 177:
 
 /* Line 1464 of yacc.c  */
-#line 1235 "glsl_parser.ypp"
+#line 1229 "glsl_parser.ypp"
     { (yyval.n) = ast_bvec2; ;}
     break;
 
   case 178:
 
 /* Line 1464 of yacc.c  */
-#line 1236 "glsl_parser.ypp"
+#line 1230 "glsl_parser.ypp"
     { (yyval.n) = ast_bvec3; ;}
     break;
 
   case 179:
 
 /* Line 1464 of yacc.c  */
-#line 1237 "glsl_parser.ypp"
+#line 1231 "glsl_parser.ypp"
     { (yyval.n) = ast_bvec4; ;}
     break;
 
   case 180:
 
 /* Line 1464 of yacc.c  */
-#line 1238 "glsl_parser.ypp"
+#line 1232 "glsl_parser.ypp"
     { (yyval.n) = ast_ivec2; ;}
     break;
 
   case 181:
 
 /* Line 1464 of yacc.c  */
-#line 1239 "glsl_parser.ypp"
+#line 1233 "glsl_parser.ypp"
     { (yyval.n) = ast_ivec3; ;}
     break;
 
   case 182:
 
 /* Line 1464 of yacc.c  */
-#line 1240 "glsl_parser.ypp"
+#line 1234 "glsl_parser.ypp"
     { (yyval.n) = ast_ivec4; ;}
     break;
 
   case 183:
 
 /* Line 1464 of yacc.c  */
-#line 1241 "glsl_parser.ypp"
+#line 1235 "glsl_parser.ypp"
     { (yyval.n) = ast_uvec2; ;}
     break;
 
   case 184:
 
 /* Line 1464 of yacc.c  */
-#line 1242 "glsl_parser.ypp"
+#line 1236 "glsl_parser.ypp"
     { (yyval.n) = ast_uvec3; ;}
     break;
 
   case 185:
 
 /* Line 1464 of yacc.c  */
-#line 1243 "glsl_parser.ypp"
+#line 1237 "glsl_parser.ypp"
     { (yyval.n) = ast_uvec4; ;}
     break;
 
   case 186:
 
 /* Line 1464 of yacc.c  */
-#line 1244 "glsl_parser.ypp"
+#line 1238 "glsl_parser.ypp"
     { (yyval.n) = ast_mat2; ;}
     break;
 
   case 187:
 
 /* Line 1464 of yacc.c  */
-#line 1245 "glsl_parser.ypp"
+#line 1239 "glsl_parser.ypp"
     { (yyval.n) = ast_mat2x3; ;}
     break;
 
   case 188:
 
 /* Line 1464 of yacc.c  */
-#line 1246 "glsl_parser.ypp"
+#line 1240 "glsl_parser.ypp"
     { (yyval.n) = ast_mat2x4; ;}
     break;
 
   case 189:
 
 /* Line 1464 of yacc.c  */
-#line 1247 "glsl_parser.ypp"
+#line 1241 "glsl_parser.ypp"
     { (yyval.n) = ast_mat3x2; ;}
     break;
 
   case 190:
 
 /* Line 1464 of yacc.c  */
-#line 1248 "glsl_parser.ypp"
+#line 1242 "glsl_parser.ypp"
     { (yyval.n) = ast_mat3; ;}
     break;
 
   case 191:
 
 /* Line 1464 of yacc.c  */
-#line 1249 "glsl_parser.ypp"
+#line 1243 "glsl_parser.ypp"
     { (yyval.n) = ast_mat3x4; ;}
     break;
 
   case 192:
 
 /* Line 1464 of yacc.c  */
-#line 1250 "glsl_parser.ypp"
+#line 1244 "glsl_parser.ypp"
     { (yyval.n) = ast_mat4x2; ;}
     break;
 
   case 193:
 
 /* Line 1464 of yacc.c  */
-#line 1251 "glsl_parser.ypp"
+#line 1245 "glsl_parser.ypp"
     { (yyval.n) = ast_mat4x3; ;}
     break;
 
   case 194:
 
 /* Line 1464 of yacc.c  */
-#line 1252 "glsl_parser.ypp"
+#line 1246 "glsl_parser.ypp"
     { (yyval.n) = ast_mat4; ;}
     break;
 
   case 195:
 
 /* Line 1464 of yacc.c  */
-#line 1253 "glsl_parser.ypp"
+#line 1247 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler1d; ;}
     break;
 
   case 196:
 
 /* Line 1464 of yacc.c  */
-#line 1254 "glsl_parser.ypp"
+#line 1248 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler2d; ;}
     break;
 
   case 197:
 
 /* Line 1464 of yacc.c  */
-#line 1255 "glsl_parser.ypp"
+#line 1249 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler2drect; ;}
     break;
 
   case 198:
 
 /* Line 1464 of yacc.c  */
-#line 1256 "glsl_parser.ypp"
+#line 1250 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler3d; ;}
     break;
 
   case 199:
 
 /* Line 1464 of yacc.c  */
-#line 1257 "glsl_parser.ypp"
+#line 1251 "glsl_parser.ypp"
     { (yyval.n) = ast_samplercube; ;}
     break;
 
   case 200:
 
 /* Line 1464 of yacc.c  */
-#line 1258 "glsl_parser.ypp"
+#line 1252 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler1dshadow; ;}
     break;
 
   case 201:
 
 /* Line 1464 of yacc.c  */
-#line 1259 "glsl_parser.ypp"
+#line 1253 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler2dshadow; ;}
     break;
 
   case 202:
 
 /* Line 1464 of yacc.c  */
-#line 1260 "glsl_parser.ypp"
+#line 1254 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler2drectshadow; ;}
     break;
 
   case 203:
 
 /* Line 1464 of yacc.c  */
-#line 1261 "glsl_parser.ypp"
+#line 1255 "glsl_parser.ypp"
     { (yyval.n) = ast_samplercubeshadow; ;}
     break;
 
   case 204:
 
 /* Line 1464 of yacc.c  */
-#line 1262 "glsl_parser.ypp"
+#line 1256 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler1darray; ;}
     break;
 
   case 205:
 
 /* Line 1464 of yacc.c  */
-#line 1263 "glsl_parser.ypp"
+#line 1257 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler2darray; ;}
     break;
 
   case 206:
 
 /* Line 1464 of yacc.c  */
-#line 1264 "glsl_parser.ypp"
+#line 1258 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler1darrayshadow; ;}
     break;
 
   case 207:
 
 /* Line 1464 of yacc.c  */
-#line 1265 "glsl_parser.ypp"
+#line 1259 "glsl_parser.ypp"
     { (yyval.n) = ast_sampler2darrayshadow; ;}
     break;
 
   case 208:
 
 /* Line 1464 of yacc.c  */
-#line 1266 "glsl_parser.ypp"
+#line 1260 "glsl_parser.ypp"
     { (yyval.n) = ast_isampler1d; ;}
     break;
 
   case 209:
 
 /* Line 1464 of yacc.c  */
-#line 1267 "glsl_parser.ypp"
+#line 1261 "glsl_parser.ypp"
     { (yyval.n) = ast_isampler2d; ;}
     break;
 
   case 210:
 
 /* Line 1464 of yacc.c  */
-#line 1268 "glsl_parser.ypp"
+#line 1262 "glsl_parser.ypp"
     { (yyval.n) = ast_isampler3d; ;}
     break;
 
   case 211:
 
 /* Line 1464 of yacc.c  */
-#line 1269 "glsl_parser.ypp"
+#line 1263 "glsl_parser.ypp"
     { (yyval.n) = ast_isamplercube; ;}
     break;
 
   case 212:
 
 /* Line 1464 of yacc.c  */
-#line 1270 "glsl_parser.ypp"
+#line 1264 "glsl_parser.ypp"
     { (yyval.n) = ast_isampler1darray; ;}
     break;
 
   case 213:
 
 /* Line 1464 of yacc.c  */
-#line 1271 "glsl_parser.ypp"
+#line 1265 "glsl_parser.ypp"
     { (yyval.n) = ast_isampler2darray; ;}
     break;
 
   case 214:
 
 /* Line 1464 of yacc.c  */
-#line 1272 "glsl_parser.ypp"
+#line 1266 "glsl_parser.ypp"
     { (yyval.n) = ast_usampler1d; ;}
     break;
 
   case 215:
 
 /* Line 1464 of yacc.c  */
-#line 1273 "glsl_parser.ypp"
+#line 1267 "glsl_parser.ypp"
     { (yyval.n) = ast_usampler2d; ;}
     break;
 
   case 216:
 
 /* Line 1464 of yacc.c  */
-#line 1274 "glsl_parser.ypp"
+#line 1268 "glsl_parser.ypp"
     { (yyval.n) = ast_usampler3d; ;}
     break;
 
   case 217:
 
 /* Line 1464 of yacc.c  */
-#line 1275 "glsl_parser.ypp"
+#line 1269 "glsl_parser.ypp"
     { (yyval.n) = ast_usamplercube; ;}
     break;
 
   case 218:
 
 /* Line 1464 of yacc.c  */
-#line 1276 "glsl_parser.ypp"
+#line 1270 "glsl_parser.ypp"
     { (yyval.n) = ast_usampler1darray; ;}
     break;
 
   case 219:
 
 /* Line 1464 of yacc.c  */
-#line 1277 "glsl_parser.ypp"
+#line 1271 "glsl_parser.ypp"
     { (yyval.n) = ast_usampler2darray; ;}
     break;
 
   case 220:
 
 /* Line 1464 of yacc.c  */
-#line 1281 "glsl_parser.ypp"
+#line 1275 "glsl_parser.ypp"
     {
 		     if (!state->es_shader && state->language_version < 130)
 			_mesa_glsl_error(& (yylsp[(1) - (1)]), state,
@@ -4618,7 +4621,7 @@ yyreduce:
   case 221:
 
 /* Line 1464 of yacc.c  */
-#line 1292 "glsl_parser.ypp"
+#line 1286 "glsl_parser.ypp"
     {
 		     if (!state->es_shader && state->language_version < 130)
 			_mesa_glsl_error(& (yylsp[(1) - (1)]), state,
@@ -4635,7 +4638,7 @@ yyreduce:
   case 222:
 
 /* Line 1464 of yacc.c  */
-#line 1303 "glsl_parser.ypp"
+#line 1297 "glsl_parser.ypp"
     {
 		     if (!state->es_shader && state->language_version < 130)
 			_mesa_glsl_error(& (yylsp[(1) - (1)]), state,
@@ -4652,7 +4655,7 @@ yyreduce:
   case 223:
 
 /* Line 1464 of yacc.c  */
-#line 1318 "glsl_parser.ypp"
+#line 1312 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.struct_specifier) = new(ctx) ast_struct_specifier((yyvsp[(2) - (5)].identifier), (yyvsp[(4) - (5)].node));
@@ -4663,7 +4666,7 @@ yyreduce:
   case 224:
 
 /* Line 1464 of yacc.c  */
-#line 1324 "glsl_parser.ypp"
+#line 1318 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.struct_specifier) = new(ctx) ast_struct_specifier(NULL, (yyvsp[(3) - (4)].node));
@@ -4674,7 +4677,7 @@ yyreduce:
   case 225:
 
 /* Line 1464 of yacc.c  */
-#line 1333 "glsl_parser.ypp"
+#line 1327 "glsl_parser.ypp"
     {
 	   (yyval.node) = (ast_node *) (yyvsp[(1) - (1)].declarator_list);
 	   (yyvsp[(1) - (1)].declarator_list)->link.self_link();
@@ -4684,7 +4687,7 @@ yyreduce:
   case 226:
 
 /* Line 1464 of yacc.c  */
-#line 1338 "glsl_parser.ypp"
+#line 1332 "glsl_parser.ypp"
     {
 	   (yyval.node) = (ast_node *) (yyvsp[(1) - (2)].node);
 	   (yyval.node)->link.insert_before(& (yyvsp[(2) - (2)].declarator_list)->link);
@@ -4694,7 +4697,7 @@ yyreduce:
   case 227:
 
 /* Line 1464 of yacc.c  */
-#line 1346 "glsl_parser.ypp"
+#line 1340 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_fully_specified_type *type = new(ctx) ast_fully_specified_type();
@@ -4711,7 +4714,7 @@ yyreduce:
   case 228:
 
 /* Line 1464 of yacc.c  */
-#line 1361 "glsl_parser.ypp"
+#line 1355 "glsl_parser.ypp"
     {
 	   (yyval.declaration) = (yyvsp[(1) - (1)].declaration);
 	   (yyvsp[(1) - (1)].declaration)->link.self_link();
@@ -4721,7 +4724,7 @@ yyreduce:
   case 229:
 
 /* Line 1464 of yacc.c  */
-#line 1366 "glsl_parser.ypp"
+#line 1360 "glsl_parser.ypp"
     {
 	   (yyval.declaration) = (yyvsp[(1) - (3)].declaration);
 	   (yyval.declaration)->link.insert_before(& (yyvsp[(3) - (3)].declaration)->link);
@@ -4731,7 +4734,7 @@ yyreduce:
   case 230:
 
 /* Line 1464 of yacc.c  */
-#line 1374 "glsl_parser.ypp"
+#line 1368 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.declaration) = new(ctx) ast_declaration((yyvsp[(1) - (1)].identifier), false, NULL, NULL);
@@ -4742,7 +4745,7 @@ yyreduce:
   case 231:
 
 /* Line 1464 of yacc.c  */
-#line 1380 "glsl_parser.ypp"
+#line 1374 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.declaration) = new(ctx) ast_declaration((yyvsp[(1) - (4)].identifier), true, (yyvsp[(3) - (4)].expression), NULL);
@@ -4753,28 +4756,28 @@ yyreduce:
   case 234:
 
 /* Line 1464 of yacc.c  */
-#line 1398 "glsl_parser.ypp"
+#line 1392 "glsl_parser.ypp"
     { (yyval.node) = (ast_node *) (yyvsp[(1) - (1)].compound_statement); ;}
     break;
 
   case 239:
 
 /* Line 1464 of yacc.c  */
-#line 1406 "glsl_parser.ypp"
+#line 1400 "glsl_parser.ypp"
     { (yyval.node) = NULL; ;}
     break;
 
   case 240:
 
 /* Line 1464 of yacc.c  */
-#line 1407 "glsl_parser.ypp"
+#line 1401 "glsl_parser.ypp"
     { (yyval.node) = NULL; ;}
     break;
 
   case 243:
 
 /* Line 1464 of yacc.c  */
-#line 1414 "glsl_parser.ypp"
+#line 1408 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.compound_statement) = new(ctx) ast_compound_statement(true, NULL);
@@ -4785,7 +4788,7 @@ yyreduce:
   case 244:
 
 /* Line 1464 of yacc.c  */
-#line 1420 "glsl_parser.ypp"
+#line 1414 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.compound_statement) = new(ctx) ast_compound_statement(true, (yyvsp[(2) - (3)].node));
@@ -4796,14 +4799,14 @@ yyreduce:
   case 245:
 
 /* Line 1464 of yacc.c  */
-#line 1428 "glsl_parser.ypp"
+#line 1422 "glsl_parser.ypp"
     { (yyval.node) = (ast_node *) (yyvsp[(1) - (1)].compound_statement); ;}
     break;
 
   case 247:
 
 /* Line 1464 of yacc.c  */
-#line 1434 "glsl_parser.ypp"
+#line 1428 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.compound_statement) = new(ctx) ast_compound_statement(false, NULL);
@@ -4814,7 +4817,7 @@ yyreduce:
   case 248:
 
 /* Line 1464 of yacc.c  */
-#line 1440 "glsl_parser.ypp"
+#line 1434 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.compound_statement) = new(ctx) ast_compound_statement(false, (yyvsp[(2) - (3)].node));
@@ -4825,7 +4828,7 @@ yyreduce:
   case 249:
 
 /* Line 1464 of yacc.c  */
-#line 1449 "glsl_parser.ypp"
+#line 1443 "glsl_parser.ypp"
     {
 	   if ((yyvsp[(1) - (1)].node) == NULL) {
 	      _mesa_glsl_error(& (yylsp[(1) - (1)]), state, "<nil> statement\n");
@@ -4840,7 +4843,7 @@ yyreduce:
   case 250:
 
 /* Line 1464 of yacc.c  */
-#line 1459 "glsl_parser.ypp"
+#line 1453 "glsl_parser.ypp"
     {
 	   if ((yyvsp[(2) - (2)].node) == NULL) {
 	      _mesa_glsl_error(& (yylsp[(2) - (2)]), state, "<nil> statement\n");
@@ -4854,7 +4857,7 @@ yyreduce:
   case 251:
 
 /* Line 1464 of yacc.c  */
-#line 1471 "glsl_parser.ypp"
+#line 1465 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_expression_statement(NULL);
@@ -4865,7 +4868,7 @@ yyreduce:
   case 252:
 
 /* Line 1464 of yacc.c  */
-#line 1477 "glsl_parser.ypp"
+#line 1471 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_expression_statement((yyvsp[(1) - (2)].expression));
@@ -4876,7 +4879,7 @@ yyreduce:
   case 253:
 
 /* Line 1464 of yacc.c  */
-#line 1486 "glsl_parser.ypp"
+#line 1480 "glsl_parser.ypp"
     {
 	   (yyval.node) = new(state) ast_selection_statement((yyvsp[(3) - (5)].expression), (yyvsp[(5) - (5)].selection_rest_statement).then_statement,
 						   (yyvsp[(5) - (5)].selection_rest_statement).else_statement);
@@ -4887,7 +4890,7 @@ yyreduce:
   case 254:
 
 /* Line 1464 of yacc.c  */
-#line 1495 "glsl_parser.ypp"
+#line 1489 "glsl_parser.ypp"
     {
 	   (yyval.selection_rest_statement).then_statement = (yyvsp[(1) - (3)].node);
 	   (yyval.selection_rest_statement).else_statement = (yyvsp[(3) - (3)].node);
@@ -4897,7 +4900,7 @@ yyreduce:
   case 255:
 
 /* Line 1464 of yacc.c  */
-#line 1500 "glsl_parser.ypp"
+#line 1494 "glsl_parser.ypp"
     {
 	   (yyval.selection_rest_statement).then_statement = (yyvsp[(1) - (1)].node);
 	   (yyval.selection_rest_statement).else_statement = NULL;
@@ -4907,7 +4910,7 @@ yyreduce:
   case 256:
 
 /* Line 1464 of yacc.c  */
-#line 1508 "glsl_parser.ypp"
+#line 1502 "glsl_parser.ypp"
     {
 	   (yyval.node) = (ast_node *) (yyvsp[(1) - (1)].expression);
 	;}
@@ -4916,7 +4919,7 @@ yyreduce:
   case 257:
 
 /* Line 1464 of yacc.c  */
-#line 1512 "glsl_parser.ypp"
+#line 1506 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   ast_declaration *decl = new(ctx) ast_declaration((yyvsp[(2) - (4)].identifier), false, NULL, (yyvsp[(4) - (4)].expression));
@@ -4932,7 +4935,7 @@ yyreduce:
   case 261:
 
 /* Line 1464 of yacc.c  */
-#line 1535 "glsl_parser.ypp"
+#line 1529 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_iteration_statement(ast_iteration_statement::ast_while,
@@ -4944,7 +4947,7 @@ yyreduce:
   case 262:
 
 /* Line 1464 of yacc.c  */
-#line 1542 "glsl_parser.ypp"
+#line 1536 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_iteration_statement(ast_iteration_statement::ast_do_while,
@@ -4956,7 +4959,7 @@ yyreduce:
   case 263:
 
 /* Line 1464 of yacc.c  */
-#line 1549 "glsl_parser.ypp"
+#line 1543 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_iteration_statement(ast_iteration_statement::ast_for,
@@ -4968,7 +4971,7 @@ yyreduce:
   case 267:
 
 /* Line 1464 of yacc.c  */
-#line 1565 "glsl_parser.ypp"
+#line 1559 "glsl_parser.ypp"
     {
 	   (yyval.node) = NULL;
 	;}
@@ -4977,7 +4980,7 @@ yyreduce:
   case 268:
 
 /* Line 1464 of yacc.c  */
-#line 1572 "glsl_parser.ypp"
+#line 1566 "glsl_parser.ypp"
     {
 	   (yyval.for_rest_statement).cond = (yyvsp[(1) - (2)].node);
 	   (yyval.for_rest_statement).rest = NULL;
@@ -4987,7 +4990,7 @@ yyreduce:
   case 269:
 
 /* Line 1464 of yacc.c  */
-#line 1577 "glsl_parser.ypp"
+#line 1571 "glsl_parser.ypp"
     {
 	   (yyval.for_rest_statement).cond = (yyvsp[(1) - (3)].node);
 	   (yyval.for_rest_statement).rest = (yyvsp[(3) - (3)].expression);
@@ -4997,7 +5000,7 @@ yyreduce:
   case 270:
 
 /* Line 1464 of yacc.c  */
-#line 1586 "glsl_parser.ypp"
+#line 1580 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_jump_statement(ast_jump_statement::ast_continue, NULL);
@@ -5008,7 +5011,7 @@ yyreduce:
   case 271:
 
 /* Line 1464 of yacc.c  */
-#line 1592 "glsl_parser.ypp"
+#line 1586 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_jump_statement(ast_jump_statement::ast_break, NULL);
@@ -5019,7 +5022,7 @@ yyreduce:
   case 272:
 
 /* Line 1464 of yacc.c  */
-#line 1598 "glsl_parser.ypp"
+#line 1592 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_jump_statement(ast_jump_statement::ast_return, NULL);
@@ -5030,7 +5033,7 @@ yyreduce:
   case 273:
 
 /* Line 1464 of yacc.c  */
-#line 1604 "glsl_parser.ypp"
+#line 1598 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_jump_statement(ast_jump_statement::ast_return, (yyvsp[(2) - (3)].expression));
@@ -5041,7 +5044,7 @@ yyreduce:
   case 274:
 
 /* Line 1464 of yacc.c  */
-#line 1610 "glsl_parser.ypp"
+#line 1604 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.node) = new(ctx) ast_jump_statement(ast_jump_statement::ast_discard, NULL);
@@ -5052,28 +5055,28 @@ yyreduce:
   case 275:
 
 /* Line 1464 of yacc.c  */
-#line 1618 "glsl_parser.ypp"
+#line 1612 "glsl_parser.ypp"
     { (yyval.node) = (yyvsp[(1) - (1)].function_definition); ;}
     break;
 
   case 276:
 
 /* Line 1464 of yacc.c  */
-#line 1619 "glsl_parser.ypp"
+#line 1613 "glsl_parser.ypp"
     { (yyval.node) = (yyvsp[(1) - (1)].node); ;}
     break;
 
   case 277:
 
 /* Line 1464 of yacc.c  */
-#line 1620 "glsl_parser.ypp"
+#line 1614 "glsl_parser.ypp"
     { (yyval.node) = NULL; ;}
     break;
 
   case 278:
 
 /* Line 1464 of yacc.c  */
-#line 1625 "glsl_parser.ypp"
+#line 1619 "glsl_parser.ypp"
     {
 	   void *ctx = state;
 	   (yyval.function_definition) = new(ctx) ast_function_definition();
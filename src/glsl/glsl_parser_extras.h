@@ -69,6 +69,7 @@ struct _mesa_glsl_parse_state {
 
    bool es_shader;
    unsigned language_version;
+
    enum _mesa_glsl_parser_targets target;
 
    /**
@@ -22,6 +22,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdio.h>
 #include "glsl_symbol_table.h"
 
 class symbol_table_entry {
@@ -44,13 +45,15 @@ public:
       hieralloc_free(table);
    }
 
-   symbol_table_entry(ir_variable *v)                     : v(v), f(0), t(0) {}
-   symbol_table_entry(ir_function *f)                     : v(0), f(f), t(0) {}
-   symbol_table_entry(const glsl_type *t)                 : v(0), f(0), t(t) {}
+   symbol_table_entry(ir_variable *v)                     : v(v), f(0), t(0), precision(0) {}
+   symbol_table_entry(ir_function *f)                     : v(0), f(f), t(0), precision(0) {}
+   symbol_table_entry(const glsl_type *t)                 : v(0), f(0), t(t), precision(0) {}
+   symbol_table_entry(unsigned precision)                 : v(0), f(0), t(0), precision(precision) {}
 
    ir_variable *v;
    ir_function *f;
    const glsl_type *t;
+   unsigned precision;
 }; 
 
 glsl_symbol_table::glsl_symbol_table(void * ctx)
@@ -66,6 +69,11 @@ glsl_symbol_table::~glsl_symbol_table()
    //hieralloc_free(mem_ctx); parent context free will free this
 }
 
+const char *glsl_symbol_table::intern(const char *name)
+{
+   return _mesa_symbol_table_intern(table, name);
+}
+
 void glsl_symbol_table::push_scope()
 {
    _mesa_symbol_table_push_scope(table);
@@ -160,6 +168,51 @@ ir_function *glsl_symbol_table::get_function(const char *name)
    return entry != NULL ? entry->f : NULL;
 }
 
+/**
+ * Build the table name holding the default precision of \c type_name
+ *
+ * The leading '#' cannot start a GLSL identifier.
+ */
+static const char *
+default_precision_name(char *buf, size_t size, const char *type_name)
+{
+   snprintf(buf, size, "#default_precision_%s", type_name);
+   return buf;
+}
+
+void glsl_symbol_table::add_default_precision_qualifier(const char *type_name,
+							unsigned precision)
+{
+   char buf[64];
+   const char *name = default_precision_name(buf, sizeof(buf), type_name);
+
+   /* A second statement in the same block replaces the first one.
+    */
+   if (name_declared_this_scope(name)) {
+      get_entry(name)->precision = precision;
+      return;
+   }
+
+   symbol_table_entry *entry = new(mem_ctx) symbol_table_entry(precision);
+   int added = _mesa_symbol_table_add_symbol(table, -1, name, entry) == 0;
+   assert(added);
+   (void)added;
+}
+
+bool glsl_symbol_table::get_default_precision_qualifier(const char *type_name,
+							unsigned *precision)
+{
+   char buf[64];
+   symbol_table_entry *entry =
+      get_entry(default_precision_name(buf, sizeof(buf), type_name));
+
+   if (entry == NULL)
+      return false;
+
+   *precision = entry->precision;
+   return true;
+}
+
 symbol_table_entry *glsl_symbol_table::get_entry(const char *name)
 {
    return (symbol_table_entry *)
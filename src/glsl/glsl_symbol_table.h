@@ -80,6 +80,14 @@ public:
 
    unsigned int language_version;
 
+   /**
+    * Return the table's unique copy of \c name
+    *
+    * The lexer hands out interned identifiers so that every later lookup of
+    * the same name resolves by pointer.  The copy lives as long as the table.
+    */
+   const char *intern(const char *name);
+
    void push_scope();
    void pop_scope();
 
@@ -115,6 +123,20 @@ public:
    ir_function *get_function(const char *name);
    /*@}*/
 
+   /**
+    * \name Default precision qualifiers
+    *
+    * A \c precision statement lasts until the end of the block it appears
+    * in, so the defaults are kept in the table and leave with the scope.
+    * They are stored under names that cannot clash with an identifier.
+    */
+   /*@{*/
+   void add_default_precision_qualifier(const char *type_name,
+					unsigned precision);
+   bool get_default_precision_qualifier(const char *type_name,
+					unsigned *precision);
+   /*@}*/
+
 private:
    symbol_table_entry *get_entry(const char *name);
 
@@ -23,6 +23,7 @@
 
 #include <cstdio>
 #include <stdlib.h>
+#include <stdint.h>
 #include "main/core.h" /* for Elements */
 #include "glsl_symbol_table.h"
 #include "glsl_parser_extras.h"
@@ -333,28 +334,54 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns)
 }
 
 
+/* Fold a word into a running key hash.  The hash table scrambles the result,
+ * so this only has to keep every input bit.
+ */
+static inline unsigned
+key_hash_add(unsigned hash, uintptr_t word)
+{
+   return (hash ^ (unsigned) word ^ (unsigned) (word >> 16 >> 16)) * 31u;
+}
+
+
+int
+glsl_type::array_key_compare(const void *a, const void *b)
+{
+   const array_key *const key1 = (const array_key *) a;
+   const array_key *const key2 = (const array_key *) b;
+
+   return (key1->base != key2->base) || (key1->size != key2->size);
+}
+
+
+unsigned
+glsl_type::array_key_hash(const void *a)
+{
+   const array_key *const key = (const array_key *) a;
+
+   return key_hash_add(key->size, (uintptr_t) key->base);
+}
+
+
 const glsl_type *
 glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 {
 
    if (array_types == NULL) {
-      array_types = hash_table_ctor(64, hash_table_string_hash,
-				    hash_table_string_compare);
+      array_types = hash_table_ctor(64, array_key_hash, array_key_compare);
    }
 
-   /* Generate a name using the base type pointer in the key.  This is
-    * done because the name of the base type may not be unique across
-    * shaders.  For example, two shaders may have different record types
-    * named 'foo'.
-    */
-   char key[128];
-   snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
+   array_key key;
+   key.base = base;
+   key.size = array_size;
 
-   const glsl_type *t = (glsl_type *) hash_table_find(array_types, key);
+   const glsl_type *t = (glsl_type *) hash_table_find(array_types, & key);
    if (t == NULL) {
       t = new glsl_type(base, array_size);
 
-      hash_table_insert(array_types, (void *) t, hieralloc_strdup(mem_ctx, key));
+      array_key *const k = hieralloc(mem_ctx, array_key);
+      *k = key;
+      hash_table_insert(array_types, (void *) t, k);
    }
 
    assert(t->base_type == GLSL_TYPE_ARRAY);
@@ -368,23 +395,25 @@ glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 int
 glsl_type::record_key_compare(const void *a, const void *b)
 {
-   const glsl_type *const key1 = (glsl_type *) a;
-   const glsl_type *const key2 = (glsl_type *) b;
+   const record_key *const key1 = (const record_key *) a;
+   const record_key *const key2 = (const record_key *) b;
 
    /* Return zero is the types match (there is zero difference) or non-zero
     * otherwise.
     */
-   if (strcmp(key1->name, key2->name) != 0)
+   if (key1->num_fields != key2->num_fields)
       return 1;
 
-   if (key1->length != key2->length)
+   for (unsigned i = 0; i < key1->num_fields; i++) {
+      if (key1->fields[i].type != key2->fields[i].type)
+	 return 1;
+   }
+
+   if (strcmp(key1->name, key2->name) != 0)
       return 1;
 
-   for (unsigned i = 0; i < key1->length; i++) {
-      if (key1->fields.structure[i].type != key2->fields.structure[i].type)
-	 return 1;
-      if (strcmp(key1->fields.structure[i].name,
-		 key2->fields.structure[i].name) != 0)
+   for (unsigned i = 0; i < key1->num_fields; i++) {
+      if (strcmp(key1->fields[i].name, key2->fields[i].name) != 0)
 	 return 1;
    }
 
@@ -395,21 +424,13 @@ glsl_type::record_key_compare(const void *a, const void *b)
 unsigned
 glsl_type::record_key_hash(const void *a)
 {
-   const glsl_type *const key = (glsl_type *) a;
-   char hash_key[128];
-   unsigned size = 0;
-
-   size = snprintf(hash_key, sizeof(hash_key), "%08x", key->length);
+   const record_key *const key = (const record_key *) a;
+   unsigned hash = key->num_fields;
 
-   for (unsigned i = 0; i < key->length; i++) {
-      if (size >= sizeof(hash_key))
-	 break;
-
-      size += snprintf(& hash_key[size], sizeof(hash_key) - size,
-		       "%p", (void *) key->fields.structure[i].type);
-   }
+   for (unsigned i = 0; i < key->num_fields; i++)
+      hash = key_hash_add(hash, (uintptr_t) key->fields[i].type);
 
-   return hash_table_string_hash(& hash_key);
+   return hash;
 }
 
 
@@ -418,7 +439,10 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
 			       unsigned num_fields,
 			       const char *name)
 {
-   const glsl_type key(fields, num_fields, name);
+   record_key key;
+   key.fields = fields;
+   key.num_fields = num_fields;
+   key.name = name;
 
    if (record_types == NULL) {
       record_types = hash_table_ctor(64, record_key_hash, record_key_compare);
@@ -428,7 +452,12 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
    if (t == NULL) {
       t = new glsl_type(fields, num_fields, name);
 
-      hash_table_insert(record_types, (void *) t, t);
+      /* The stored key refers to the type's own copies of the fields. */
+      record_key *const k = hieralloc(mem_ctx, record_key);
+      k->fields = t->fields.structure;
+      k->num_fields = t->length;
+      k->name = t->name;
+      hash_table_insert(record_types, (void *) t, k);
    }
 
    assert(t->base_type == GLSL_TYPE_STRUCT);
@@ -439,6 +468,42 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
 }
 
 
+const glsl_type *
+glsl_type::get_sampler_instance(enum glsl_sampler_dim dim, bool shadow,
+				bool array, unsigned type)
+{
+   static const struct {
+      const glsl_type *types;
+      unsigned num_types;
+   } tables[] = {
+      { builtin_core_types, Elements(builtin_core_types) },
+      { builtin_110_types, Elements(builtin_110_types) },
+      { builtin_130_types, Elements(builtin_130_types) },
+      { builtin_ARB_texture_rectangle_types,
+	Elements(builtin_ARB_texture_rectangle_types) },
+      { builtin_EXT_texture_array_types,
+	Elements(builtin_EXT_texture_array_types) },
+      { builtin_EXT_texture_buffer_object_types,
+	Elements(builtin_EXT_texture_buffer_object_types) },
+   };
+
+   for (unsigned i = 0; i < Elements(tables); i++) {
+      for (unsigned j = 0; j < tables[i].num_types; j++) {
+	 const glsl_type *const t = &tables[i].types[j];
+
+	 if (t->base_type == GLSL_TYPE_SAMPLER
+	     && t->sampler_dimensionality == dim
+	     && t->sampler_shadow == shadow
+	     && t->sampler_array == array
+	     && t->sampler_type == type)
+	    return t;
+      }
+   }
+
+   return error_type;
+}
+
+
 const glsl_type *
 glsl_type::field_type(const char *name) const
 {
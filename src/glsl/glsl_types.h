@@ -206,6 +206,13 @@ struct glsl_type {
 					       unsigned num_fields,
 					       const char *name);
 
+   /**
+    * Get the instance of a built-in sampler type
+    */
+   static const glsl_type *get_sampler_instance(enum glsl_sampler_dim dim,
+						bool shadow, bool array,
+						unsigned type);
+
    /**
     * Query the total number of scalars that make up a scalar, vector or matrix
     */
@@ -416,6 +423,28 @@ private:
    /** Hash table containing the known record types. */
    static struct hash_table *record_types;
 
+   /**
+    * Key of \c array_types
+    *
+    * The base type pointer is used rather than its name because the name of
+    * the base type may not be unique across shaders.  For example, two
+    * shaders may have different record types named 'foo'.
+    */
+   struct array_key {
+      const glsl_type *base;
+      unsigned size;
+   };
+
+   /** Key of \c record_types, built over the caller's fields on lookup */
+   struct record_key {
+      const glsl_struct_field *fields;
+      unsigned num_fields;
+      const char *name;
+   };
+
+   static int array_key_compare(const void *a, const void *b);
+   static unsigned array_key_hash(const void *key);
+
    static int record_key_compare(const void *a, const void *b);
    static unsigned record_key_hash(const void *key);
 
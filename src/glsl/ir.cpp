@@ -1266,13 +1266,15 @@ ir_swizzle::variable_referenced()
 ir_variable::ir_variable(const struct glsl_type *type, const char *name,
 			 ir_variable_mode mode)
    : max_array_access(0), read_only(false), centroid(false), invariant(false),
-     mode(mode), interpolation(ir_var_smooth), array_lvalue(false)
+     mode(mode), interpolation(ir_var_smooth), precision(ir_precision_undefined),
+     array_lvalue(false)
 {
    this->ir_type = ir_type_variable;
    this->type = type;
    this->name = hieralloc_strdup(this, name);
    this->explicit_location = false;
    this->location = -1;
+   this->location_frac = 0;
    this->warn_extension = NULL;
    this->constant_value = NULL;
    this->origin_upper_left = false;
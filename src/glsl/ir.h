@@ -238,6 +238,13 @@ enum ir_variable_interpolation {
    ir_var_noperspective
 };
 
+enum ir_variable_precision {
+   ir_precision_undefined = 0, /**< Compiler temporaries, follows the values assigned. */
+   ir_precision_high,
+   ir_precision_medium,
+   ir_precision_low
+};
+
 
 class ir_variable : public ir_instruction {
 public:
@@ -312,6 +319,13 @@ public:
     */
    unsigned interpolation:2;
 
+   /**
+    * GLSL ES precision qualifier, explicit or from the default precision
+    *
+    * \sa ir_variable_precision
+    */
+   unsigned precision:2;
+
    /**
     * Flag that the whole array is assignable
     *
@@ -354,6 +368,14 @@ public:
     */
    int location;
 
+   /**
+    * First component of \c location used by this variable
+    *
+    * Non-zero only for varyings that the linker packed into a vec4 slot
+    * shared with other varyings.
+    */
+   unsigned location_frac:2;
+
    /**
     * Emit a warning if this variable is accessed.
     */
@@ -1572,6 +1594,12 @@ visit_exec_list(exec_list *list, ir_visitor *visitor);
  */
 void validate_ir_tree(exec_list *instructions);
 
+/**
+ * Validate invariants like validate_ir_tree, but return false instead of
+ * aborting, for IR that was not produced by the compiler
+ */
+bool ir_tree_is_valid(exec_list *instructions);
+
 /**
  * Make a clone of each IR instruction in a list
  *
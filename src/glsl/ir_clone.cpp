@@ -47,8 +47,10 @@ ir_variable::clone(void *mem_ctx, struct hash_table *ht) const
    var->centroid = this->centroid;
    var->invariant = this->invariant;
    var->interpolation = this->interpolation;
+   var->precision = this->precision;
    var->array_lvalue = this->array_lvalue;
    var->location = this->location;
+   var->location_frac = this->location_frac;
    var->warn_extension = this->warn_extension;
    var->origin_upper_left = this->origin_upper_left;
    var->pixel_center_integer = this->pixel_center_integer;
@@ -0,0 +1,1002 @@
+/**
+ **
+ ** Copyright 2011, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+/**
+ * \file ir_serialize.cpp
+ *
+ * Compact binary encoding of linked IR for program binaries.
+ *
+ * A shader is written as its function headers (so calls can refer to
+ * signatures defined later), its global variables, and then the top level
+ * instruction list.  Variables and signatures are referred to by the index
+ * in which they were declared.  Each node starts with its \c ir_node_type;
+ * \c ir_type_unset stands for an absent optional rvalue.
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include "ir.h"
+#include "ir_serialize.h"
+#include "glsl_types.h"
+extern "C" {
+#include "program/hash_table.h"
+}
+
+ir_blob_writer::ir_blob_writer(void *mem_ctx)
+   : data(NULL), size(0), failed(false), mem_ctx(mem_ctx), capacity(0)
+{
+}
+
+void
+ir_blob_writer::write_bytes(const void *bytes, unsigned count)
+{
+   if (failed)
+      return;
+
+   if (size + count > capacity) {
+      unsigned grow = capacity * 2 > size + count ? capacity * 2 : size + count + 256;
+      char *grown = hieralloc_realloc(mem_ctx, data, char, grow);
+      if (!grown) {
+	 failed = true;
+	 return;
+      }
+      data = grown;
+      capacity = grow;
+   }
+   memcpy(data + size, bytes, count);
+   size += count;
+}
+
+void
+ir_blob_writer::write_uint(unsigned value)
+{
+   unsigned char bytes[5];
+   unsigned count = 0;
+
+   do {
+      bytes[count] = value & 0x7f;
+      value >>= 7;
+      if (value)
+	 bytes[count] |= 0x80;
+      count++;
+   } while (value);
+   write_bytes(bytes, count);
+}
+
+void
+ir_blob_writer::write_int(int value)
+{
+   /* zigzag, so small negative locations stay one byte */
+   write_uint(((unsigned) value << 1) ^ (unsigned) (value >> 31));
+}
+
+void
+ir_blob_writer::write_string(const char *str)
+{
+   if (str == NULL) {
+      write_uint(0);
+      return;
+   }
+
+   const unsigned length = strlen(str) + 1;
+   write_uint(length);
+   write_bytes(str, length);
+}
+
+void
+ir_blob_writer::write_type(const glsl_type *type)
+{
+   write_uint(type->base_type);
+
+   switch (type->base_type) {
+   case GLSL_TYPE_SAMPLER:
+      write_uint(type->sampler_dimensionality);
+      write_uint(type->sampler_shadow);
+      write_uint(type->sampler_array);
+      write_uint(type->sampler_type);
+      break;
+   case GLSL_TYPE_ARRAY:
+      write_uint(type->length);
+      write_type(type->fields.array);
+      break;
+   case GLSL_TYPE_STRUCT:
+      write_string(type->name);
+      write_uint(type->length);
+      for (unsigned i = 0; i < type->length; i++) {
+	 write_string(type->fields.structure[i].name);
+	 write_type(type->fields.structure[i].type);
+      }
+      break;
+   default:
+      write_uint(type->vector_elements);
+      write_uint(type->matrix_columns);
+      break;
+   }
+}
+
+
+ir_blob_reader::ir_blob_reader(const void *data, unsigned size)
+   : failed(false), pos((const unsigned char *) data),
+     end((const unsigned char *) data + size), type_depth(0)
+{
+}
+
+bool
+ir_blob_reader::read_bytes(void *dst, unsigned count)
+{
+   if (failed || count > remaining()) {
+      failed = true;
+      memset(dst, 0, count);
+      return false;
+   }
+   memcpy(dst, pos, count);
+   pos += count;
+   return true;
+}
+
+unsigned
+ir_blob_reader::read_uint()
+{
+   unsigned value = 0;
+
+   for (unsigned shift = 0; shift < 35; shift += 7) {
+      if (failed || pos == end) {
+	 failed = true;
+	 return 0;
+      }
+      const unsigned char byte = *pos++;
+      value |= (unsigned) (byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+	 return value;
+   }
+
+   failed = true;
+   return 0;
+}
+
+int
+ir_blob_reader::read_int()
+{
+   const unsigned value = read_uint();
+   return (int) (value >> 1) ^ -(int) (value & 1);
+}
+
+const char *
+ir_blob_reader::read_string()
+{
+   const unsigned length = read_uint();
+
+   if (failed || length == 0)
+      return NULL;
+
+   if (length > remaining() || pos[length - 1] != '\0') {
+      failed = true;
+      return NULL;
+   }
+
+   const char *str = (const char *) pos;
+   pos += length;
+   return str;
+}
+
+const glsl_type *
+ir_blob_reader::read_type()
+{
+   const unsigned base_type = read_uint();
+
+   switch (base_type) {
+   case GLSL_TYPE_SAMPLER: {
+      const unsigned dim = read_uint();
+      const unsigned shadow = read_uint();
+      const unsigned array = read_uint();
+      const unsigned sampler_type = read_uint();
+      const glsl_type *type =
+	 glsl_type::get_sampler_instance((glsl_sampler_dim) dim, shadow, array,
+					 sampler_type);
+      if (type->is_error())
+	 failed = true;
+      return type;
+   }
+   case GLSL_TYPE_ARRAY: {
+      const unsigned length = read_uint();
+      if (type_depth >= max_type_depth) {
+	 failed = true;
+	 return glsl_type::error_type;
+      }
+      type_depth++;
+      const glsl_type *element = read_type();
+      type_depth--;
+      if (failed)
+	 return glsl_type::error_type;
+      return glsl_type::get_array_instance(element, length);
+   }
+   case GLSL_TYPE_STRUCT: {
+      const char *name = read_string();
+      const unsigned length = read_uint();
+      /* each field takes at least two bytes */
+      if (failed || name == NULL || length > remaining() / 2
+	  || type_depth >= max_type_depth) {
+	 failed = true;
+	 return glsl_type::error_type;
+      }
+
+      glsl_struct_field *fields = hieralloc_array(NULL, glsl_struct_field, length);
+      for (unsigned i = 0; i < length; i++) {
+	 fields[i].name = read_string();
+	 type_depth++;
+	 fields[i].type = read_type();
+	 type_depth--;
+	 if (fields[i].name == NULL)
+	    failed = true;
+      }
+
+      const glsl_type *type = glsl_type::error_type;
+      if (!failed)
+	 type = glsl_type::get_record_instance(fields, length, name);
+      hieralloc_free(fields);
+      return type;
+   }
+   default: {
+      const unsigned rows = read_uint();
+      const unsigned columns = read_uint();
+      if (base_type == GLSL_TYPE_ERROR || base_type > GLSL_TYPE_ERROR) {
+	 failed = true;
+	 return glsl_type::error_type;
+      }
+      const glsl_type *type = glsl_type::get_instance(base_type, rows, columns);
+      if (type->is_error())
+	 failed = true;
+      return type;
+   }
+   }
+}
+
+
+namespace {
+
+class ir_serializer {
+public:
+   ir_serializer(ir_blob_writer *blob)
+      : blob(blob), failed(false), num_variables(0), num_signatures(0)
+   {
+      variables = hash_table_ctor(32, hash_table_pointer_hash,
+				  hash_table_pointer_compare);
+      signatures = hash_table_ctor(32, hash_table_pointer_hash,
+				   hash_table_pointer_compare);
+   }
+
+   ~ir_serializer()
+   {
+      hash_table_dtor(variables);
+      hash_table_dtor(signatures);
+   }
+
+   void write_shader(exec_list *instructions);
+
+   ir_blob_writer *blob;
+   bool failed;
+
+private:
+   void declare_variable(ir_variable *var);
+   void write_variable_ref(ir_variable *var);
+   void write_list(exec_list *list);
+   void write_instruction(ir_instruction *ir);
+   void write_rvalue(ir_rvalue *ir);
+   void write_constant(ir_constant *constant);
+
+   /* indices are stored plus one so that 0 means not found */
+   struct hash_table *variables;
+   struct hash_table *signatures;
+   unsigned num_variables;
+   unsigned num_signatures;
+};
+
+void
+ir_serializer::declare_variable(ir_variable *var)
+{
+   hash_table_insert(variables, (void *) (uintptr_t) ++num_variables, var);
+
+   blob->write_string(var->name);
+   blob->write_type(var->type);
+   blob->write_uint(var->mode);
+   blob->write_uint(var->interpolation);
+   blob->write_uint(var->precision);
+   blob->write_uint(var->read_only | var->centroid << 1 | var->invariant << 2
+		    | var->array_lvalue << 3 | var->origin_upper_left << 4
+		    | var->pixel_center_integer << 5
+		    | var->explicit_location << 6
+		    | var->location_frac << 7);
+   blob->write_int(var->location);
+   blob->write_uint(var->max_array_access);
+   write_rvalue(var->constant_value);
+}
+
+void
+ir_serializer::write_variable_ref(ir_variable *var)
+{
+   const unsigned index = (uintptr_t) hash_table_find(variables, var);
+   if (index == 0)
+      failed = true;
+   blob->write_uint(index);
+}
+
+void
+ir_serializer::write_list(exec_list *list)
+{
+   unsigned count = 0;
+   foreach_list(node, list)
+      count++;
+
+   blob->write_uint(count);
+   foreach_list(node, list)
+      write_instruction((ir_instruction *) node);
+}
+
+void
+ir_serializer::write_constant(ir_constant *constant)
+{
+   blob->write_type(constant->type);
+
+   if (constant->type->is_array()) {
+      for (unsigned i = 0; i < constant->type->length; i++)
+	 write_constant(constant->array_elements[i]);
+   } else if (constant->type->is_record()) {
+      foreach_list(node, &constant->components)
+	 write_constant((ir_constant *) node);
+   } else {
+      blob->write_bytes(&constant->value,
+			constant->type->components() * sizeof(constant->value.u[0]));
+   }
+}
+
+void
+ir_serializer::write_rvalue(ir_rvalue *ir)
+{
+   if (ir == NULL) {
+      blob->write_uint(ir_type_unset);
+      return;
+   }
+   write_instruction(ir);
+}
+
+void
+ir_serializer::write_instruction(ir_instruction *ir)
+{
+   blob->write_uint(ir->ir_type);
+
+   switch (ir->ir_type) {
+   case ir_type_variable:
+      declare_variable((ir_variable *) ir);
+      break;
+   case ir_type_assignment: {
+      ir_assignment *assign = (ir_assignment *) ir;
+      write_rvalue(assign->lhs);
+      write_rvalue(assign->rhs);
+      write_rvalue(assign->condition);
+      blob->write_uint(assign->write_mask);
+      break;
+   }
+   case ir_type_call: {
+      ir_call *call = (ir_call *) ir;
+      const unsigned index = (uintptr_t) hash_table_find(signatures,
+							 call->get_callee());
+      if (index == 0)
+	 failed = true;
+      blob->write_uint(index);
+      write_list(&call->actual_parameters);
+      break;
+   }
+   case ir_type_constant:
+      write_constant((ir_constant *) ir);
+      break;
+   case ir_type_dereference_array: {
+      ir_dereference_array *deref = (ir_dereference_array *) ir;
+      write_rvalue(deref->array);
+      write_rvalue(deref->array_index);
+      break;
+   }
+   case ir_type_dereference_record: {
+      ir_dereference_record *deref = (ir_dereference_record *) ir;
+      write_rvalue(deref->record);
+      blob->write_string(deref->field);
+      break;
+   }
+   case ir_type_dereference_variable:
+      write_variable_ref(((ir_dereference_variable *) ir)->var);
+      break;
+   case ir_type_discard:
+      write_rvalue(((ir_discard *) ir)->condition);
+      break;
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      const unsigned num_operands = expr->get_num_operands();
+      blob->write_uint(expr->operation);
+      blob->write_type(expr->type);
+      blob->write_uint(num_operands);
+      for (unsigned i = 0; i < num_operands; i++)
+	 write_rvalue(expr->operands[i]);
+      break;
+   }
+   case ir_type_function: {
+      /* headers and parameters were written by write_shader */
+      ir_function *func = (ir_function *) ir;
+      foreach_list(node, &func->signatures)
+	 write_list(&((ir_function_signature *) node)->body);
+      break;
+   }
+   case ir_type_if: {
+      ir_if *iif = (ir_if *) ir;
+      write_rvalue(iif->condition);
+      write_list(&iif->then_instructions);
+      write_list(&iif->else_instructions);
+      break;
+   }
+   case ir_type_loop: {
+      ir_loop *loop = (ir_loop *) ir;
+      write_list(&loop->body_instructions);
+      write_rvalue(loop->from);
+      write_rvalue(loop->to);
+      write_rvalue(loop->increment);
+      if (loop->counter)
+	 write_variable_ref(loop->counter);
+      else
+	 blob->write_uint(0);
+      blob->write_int(loop->cmp);
+      break;
+   }
+   case ir_type_loop_jump:
+      blob->write_uint(((ir_loop_jump *) ir)->mode);
+      break;
+   case ir_type_return:
+      write_rvalue(((ir_return *) ir)->value);
+      break;
+   case ir_type_swizzle: {
+      ir_swizzle *swiz = (ir_swizzle *) ir;
+      write_rvalue(swiz->val);
+      blob->write_uint(swiz->mask.x | swiz->mask.y << 2 | swiz->mask.z << 4
+		       | swiz->mask.w << 6 | swiz->mask.num_components << 8);
+      break;
+   }
+   case ir_type_texture: {
+      ir_texture *tex = (ir_texture *) ir;
+      blob->write_uint(tex->op);
+      blob->write_type(tex->type);
+      write_rvalue(tex->sampler);
+      write_rvalue(tex->coordinate);
+      write_rvalue(tex->projector);
+      write_rvalue(tex->shadow_comparitor);
+      for (unsigned i = 0; i < 3; i++)
+	 blob->write_int(tex->offsets[i]);
+      switch (tex->op) {
+      case ir_tex:
+	 break;
+      case ir_txb:
+	 write_rvalue(tex->lod_info.bias);
+	 break;
+      case ir_txl:
+      case ir_txf:
+	 write_rvalue(tex->lod_info.lod);
+	 break;
+      case ir_txd:
+	 write_rvalue(tex->lod_info.grad.dPdx);
+	 write_rvalue(tex->lod_info.grad.dPdy);
+	 break;
+      }
+      break;
+   }
+   default:
+      failed = true;
+      break;
+   }
+}
+
+void
+ir_serializer::write_shader(exec_list *instructions)
+{
+   unsigned num_functions = 0, num_globals = 0;
+   foreach_list(node, instructions) {
+      ir_instruction *const ir = (ir_instruction *) node;
+      num_functions += ir->ir_type == ir_type_function;
+      num_globals += ir->ir_type == ir_type_variable;
+   }
+
+   blob->write_uint(num_functions);
+   foreach_list(node, instructions) {
+      ir_function *const func = ((ir_instruction *) node)->as_function();
+      if (func == NULL)
+	 continue;
+
+      unsigned num_sigs = 0;
+      foreach_list(sig_node, &func->signatures)
+	 num_sigs++;
+
+      blob->write_string(func->name);
+      blob->write_uint(num_sigs);
+      foreach_list(sig_node, &func->signatures) {
+	 ir_function_signature *const sig = (ir_function_signature *) sig_node;
+	 hash_table_insert(signatures, (void *) (uintptr_t) ++num_signatures, sig);
+
+	 blob->write_type(sig->return_type);
+	 blob->write_uint(sig->is_defined | sig->is_builtin << 1);
+	 write_list(&sig->parameters);
+      }
+   }
+
+   blob->write_uint(num_globals);
+   foreach_list(node, instructions) {
+      ir_variable *const var = ((ir_instruction *) node)->as_variable();
+      if (var != NULL)
+	 declare_variable(var);
+   }
+
+   /* top level variables and functions are only referred to by index */
+   unsigned count = 0;
+   foreach_list(node, instructions)
+      count++;
+   blob->write_uint(count);
+
+   unsigned function = 0, global = 0;
+   foreach_list(node, instructions) {
+      ir_instruction *const ir = (ir_instruction *) node;
+      if (ir->ir_type == ir_type_variable) {
+	 blob->write_uint(ir_type_variable);
+	 blob->write_uint(global++);
+      } else if (ir->ir_type == ir_type_function) {
+	 blob->write_uint(ir_type_function);
+	 blob->write_uint(function++);
+	 foreach_list(sig_node, &((ir_function *) ir)->signatures)
+	    write_list(&((ir_function_signature *) sig_node)->body);
+      } else {
+	 failed = true;
+      }
+   }
+}
+
+
+class ir_deserializer {
+public:
+   ir_deserializer(ir_blob_reader *blob, void *mem_ctx)
+      : blob(blob), mem_ctx(mem_ctx), variables(NULL), num_variables(0),
+	signatures(NULL), num_signatures(0), depth(0)
+   {
+   }
+
+   ~ir_deserializer()
+   {
+      hieralloc_free(variables);
+      hieralloc_free(signatures);
+   }
+
+   bool read_shader(exec_list *instructions);
+
+private:
+   bool fail()
+   {
+      blob->failed = true;
+      return false;
+   }
+
+   ir_variable *declare_variable();
+   ir_variable *read_variable_ref();
+   bool read_list(exec_list *list);
+   ir_instruction *read_instruction(unsigned ir_type);
+   ir_rvalue *read_rvalue();
+   ir_constant *read_constant();
+
+   ir_blob_reader *blob;
+   void *mem_ctx;
+
+   ir_variable **variables;
+   unsigned num_variables;
+   ir_function_signature **signatures;
+   unsigned num_signatures;
+
+   /**
+    * Nesting of read_list and read_rvalue, limited so that a hostile blob
+    * cannot exhaust the stack
+    */
+   unsigned depth;
+   static const unsigned max_depth = 512;
+};
+
+ir_variable *
+ir_deserializer::declare_variable()
+{
+   const char *name = blob->read_string();
+   const glsl_type *type = blob->read_type();
+   const unsigned mode = blob->read_uint();
+   const unsigned interpolation = blob->read_uint();
+   const unsigned precision = blob->read_uint();
+   const unsigned flags = blob->read_uint();
+   const int location = blob->read_int();
+   const unsigned max_array_access = blob->read_uint();
+
+   if (blob->failed || name == NULL || mode > ir_var_temporary
+       || interpolation > ir_var_noperspective || precision > ir_precision_low) {
+      fail();
+      return NULL;
+   }
+
+   ir_variable *var = new(mem_ctx) ir_variable(type, name,
+					       (ir_variable_mode) mode);
+   var->interpolation = interpolation;
+   var->precision = precision;
+   var->read_only = flags & 1;
+   var->centroid = (flags >> 1) & 1;
+   var->invariant = (flags >> 2) & 1;
+   var->array_lvalue = (flags >> 3) & 1;
+   var->origin_upper_left = (flags >> 4) & 1;
+   var->pixel_center_integer = (flags >> 5) & 1;
+   var->explicit_location = (flags >> 6) & 1;
+   var->location = location;
+   var->location_frac = (flags >> 7) & 3;
+   var->max_array_access = max_array_access;
+
+   ir_rvalue *constant_value = read_rvalue();
+   if (constant_value != NULL) {
+      var->constant_value = constant_value->as_constant();
+      if (var->constant_value == NULL)
+	 fail();
+   }
+
+   if (num_variables % 32 == 0)
+      variables = hieralloc_realloc(NULL, variables, ir_variable *,
+				    num_variables + 32);
+   variables[num_variables++] = var;
+   return var;
+}
+
+ir_variable *
+ir_deserializer::read_variable_ref()
+{
+   const unsigned index = blob->read_uint();
+   if (index == 0 || index > num_variables) {
+      fail();
+      return NULL;
+   }
+   return variables[index - 1];
+}
+
+bool
+ir_deserializer::read_list(exec_list *list)
+{
+   const unsigned count = blob->read_uint();
+   if (depth >= max_depth)
+      return fail();
+
+   depth++;
+   for (unsigned i = 0; i < count && !blob->failed; i++) {
+      ir_instruction *ir = read_instruction(blob->read_uint());
+      if (ir == NULL) {
+	 depth--;
+	 return fail();
+      }
+      list->push_tail(ir);
+   }
+   depth--;
+   return !blob->failed;
+}
+
+ir_rvalue *
+ir_deserializer::read_rvalue()
+{
+   const unsigned ir_type = blob->read_uint();
+   if (blob->failed || ir_type == ir_type_unset)
+      return NULL;
+   if (depth >= max_depth)
+      return (ir_rvalue *) (fail(), NULL);
+
+   depth++;
+   ir_instruction *ir = read_instruction(ir_type);
+   depth--;
+   ir_rvalue *rvalue = ir ? ir->as_rvalue() : NULL;
+   if (rvalue == NULL)
+      fail();
+   return rvalue;
+}
+
+ir_constant *
+ir_deserializer::read_constant()
+{
+   const glsl_type *type = blob->read_type();
+   if (blob->failed)
+      return NULL;
+
+   if (type->is_array() || type->is_record()) {
+      const unsigned length = type->length;
+      if (length > blob->remaining())
+	 return (ir_constant *) (fail(), NULL);
+
+      exec_list values;
+      for (unsigned i = 0; i < length; i++) {
+	 ir_constant *value = read_constant();
+	 if (value == NULL)
+	    return NULL;
+	 values.push_tail(value);
+      }
+      return new(mem_ctx) ir_constant(type, &values);
+   }
+
+   if (!type->is_scalar() && !type->is_vector() && !type->is_matrix())
+      return (ir_constant *) (fail(), NULL);
+
+   ir_constant_data data;
+   memset(&data, 0, sizeof(data));
+   if (!blob->read_bytes(&data, type->components() * sizeof(data.u[0])))
+      return NULL;
+   return new(mem_ctx) ir_constant(type, &data);
+}
+
+ir_instruction *
+ir_deserializer::read_instruction(unsigned ir_type)
+{
+   if (blob->failed)
+      return NULL;
+
+   switch (ir_type) {
+   case ir_type_variable:
+      return declare_variable();
+   case ir_type_assignment: {
+      ir_rvalue *lhs = read_rvalue();
+      ir_rvalue *rhs = read_rvalue();
+      ir_rvalue *condition = read_rvalue();
+      const unsigned write_mask = blob->read_uint();
+      if (lhs == NULL || lhs->as_dereference() == NULL || rhs == NULL)
+	 return (ir_instruction *) (fail(), NULL);
+      if (lhs->type->is_scalar() || lhs->type->is_vector()) {
+	 unsigned components = 0;
+	 for (unsigned i = 0; i < 4; i++)
+	    components += (write_mask >> i) & 1;
+	 if (components != rhs->type->vector_elements)
+	    return (ir_instruction *) (fail(), NULL);
+      }
+      return new(mem_ctx) ir_assignment(lhs->as_dereference(), rhs, condition,
+					write_mask);
+   }
+   case ir_type_call: {
+      const unsigned index = blob->read_uint();
+      exec_list parameters;
+      if (index == 0 || index > num_signatures || !read_list(&parameters))
+	 return (ir_instruction *) (fail(), NULL);
+      exec_list_iterator formal = signatures[index - 1]->parameters.iterator();
+      foreach_list(node, &parameters) {
+	 if (!formal.has_next() || ((ir_instruction *) node)->as_rvalue() == NULL)
+	    return (ir_instruction *) (fail(), NULL);
+	 formal.next();
+      }
+      if (formal.has_next())
+	 return (ir_instruction *) (fail(), NULL);
+      return new(mem_ctx) ir_call(signatures[index - 1], &parameters);
+   }
+   case ir_type_constant:
+      return read_constant();
+   case ir_type_dereference_array: {
+      ir_rvalue *array = read_rvalue();
+      ir_rvalue *index = read_rvalue();
+      if (array == NULL || index == NULL)
+	 return (ir_instruction *) (fail(), NULL);
+      return new(mem_ctx) ir_dereference_array(array, index);
+   }
+   case ir_type_dereference_record: {
+      ir_rvalue *record = read_rvalue();
+      const char *field = blob->read_string();
+      if (record == NULL || field == NULL || !record->type->is_record())
+	 return (ir_instruction *) (fail(), NULL);
+      return new(mem_ctx) ir_dereference_record(record, field);
+   }
+   case ir_type_dereference_variable: {
+      ir_variable *var = read_variable_ref();
+      if (var == NULL)
+	 return NULL;
+      return new(mem_ctx) ir_dereference_variable(var);
+   }
+   case ir_type_discard:
+      return new(mem_ctx) ir_discard(read_rvalue());
+   case ir_type_expression: {
+      const unsigned operation = blob->read_uint();
+      const glsl_type *type = blob->read_type();
+      const unsigned num_operands = blob->read_uint();
+      ir_rvalue *operands[4] = { NULL, NULL, NULL, NULL };
+      if (operation > ir_quadop_vector)
+	 return (ir_instruction *) (fail(), NULL);
+      /* Operands must match the arity the operation is evaluated with;
+       * ir_quadop_vector has one per component of its type.
+       */
+      const unsigned arity = operation == ir_quadop_vector
+	 ? type->vector_elements
+	 : ir_expression::get_num_operands((ir_expression_operation) operation);
+      if (num_operands != arity || num_operands < 1 || num_operands > 4)
+	 return (ir_instruction *) (fail(), NULL);
+      for (unsigned i = 0; i < num_operands; i++)
+	 if ((operands[i] = read_rvalue()) == NULL)
+	    return (ir_instruction *) (fail(), NULL);
+      return new(mem_ctx) ir_expression(operation, type, operands[0],
+					operands[1], operands[2], operands[3]);
+   }
+   case ir_type_if: {
+      ir_rvalue *condition = read_rvalue();
+      if (condition == NULL)
+	 return (ir_instruction *) (fail(), NULL);
+      ir_if *iif = new(mem_ctx) ir_if(condition);
+      if (!read_list(&iif->then_instructions)
+	  || !read_list(&iif->else_instructions))
+	 return NULL;
+      return iif;
+   }
+   case ir_type_loop: {
+      ir_loop *loop = new(mem_ctx) ir_loop();
+      if (!read_list(&loop->body_instructions))
+	 return NULL;
+      loop->from = read_rvalue();
+      loop->to = read_rvalue();
+      loop->increment = read_rvalue();
+      const unsigned counter = blob->read_uint();
+      if (counter > num_variables)
+	 return (ir_instruction *) (fail(), NULL);
+      loop->counter = counter ? variables[counter - 1] : NULL;
+      loop->cmp = blob->read_int();
+      return loop;
+   }
+   case ir_type_loop_jump: {
+      const unsigned mode = blob->read_uint();
+      if (mode > ir_loop_jump::jump_continue)
+	 return (ir_instruction *) (fail(), NULL);
+      return new(mem_ctx) ir_loop_jump((ir_loop_jump::jump_mode) mode);
+   }
+   case ir_type_return: {
+      ir_rvalue *value = read_rvalue();
+      if (value == NULL)
+	 return new(mem_ctx) ir_return();
+      return new(mem_ctx) ir_return(value);
+   }
+   case ir_type_swizzle: {
+      ir_rvalue *val = read_rvalue();
+      const unsigned mask = blob->read_uint();
+      const unsigned count = (mask >> 8) & 7;
+      if (val == NULL || count < 1 || count > 4)
+	 return (ir_instruction *) (fail(), NULL);
+      return new(mem_ctx) ir_swizzle(val, mask & 3, (mask >> 2) & 3,
+				     (mask >> 4) & 3, (mask >> 6) & 3, count);
+   }
+   case ir_type_texture: {
+      const unsigned op = blob->read_uint();
+      if (op > ir_txf)
+	 return (ir_instruction *) (fail(), NULL);
+      ir_texture *tex = new(mem_ctx) ir_texture((ir_texture_opcode) op);
+      tex->type = blob->read_type();
+      ir_rvalue *sampler = read_rvalue();
+      if (sampler == NULL || sampler->as_dereference() == NULL)
+	 return (ir_instruction *) (fail(), NULL);
+      tex->sampler = sampler->as_dereference();
+      tex->coordinate = read_rvalue();
+      tex->projector = read_rvalue();
+      tex->shadow_comparitor = read_rvalue();
+      for (unsigned i = 0; i < 3; i++)
+	 tex->offsets[i] = blob->read_int();
+      switch (tex->op) {
+      case ir_tex:
+	 break;
+      case ir_txb:
+	 tex->lod_info.bias = read_rvalue();
+	 break;
+      case ir_txl:
+      case ir_txf:
+	 tex->lod_info.lod = read_rvalue();
+	 break;
+      case ir_txd:
+	 tex->lod_info.grad.dPdx = read_rvalue();
+	 tex->lod_info.grad.dPdy = read_rvalue();
+	 break;
+      }
+      return tex;
+   }
+   default:
+      return (ir_instruction *) (fail(), NULL);
+   }
+}
+
+bool
+ir_deserializer::read_shader(exec_list *instructions)
+{
+   const unsigned num_functions = blob->read_uint();
+   if (num_functions > blob->remaining())
+      return fail();
+
+   ir_function **functions = hieralloc_array(NULL, ir_function *,
+					     num_functions + 1);
+   for (unsigned i = 0; i < num_functions && !blob->failed; i++) {
+      const char *name = blob->read_string();
+      const unsigned num_sigs = blob->read_uint();
+      if (name == NULL || num_sigs > blob->remaining()) {
+	 fail();
+	 break;
+      }
+
+      functions[i] = new(mem_ctx) ir_function(name);
+      for (unsigned j = 0; j < num_sigs && !blob->failed; j++) {
+	 ir_function_signature *sig =
+	    new(mem_ctx) ir_function_signature(blob->read_type());
+	 const unsigned flags = blob->read_uint();
+	 sig->is_defined = flags & 1;
+	 sig->is_builtin = (flags >> 1) & 1;
+	 read_list(&sig->parameters);
+	 foreach_list(node, &sig->parameters)
+	    if (((ir_instruction *) node)->as_variable() == NULL)
+	       fail();
+	 functions[i]->add_signature(sig);
+
+	 if (num_signatures % 32 == 0)
+	    signatures = hieralloc_realloc(NULL, signatures,
+					   ir_function_signature *,
+					   num_signatures + 32);
+	 signatures[num_signatures++] = sig;
+      }
+   }
+
+   const unsigned num_globals = blob->read_uint();
+   if (num_globals > blob->remaining())
+      fail();
+   ir_variable **globals = hieralloc_array(NULL, ir_variable *,
+					   num_globals + 1);
+   for (unsigned i = 0; i < num_globals && !blob->failed; i++)
+      globals[i] = declare_variable();
+
+   const unsigned count = blob->read_uint();
+   for (unsigned i = 0; i < count && !blob->failed; i++) {
+      const unsigned ir_type = blob->read_uint();
+      const unsigned index = blob->read_uint();
+      /* each global and function appears once; clear the slot so a
+       * duplicate index is rejected rather than linked into two lists
+       */
+      if (ir_type == ir_type_variable && index < num_globals
+	  && globals[index] != NULL) {
+	 instructions->push_tail(globals[index]);
+	 globals[index] = NULL;
+      } else if (ir_type == ir_type_function && index < num_functions
+		 && functions[index] != NULL) {
+	 instructions->push_tail(functions[index]);
+	 foreach_list(node, &functions[index]->signatures)
+	    if (!read_list(&((ir_function_signature *) node)->body))
+	       break;
+	 functions[index] = NULL;
+      } else {
+	 fail();
+      }
+   }
+
+   hieralloc_free(functions);
+   hieralloc_free(globals);
+   return !blob->failed;
+}
+
+} /* anonymous namespace */
+
+
+bool
+ir_serialize(ir_blob_writer *blob, exec_list *instructions)
+{
+   ir_serializer serializer(blob);
+   serializer.write_shader(instructions);
+   return !serializer.failed && !blob->failed;
+}
+
+bool
+ir_deserialize(ir_blob_reader *blob, void *mem_ctx, exec_list *instructions)
+{
+   ir_deserializer deserializer(blob, mem_ctx);
+   return deserializer.read_shader(instructions);
+}
@@ -0,0 +1,99 @@
+/* -*- c++ -*- */
+/**
+ **
+ ** Copyright 2011, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+#pragma once
+#ifndef IR_SERIALIZE_H
+#define IR_SERIALIZE_H
+
+#include "ir.h"
+
+/**
+ * Growable byte buffer for program binaries
+ *
+ * Integers are variable length, strings are length prefixed and NUL
+ * terminated; binaries are only read back by the same build.
+ */
+class ir_blob_writer {
+public:
+   ir_blob_writer(void *mem_ctx);
+
+   void write_bytes(const void *data, unsigned size);
+   void write_uint(unsigned value);
+   void write_int(int value);
+   void write_string(const char *str);
+   void write_type(const glsl_type *type);
+
+   char *data;
+   unsigned size;
+   bool failed; /**< out of memory */
+
+private:
+   void *mem_ctx;
+   unsigned capacity;
+};
+
+/**
+ * Bounds checked reader for buffers built by \c ir_blob_writer
+ *
+ * Reading past the end or malformed data sets \c failed; reads then return
+ * zeros and NULL.
+ */
+class ir_blob_reader {
+public:
+   ir_blob_reader(const void *data, unsigned size);
+
+   bool read_bytes(void *dst, unsigned size);
+   unsigned read_uint();
+   int read_int();
+   /** Returns a pointer into the buffer, or NULL for a NULL string */
+   const char *read_string();
+   const glsl_type *read_type();
+
+   unsigned remaining() const
+   {
+      return end - pos;
+   }
+
+   bool failed;
+
+private:
+   const unsigned char *pos;
+   const unsigned char *end;
+
+   /** Nesting of array and record types being read */
+   unsigned type_depth;
+   static const unsigned max_type_depth = 16;
+};
+
+/**
+ * Append a linked shader's IR to \c blob
+ *
+ * Returns false if the IR references a variable or function it does not
+ * contain.
+ */
+bool ir_serialize(ir_blob_writer *blob, exec_list *instructions);
+
+/**
+ * Rebuild IR written by \c ir_serialize into \c instructions
+ *
+ * Nodes are allocated in \c mem_ctx; on failure the caller frees it.
+ */
+bool ir_deserialize(ir_blob_reader *blob, void *mem_ctx,
+		    exec_list *instructions);
+
+#endif /* IR_SERIALIZE_H */
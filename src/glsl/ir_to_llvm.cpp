@@ -41,11 +41,15 @@
 #include "llvm/LLVMContext.h"
 #include "llvm/Module.h"
 #include "llvm/Analysis/Verifier.h"
+#include "llvm/Support/CFG.h"
 //#include "llvm/Intrinsics.h"
 
 #include <vector>
 #include <stdio.h>
+#include <math.h>
+#include <string>
 #include <map>
+#include <set>
 /*
 #ifdef _MSC_VER
 #include <unordered_map>
@@ -63,6 +67,26 @@ using namespace tr1;
 #include "ir_visitor.h"
 #include "glsl_types.h"
 #include "src/mesa/main/mtypes.h"
+#include "ir_to_llvm.h"
+#include "pixelflinger2/pixelflinger2_interface.h"
+
+// shaders are JIT compiled for the machine libMesa runs on, so the target
+// macros of this build tell which native vector intrinsics may be emitted
+#if defined(__SSE__)
+#define USE_SSE_INTRINSICS 1
+#else
+#define USE_SSE_INTRINSICS 0
+#endif
+#if defined(__SSE4_1__)
+#define USE_SSE41_INTRINSICS 1
+#else
+#define USE_SSE41_INTRINSICS 0
+#endif
+#if defined(__ARM_NEON__)
+#define USE_NEON_INTRINSICS 1
+#else
+#define USE_NEON_INTRINSICS 0
+#endif
 
 // Helper function to convert array to llvm::ArrayRef
 template <typename T, size_t N>
@@ -76,12 +100,10 @@ static inline llvm::ArrayRef<T> pack(T const *ptr, size_t n) {
    return llvm::ArrayRef<T>(ptr, n);
 }
 
-struct GGLState;
-
 llvm::Value * tex2D(llvm::IRBuilder<> & builder, llvm::Value * in1, const unsigned sampler,
-                     const GGLState * gglCtx);
+                     const GGLState * gglCtx, const GGLChannelType dstType);
 llvm::Value * texCube(llvm::IRBuilder<> & builder, llvm::Value * in1, const unsigned sampler,
-                     const GGLState * gglCtx);
+                     const GGLState * gglCtx, const GGLChannelType dstType);
 
 class ir_to_llvm_visitor : public ir_visitor {
    ir_to_llvm_visitor();
@@ -98,29 +120,44 @@ public:
    llvm::IRBuilder<> bld;
 
    const GGLState * gglCtx;
+   const bool reducedPrecision; // lowp in 8.8 fixed point, see GGLState::reducedPrecision
    const char * shaderSuffix;
-   llvm::Value * inputsPtr, * outputsPtr, * constantsPtr; // internal globals to store inputs/outputs/constants pointers
+   // the shader's "registers", passed from main to every other function so that
+   // compiled shaders keep no per invocation state in module globals and can run
+   // on any number of threads at once
    llvm::Value * inputs, * outputs, * constants;
+   llvm::Value * globals; // gl_globals, main's stack copy of writable shader globals
+   llvm::StructType * globalsType;
+   std::map<ir_variable *, unsigned> globalFields; // writable shader global -> globalsType field
+   std::map<ir_variable *, unsigned> precisions; // inferred for ir_precision_undefined temporaries
 
    ir_to_llvm_visitor(llvm::Module* p_mod, const GGLState * GGLCtx, const char * suffix)
    : ctx(p_mod->getContext()), mod(p_mod), fun(0), loop(std::make_pair((llvm::BasicBlock*)0,
-      (llvm::BasicBlock*)0)), bb(0), bld(ctx), gglCtx(GGLCtx), shaderSuffix(suffix),
-      inputsPtr(NULL), outputsPtr(NULL), constantsPtr(NULL),
-      inputs(NULL), outputs(NULL), constants(NULL)
+      (llvm::BasicBlock*)0)), bb(0), bld(ctx), gglCtx(GGLCtx),
+      reducedPrecision(GGLCtx && GGLCtx->reducedPrecision), shaderSuffix(suffix),
+      inputs(NULL), outputs(NULL), constants(NULL), globals(NULL), globalsType(NULL)
    {
-      llvm::PointerType * const floatVecPtrType = llvm::PointerType::get(llvm::VectorType::get(bld.getFloatTy(),4), 0);
-      llvm::Constant * const nullFloatVecPtr = llvm::Constant::getNullValue(floatVecPtrType);
-      // make input, output and consts global pointers so they can be used in
-      // different LLVM functions since the shader shares these "registers" across "functions"
-
-      inputsPtr = new llvm::GlobalVariable(*mod, floatVecPtrType, false,
-         llvm::GlobalValue::InternalLinkage, nullFloatVecPtr, "gl_inputPtr");
-
-      outputsPtr = new llvm::GlobalVariable(*mod, floatVecPtrType, false,
-         llvm::GlobalValue::InternalLinkage, nullFloatVecPtr, "gl_outputsPtr");
+   }
 
-      constantsPtr = new llvm::GlobalVariable(*mod, floatVecPtrType, false,
-         llvm::GlobalValue::InternalLinkage, nullFloatVecPtr, "gl_constantsPtr");
+   /**
+    * Lay out writable shader globals in \c globalsType
+    *
+    * Must run before any function is visited; read only globals stay module
+    * constants.
+    */
+   void declare_globals(exec_list * instructions)
+   {
+      std::vector<llvm::Type *> fields;
+      foreach_iter(exec_list_iterator, iter, *instructions) {
+         ir_variable * var = ((ir_instruction *)iter.get())->as_variable();
+         if (!var || var->read_only)
+            continue;
+         if (ir_var_auto != var->mode && ir_var_temporary != var->mode)
+            continue;
+         globalFields[var] = fields.size();
+         fields.push_back(llvm_type(var->type));
+      }
+      globalsType = llvm::StructType::get(ctx, llvm::ArrayRef<llvm::Type *>(fields));
    }
 
    llvm::Type* llvm_base_type(unsigned base_type)
@@ -190,16 +227,16 @@ public:
 
          llvm::Value* v = NULL;
          if(fun) {
-            if (ir_var_in == var->mode)
-            {
-               assert(var->location >= 0);
-               v = bld.CreateConstGEP1_32(inputs, var->location);
-               v = bld.CreateBitCast(v, llvm::PointerType::get(llvm_type(var->type), 0), var->name);
-            }
-            else if (ir_var_out == var->mode)
+            if (ir_var_in == var->mode || ir_var_out == var->mode)
             {
                assert(var->location >= 0);
-               v = bld.CreateConstGEP1_32(outputs, var->location);
+               v = bld.CreateConstGEP1_32(ir_var_in == var->mode ? inputs : outputs, var->location);
+               // packed varyings start at component location_frac of the slot;
+               // the linker packs largest first, so they stay naturally aligned
+               if (var->location_frac) {
+                  v = bld.CreateBitCast(v, llvm::PointerType::get(bld.getFloatTy(), 0));
+                  v = bld.CreateConstGEP1_32(v, var->location_frac);
+               }
                v = bld.CreateBitCast(v, llvm::PointerType::get(llvm_type(var->type), 0), var->name);
             }
             else if (ir_var_uniform == var->mode)
@@ -223,6 +260,8 @@ public:
                case ir_var_auto: // fall through
                case ir_var_temporary:
                {
+                  if (globalFields.count(var))
+                     return NULL; // lives in gl_globals, see declare_globals
                   llvm::Constant * init = llvm::UndefValue::get(llvm_type(var->type));
                   if(var->constant_value)
                      init = llvm_constant(var->constant_value);
@@ -286,17 +325,22 @@ public:
             params.push_back(llvm_type(arg->type));
          }
 
+         llvm::PointerType * vecPtrTy = llvm::PointerType::get(llvm::VectorType::get(bld.getFloatTy(), 4), 0);
          if(!strcmp(name, "main") || !sig->is_defined)
          {
             linkage = llvm::Function::ExternalLinkage;
-            llvm::PointerType * vecPtrTy = llvm::PointerType::get(llvm::VectorType::get(bld.getFloatTy(), 4), 0);
             assert(0 == params.size());
             params.push_back(vecPtrTy); // inputs
             params.push_back(vecPtrTy); // outputs
             params.push_back(vecPtrTy); // constants
          }
          else {
+            // after the GLSL parameters, see visit(ir_call)
             linkage = llvm::Function::InternalLinkage;
+            params.push_back(vecPtrTy); // inputs
+            params.push_back(vecPtrTy); // outputs
+            params.push_back(vecPtrTy); // constants
+            params.push_back(llvm::PointerType::get(globalsType, 0));
          }
          llvm::FunctionType* ft = llvm::FunctionType::get(llvm_type(sig->return_type),
                                                           llvm::ArrayRef<llvm::Type*>(params),
@@ -307,6 +351,134 @@ public:
       }
    }
 
+   /**
+    * \name SSA construction
+    *
+    * Scalar and vector locals have no stack slot; dynamic component indexing
+    * uses extractelement/insertelement.  The value each block last assigned them is tracked instead,
+    * and phis are placed on demand when a block reads a value it did not
+    * assign, after Braun et al., "Simple and Efficient Construction of Static
+    * Single Assignment Form".  A block is sealed once all its predecessors
+    * have branched to it; phis placed in it before that get their operands in
+    * seal_block.
+    */
+   /*@{*/
+   std::set<ir_variable *> ssaVariables;
+   typedef std::map<ir_variable *, llvm::Value *> definitions_t;
+   std::map<llvm::BasicBlock *, definitions_t> currentDefs;
+   std::map<llvm::BasicBlock *, std::map<ir_variable *, llvm::PHINode *> > incompletePhis;
+   std::set<llvm::BasicBlock *> sealedBlocks;
+
+   bool is_ssa(ir_variable * var)
+   {
+      if (ssaVariables.count(var))
+         return true;
+      if (!fun || llvm_variables.count(var))
+         return false;
+      if (ir_var_auto != var->mode && ir_var_temporary != var->mode)
+         return false;
+      if (!var->type->is_scalar() && !var->type->is_vector())
+         return false;
+      ssaVariables.insert(var);
+      return true;
+   }
+
+   void write_variable(ir_variable * var, llvm::BasicBlock * block, llvm::Value * value)
+   {
+      currentDefs[block][var] = value;
+   }
+
+   llvm::Value * read_variable(ir_variable * var, llvm::BasicBlock * block)
+   {
+      definitions_t & defs = currentDefs[block];
+      definitions_t::iterator def = defs.find(var);
+      if (def != defs.end())
+         return def->second;
+
+      llvm::Value * value;
+      if (!sealedBlocks.count(block)) {
+         llvm::PHINode * phi = create_phi(var, block);
+         incompletePhis[block][var] = phi;
+         value = phi;
+      } else if (llvm::BasicBlock * pred = block->getSinglePredecessor())
+         value = read_variable(var, pred);
+      else if (llvm::pred_begin(block) == llvm::pred_end(block))
+         value = llvm::UndefValue::get(llvm_type(var->type)); // entry or dead code
+      else {
+         // define the phi first so that reads around a loop end at it
+         llvm::PHINode * phi = create_phi(var, block);
+         write_variable(var, block, phi);
+         value = add_phi_operands(var, phi);
+      }
+      write_variable(var, block, value);
+      return value;
+   }
+
+   llvm::PHINode * create_phi(ir_variable * var, llvm::BasicBlock * block)
+   {
+      llvm::Type * type = llvm_type(var->type);
+      if (block->empty())
+         return llvm::PHINode::Create(type, 2, var->name, block);
+      return llvm::PHINode::Create(type, 2, var->name, &block->front());
+   }
+
+   llvm::Value * add_phi_operands(ir_variable * var, llvm::PHINode * phi)
+   {
+      llvm::BasicBlock * block = phi->getParent();
+      // reading may place phis elsewhere, so don't walk the use list meanwhile
+      std::vector<llvm::BasicBlock *> preds(llvm::pred_begin(block), llvm::pred_end(block));
+      for (unsigned i = 0; i < preds.size(); i++)
+         phi->addIncoming(read_variable(var, preds[i]), preds[i]);
+
+      // a phi merging one value and itself is replaced by that value
+      llvm::Value * same = NULL;
+      for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+         llvm::Value * incoming = phi->getIncomingValue(i);
+         if (incoming == phi || incoming == same)
+            continue;
+         if (same)
+            return phi;
+         same = incoming;
+      }
+      if (!same)
+         same = llvm::UndefValue::get(phi->getType());
+      phi->replaceAllUsesWith(same);
+      for (std::map<llvm::BasicBlock *, definitions_t>::iterator it = currentDefs.begin();
+           it != currentDefs.end(); ++it) {
+         definitions_t::iterator def = it->second.find(var);
+         if (def != it->second.end() && def->second == phi)
+            def->second = same;
+      }
+      phi->eraseFromParent();
+      return same;
+   }
+
+   void seal_block(llvm::BasicBlock * block)
+   {
+      std::map<ir_variable *, llvm::PHINode *> phis;
+      phis.swap(incompletePhis[block]);
+      sealedBlocks.insert(block);
+      for (std::map<ir_variable *, llvm::PHINode *>::iterator it = phis.begin();
+           it != phis.end(); ++it)
+         add_phi_operands(it->first, it->second);
+   }
+
+   llvm::Value * load_variable(ir_variable * var)
+   {
+      if (is_ssa(var))
+         return read_variable(var, bld.GetInsertBlock());
+      return bld.CreateLoad(llvm_variable(var), var->name);
+   }
+
+   void store_variable(ir_variable * var, llvm::Value * value)
+   {
+      if (is_ssa(var))
+         write_variable(var, bld.GetInsertBlock(), value);
+      else
+         bld.CreateStore(value, llvm_variable(var));
+   }
+   /*@}*/
+
    llvm::Value* llvm_value(class ir_instruction* ir)
    {
       result = 0;
@@ -325,12 +497,60 @@ public:
       return llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), v);
    }
 
+   /**
+    * Index into \c *base of an in, out or uniform dereference, or NULL if
+    * \c ir is not one
+    *
+    * These are laid out one vec4 slot per array element and matrix column
+    * (see add_uniform in linker.cpp), which is not how LLVM lays out arrays
+    * of float, vec2 or mat2, so indexing them computes the slot directly.
+    * Arrays of records take more than one slot per element and keep the
+    * LLVM layout.
+    */
+   llvm::Value* llvm_slot(class ir_rvalue* ir, llvm::Value** base)
+   {
+      if(ir_dereference_variable* deref = ir->as_dereference_variable())
+      {
+         ir_variable * var = deref->var;
+         if (var->location < 0) // function parameters are ir_var_in too
+            return NULL;
+         if (ir_var_in == var->mode)
+            *base = inputs;
+         else if (ir_var_out == var->mode)
+            *base = outputs;
+         else if (ir_var_uniform == var->mode)
+            *base = constants;
+         else
+            return NULL;
+         return llvm_int(var->location);
+      }
+      ir_dereference_array* deref = ir->as_dereference_array();
+      if (!deref || deref->array->type->is_vector())
+         return NULL;
+      if (!deref->type->is_scalar() && !deref->type->is_vector() && !deref->type->is_matrix())
+         return NULL;
+      llvm::Value* slot = llvm_slot(deref->array, base);
+      if (!slot)
+         return NULL;
+      llvm::Value* index = llvm_value(deref->array_index);
+      if (deref->type->is_matrix())
+         index = bld.CreateMul(index, llvm_int(deref->type->matrix_columns));
+      return bld.CreateAdd(slot, index, "slot");
+   }
+
    llvm::Value* llvm_pointer(class ir_rvalue* ir)
    {
       if(ir_dereference_variable* deref = ir->as_dereference_variable())
          return llvm_variable(deref->variable_referenced());
       else if(ir_dereference_array* deref = ir->as_dereference_array())
       {
+         // vector components are indexed with extractelement/insertelement
+         assert(!deref->array->type->is_vector());
+         llvm::Value* base = NULL;
+         if (llvm::Value* slot = llvm_slot(deref, &base)) {
+            llvm::Value* element = bld.CreateInBoundsGEP(base, slot);
+            return bld.CreateBitCast(element, llvm::PointerType::get(llvm_type(deref->type), 0));
+         }
          llvm::Value* gep[2] = {llvm_int(0), llvm_value(deref->array_index)};
          return bld.CreateInBoundsGEP(llvm_pointer(deref->array), gep);
          }
@@ -361,62 +581,61 @@ public:
 //      return bld.CreateCall2(llvm::Intrinsic::getDeclaration(mod, id, types, 1), a, b);
 //   }
 
-   llvm::Value* llvm_intrinsic_unop(ir_expression_operation op, llvm::Value * op0)
+   // declares an external function or LLVM intrinsic by name if not already in module
+   llvm::Function* llvm_declare(const char * name, llvm::Type * ret_type,
+                                llvm::Type * arg0_type, llvm::Type * arg1_type = NULL)
    {
-      llvm::Type * floatType = llvm::Type::getFloatTy(ctx);
-      const char * name = NULL;
-      switch (op) {
-      case ir_unop_sin:
-         name = "sinf";
-         break;
-      case ir_unop_cos:
-         name = "cosf";
-         break;
-      default:
-         assert(0);
-      }
-
       llvm::Function * function = mod->getFunction(name);
-      if (!function) {
-         // predeclare the intrinsic
-         std::vector<llvm::Type*> args;
-         args.push_back(floatType);
-         llvm::FunctionType* type = llvm::FunctionType::get(floatType,
-                                                            llvm::ArrayRef<llvm::Type*>(args),
-                                                            false);
-         function = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, mod);
-         function->setCallingConv(llvm::CallingConv::C);
-      }
+      if (function)
+         return function;
+      std::vector<llvm::Type*> args;
+      args.push_back(arg0_type);
+      if (arg1_type)
+         args.push_back(arg1_type);
+      llvm::FunctionType* type = llvm::FunctionType::get(ret_type,
+                                                         llvm::ArrayRef<llvm::Type*>(args),
+                                                         false);
+      function = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, mod);
+      function->setCallingConv(llvm::CallingConv::C);
+      return function;
+   }
+
+   // overloaded float intrinsics are suffixed by type, e.g. llvm.sqrt.v4f32
+   std::string llvm_overload_name(const char * name, llvm::Type * type)
+   {
+      char suffix[16];
+      if (type->isVectorTy())
+         snprintf(suffix, sizeof suffix, ".v%uf32", ((llvm::VectorType*)type)->getNumElements());
+      else
+         snprintf(suffix, sizeof suffix, ".f32");
+      return std::string(name) + suffix;
+   }
 
-      return bld.CreateCall(function, op0);
+   static bool is_vec_width(llvm::Type * type, unsigned width)
+   {
+      return type->isVectorTy() && ((llvm::VectorType*)type)->getNumElements() == width;
+   }
+
+   // i32 scalar or vector with the same number of components as type
+   llvm::Type* llvm_int_type(llvm::Type * type)
+   {
+      if (type->isVectorTy())
+         return llvm::VectorType::get(bld.getInt32Ty(), ((llvm::VectorType*)type)->getNumElements());
+      return bld.getInt32Ty();
    }
 
-   llvm::Value* llvm_intrinsic_binop(ir_expression_operation op, llvm::Value * op0, llvm::Value * op1)
+   llvm::Value* llvm_intrinsic_unop(ir_expression_operation op, llvm::Value * op0)
    {
-      llvm::Type * floatType = llvm::Type::getFloatTy(ctx);
-      const char * name = NULL;
+      llvm::Type * type = op0->getType();
       switch (op) {
-      case ir_binop_pow:
-         name = "powf";
-         break;
+      case ir_unop_sqrt:
+         // llvm.sqrt is overloaded for vectors, so no per component calls
+         return bld.CreateCall(llvm_declare(llvm_overload_name("llvm.sqrt", type).c_str(),
+                                            type, type), op0, "sqrt");
       default:
          assert(0);
+         return NULL;
       }
-
-      llvm::Function * function = mod->getFunction(name);
-      if (!function) {
-         // predeclare the intrinsic
-         std::vector<llvm::Type*> args;
-         args.push_back(floatType);
-         args.push_back(floatType);
-         llvm::FunctionType* type = llvm::FunctionType::get(floatType,
-                                                            llvm::ArrayRef<llvm::Type*>(args),
-                                                            false);
-         function = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, mod);
-         function->setCallingConv(llvm::CallingConv::C);
-      }
-
-      return bld.CreateCall2(function, op0, op1);
    }
 
    llvm::Constant* llvm_imm(llvm::Type* type, double v)
@@ -447,21 +666,465 @@ public:
       return bld.CreateShuffleVector(v, llvm::UndefValue::get(v->getType()), llvm::ConstantVector::get(pack(vals)), name);
    }
 
-   llvm::Value* create_select(unsigned width, llvm::Value * cond, llvm::Value * tru, llvm::Value * fal, const char * name = "")
+   // cond may be a vector of i1, which is lowered to a native blend / bitwise select
+   llvm::Value* create_select(llvm::Value * cond, llvm::Value * tru, llvm::Value * fal, const char * name = "")
+   {
+      return bld.CreateSelect(cond, tru, fal, name);
+   }
+
+   llvm::Value* create_fabs(llvm::Value * x)
+   {
+      llvm::Type * intType = llvm_int_type(x->getType());
+      llvm::Value * bits = bld.CreateBitCast(x, intType);
+      bits = bld.CreateAnd(bits, llvm_imm(intType, 0x7fffffff), "fabs.mask");
+      return bld.CreateBitCast(bits, x->getType(), "fabs");
+   }
+
+   // SSE4.1 roundps rounding control: 0 nearest even, 1 down, 2 up, 3 toward zero
+   llvm::Value* create_sse41_round(llvm::Value * x, unsigned mode)
+   {
+      llvm::Type * type = x->getType();
+      llvm::Function * function = llvm_declare("llvm.x86.sse41.round.ps", type, type, bld.getInt32Ty());
+      return bld.CreateCall2(function, x, bld.getInt32(mode), "roundps");
+   }
+
+   // float to int and back truncates toward zero; fptosi is only defined for
+   // |x| < 2^31, so floats at or above 2^23, which are already integers, and NaN
+   // are returned unchanged
+   llvm::Value* create_trunc(llvm::Value * x)
+   {
+      llvm::Value * t = bld.CreateSIToFP(bld.CreateFPToSI(x, llvm_int_type(x->getType()), "trunc.fptosi"),
+                                         x->getType(), "trunc.sitofp");
+      llvm::Value * small = bld.CreateFCmpOLT(create_fabs(x), llvm_imm(x->getType(), 8388608.0),
+                                              "trunc.small");
+      return create_select(small, t, x, "trunc");
+   }
+
+   llvm::Value* create_floor(llvm::Value * x)
+   {
+      if (USE_SSE41_INTRINSICS && is_vec_width(x->getType(), 4))
+         return create_sse41_round(x, 1);
+      llvm::Value * t = create_trunc(x);
+      // truncation rounded a negative non integer up, so step down by one
+      llvm::Value * up = bld.CreateFCmpOGT(t, x, "floor.gt");
+      return create_select(up, bld.CreateFSub(t, llvm_imm(x->getType(), 1)), t, "floor");
+   }
+
+   llvm::Value* create_ceil(llvm::Value * x)
+   {
+      if (USE_SSE41_INTRINSICS && is_vec_width(x->getType(), 4))
+         return create_sse41_round(x, 2);
+      llvm::Value * t = create_trunc(x);
+      llvm::Value * down = bld.CreateFCmpOLT(t, x, "ceil.lt");
+      return create_select(down, bld.CreateFAdd(t, llvm_imm(x->getType(), 1)), t, "ceil");
+   }
+
+   llvm::Value* create_round_even(llvm::Value * x)
+   {
+      if (USE_SSE41_INTRINSICS && is_vec_width(x->getType(), 4))
+         return create_sse41_round(x, 0);
+      // adding and subtracting 2^23 drops the fraction with the FPU's round to
+      // nearest even; floats at or above 2^23 are already integers
+      llvm::Type * intType = llvm_int_type(x->getType());
+      llvm::Value * magic = llvm_imm(x->getType(), 8388608.0);
+      llvm::Value * a = create_fabs(x);
+      llvm::Value * r = bld.CreateFSub(bld.CreateFAdd(a, magic), magic, "round.magic");
+      r = create_select(bld.CreateFCmpOLT(a, magic), r, a, "round.big");
+      llvm::Value * sign = bld.CreateAnd(bld.CreateBitCast(x, intType),
+                                         llvm_imm(intType, (double)0x80000000u), "round.sign");
+      r = bld.CreateOr(bld.CreateBitCast(r, intType), sign);
+      return bld.CreateBitCast(r, x->getType(), "round");
+   }
+
+   llvm::Value* create_fmin(llvm::Value * a, llvm::Value * b)
+   {
+      llvm::Type * type = a->getType();
+      if (USE_SSE_INTRINSICS && is_vec_width(type, 4))
+         return bld.CreateCall2(llvm_declare("llvm.x86.sse.min.ps", type, type, type), a, b, "minps");
+      if (USE_NEON_INTRINSICS && (is_vec_width(type, 4) || is_vec_width(type, 2)))
+         return bld.CreateCall2(llvm_declare(llvm_overload_name("llvm.arm.neon.vmins", type).c_str(),
+                                             type, type, type), a, b, "vmin");
+      return create_select(bld.CreateFCmpULE(a, b, "fmin.le"), a, b, "fmin.select");
+   }
+
+   llvm::Value* create_fmax(llvm::Value * a, llvm::Value * b)
+   {
+      llvm::Type * type = a->getType();
+      if (USE_SSE_INTRINSICS && is_vec_width(type, 4))
+         return bld.CreateCall2(llvm_declare("llvm.x86.sse.max.ps", type, type, type), a, b, "maxps");
+      if (USE_NEON_INTRINSICS && (is_vec_width(type, 4) || is_vec_width(type, 2)))
+         return bld.CreateCall2(llvm_declare(llvm_overload_name("llvm.arm.neon.vmaxs", type).c_str(),
+                                             type, type, type), a, b, "vmax");
+      return create_select(bld.CreateFCmpUGE(a, b, "fmax.ge"), a, b, "fmax.select");
+   }
+
+   // hardware estimate refined by one Newton-Raphson step: y = y * (3 - x * y * y) / 2,
+   // good to about 22 bits, far beyond what GLSL asks of inversesqrt; the bare
+   // estimate has 12 bits, enough for mediump
+   llvm::Value* create_rsqrt(llvm::Value * x, const bool estimate)
+   {
+      llvm::Type * type = x->getType();
+      if (USE_SSE_INTRINSICS && is_vec_width(type, 4)) {
+         llvm::Value * y = bld.CreateCall(llvm_declare("llvm.x86.sse.rsqrt.ps", type, type), x, "rsqrtps");
+         if (estimate)
+            return y;
+         llvm::Value * xyy = bld.CreateFMul(bld.CreateFMul(x, y), y, "rsqrt.xyy");
+         llvm::Value * s = bld.CreateFSub(llvm_imm(type, 3), xyy, "rsqrt.sub");
+         return bld.CreateFMul(bld.CreateFMul(y, llvm_imm(type, 0.5)), s, "rsqrt.nr");
+      }
+      if (USE_NEON_INTRINSICS && (is_vec_width(type, 4) || is_vec_width(type, 2))) {
+         llvm::Value * y = bld.CreateCall(llvm_declare(llvm_overload_name("llvm.arm.neon.vrsqrte", type).c_str(),
+                                                       type, type), x, "vrsqrte");
+         if (estimate)
+            return y;
+         // vrsqrts(a, b) computes (3 - a * b) / 2
+         llvm::Value * s = bld.CreateCall2(llvm_declare(llvm_overload_name("llvm.arm.neon.vrsqrts", type).c_str(),
+                                                        type, type, type),
+                                           bld.CreateFMul(x, y), y, "vrsqrts");
+         return bld.CreateFMul(y, s, "rsqrt.nr");
+      }
+      return bld.CreateFDiv(llvm_imm(type, 1), llvm_intrinsic_unop(ir_unop_sqrt, x), "rsqrt.rcp");
+   }
+
+   // a / b, or a * rcp(b) from the 12 bit hardware estimate when estimate is set
+   llvm::Value* create_fdiv(llvm::Value * a, llvm::Value * b, const bool estimate)
+   {
+      llvm::Type * type = b->getType();
+      if (estimate && USE_SSE_INTRINSICS && is_vec_width(type, 4))
+         return bld.CreateFMul(a, bld.CreateCall(llvm_declare("llvm.x86.sse.rcp.ps", type, type),
+                                                 b, "rcpps"), "fdiv.rcp");
+      if (estimate && USE_NEON_INTRINSICS && (is_vec_width(type, 4) || is_vec_width(type, 2)))
+         return bld.CreateFMul(a, bld.CreateCall(llvm_declare(llvm_overload_name("llvm.arm.neon.vrecpe", type).c_str(),
+                                                              type, type), b, "vrecpe"), "fdiv.rcp");
+      return bld.CreateFDiv(a, b);
+   }
+
+   // reducedPrecision lets mediump use bare hardware estimates
+   bool use_estimate(ir_expression * ir)
+   {
+      return reducedPrecision && ir_precision_medium == expression_precision(ir);
+   }
+
+   // an operation runs at the highest precision among its operands
+   static unsigned merge_precision(unsigned a, unsigned b)
+   {
+      if (ir_precision_undefined == a)
+         return b;
+      if (ir_precision_undefined == b)
+         return a;
+      return a < b ? a : b;
+   }
+
+   unsigned variable_precision(ir_variable * var)
+   {
+      if (ir_precision_undefined != var->precision)
+         return var->precision;
+      std::map<ir_variable *, unsigned>::iterator it = precisions.find(var);
+      if (precisions.end() != it)
+         return it->second;
+      return ir_precision_undefined;
+   }
+
+   // precision of the variables an rvalue reads; constants do not constrain it
+   unsigned rvalue_precision(ir_rvalue * rvalue)
+   {
+      switch (rvalue->ir_type) {
+      case ir_type_dereference_variable:
+         return variable_precision(((ir_dereference_variable *)rvalue)->var);
+      case ir_type_dereference_array:
+         return rvalue_precision(((ir_dereference_array *)rvalue)->array);
+      case ir_type_dereference_record:
+         return rvalue_precision(((ir_dereference_record *)rvalue)->record);
+      case ir_type_swizzle:
+         return rvalue_precision(((ir_swizzle *)rvalue)->val);
+      case ir_type_texture:
+         return rvalue_precision(((ir_texture *)rvalue)->sampler);
+      case ir_type_expression: {
+         ir_expression * expr = (ir_expression *)rvalue;
+         unsigned precision = ir_precision_undefined;
+         for (unsigned i = 0; i < expr->get_num_operands(); i++)
+            precision = merge_precision(precision, rvalue_precision(expr->operands[i]));
+         return precision;
+      }
+      default:
+         return ir_precision_undefined;
+      }
+   }
+
+   unsigned expression_precision(ir_expression * expr)
+   {
+      const unsigned precision = rvalue_precision(expr);
+      return ir_precision_undefined == precision ? (unsigned)ir_precision_high : precision;
+   }
+
+   // c[0] + c[1] * x + c[2] * x^2 ... by Horner's scheme
+   llvm::Value* create_polynomial(llvm::Value * x, const double * c, unsigned count)
+   {
+      llvm::Type * type = x->getType();
+      llvm::Value * res = llvm_imm(type, c[count - 1]);
+      for (int i = count - 2; i >= 0; i--)
+         res = bld.CreateFAdd(bld.CreateFMul(res, x), llvm_imm(type, c[i]), "poly");
+      return res;
+   }
+
+   // the transcendentals below are inline polynomials on whole vectors with the
+   // degree picked by precision; GLSL leaves their accuracy undefined and the
+   // highp variants have errors around 1e-6
+
+   // 2^x = 2^floor(x) * 2^fract(x), the integer part goes into the exponent bits
+   llvm::Value* create_exp2(llvm::Value * x, unsigned precision)
+   {
+      static const double lowp[] = {1.0017247, 6.5763628e-1, 3.3718944e-1};
+      static const double mediump[] = {9.9992520e-1, 6.9583356e-1, 2.2606716e-1, 7.8024521e-2};
+      static const double highp[] = {9.9999994e-1, 6.9315308e-1, 2.4015361e-1,
+                                     5.5826318e-2, 8.9893397e-3, 1.8775767e-3};
+      llvm::Type * type = x->getType();
+      llvm::Type * intType = llvm_int_type(type);
+
+      x = create_fmin(create_fmax(x, llvm_imm(type, -127)), llvm_imm(type, 127.99999));
+      llvm::Value * ipart = create_floor(x);
+      llvm::Value * fpart = bld.CreateFSub(x, ipart, "exp2.fract");
+      llvm::Value * expo = bld.CreateFPToSI(ipart, intType, "exp2.fptosi");
+      expo = bld.CreateShl(bld.CreateAdd(expo, llvm_imm(intType, 127)), llvm_imm(intType, 23));
+      llvm::Value * scale = bld.CreateBitCast(expo, type, "exp2.ipart");
+
+      llvm::Value * poly = NULL;
+      if (ir_precision_low == precision)
+         poly = create_polynomial(fpart, lowp, sizeof(lowp) / sizeof(*lowp));
+      else if (ir_precision_medium == precision)
+         poly = create_polynomial(fpart, mediump, sizeof(mediump) / sizeof(*mediump));
+      else
+         poly = create_polynomial(fpart, highp, sizeof(highp) / sizeof(*highp));
+      return bld.CreateFMul(scale, poly, "exp2");
+   }
+
+   // log2(x) = exponent + log2(mantissa), with log2(m) ~ p(m) * (m - 1) for m in [1, 2)
+   llvm::Value* create_log2(llvm::Value * x, unsigned precision)
+   {
+      static const double lowp[] = {2.61761038894603480148, -1.75647175389045657003,
+                                    0.688243882994381274313, -0.107254423828329604454};
+      static const double mediump[] = {2.8882704548164776201, -2.52074962577807006663,
+                                       1.48116647521213171641, -0.465725644288844778798,
+                                       0.0596515482674574969533};
+      static const double highp[] = {3.1157899, -3.3241990, 2.5988452,
+                                     -1.2315303, 3.1821337e-1, -3.4436006e-2};
+      llvm::Type * type = x->getType();
+      llvm::Type * intType = llvm_int_type(type);
+
+      llvm::Value * bits = bld.CreateBitCast(x, intType);
+      llvm::Value * expo = bld.CreateAnd(bld.CreateLShr(bits, llvm_imm(intType, 23)), llvm_imm(intType, 255));
+      expo = bld.CreateSIToFP(bld.CreateSub(expo, llvm_imm(intType, 127)), type, "log2.expo");
+      llvm::Value * mant = bld.CreateOr(bld.CreateAnd(bits, llvm_imm(intType, 0x007fffff)),
+                                        llvm_imm(intType, 0x3f800000));
+      mant = bld.CreateBitCast(mant, type, "log2.mant");
+
+      llvm::Value * poly = NULL;
+      if (ir_precision_low == precision)
+         poly = create_polynomial(mant, lowp, sizeof(lowp) / sizeof(*lowp));
+      else if (ir_precision_medium == precision)
+         poly = create_polynomial(mant, mediump, sizeof(mediump) / sizeof(*mediump));
+      else
+         poly = create_polynomial(mant, highp, sizeof(highp) / sizeof(*highp));
+      poly = bld.CreateFMul(poly, bld.CreateFSub(mant, llvm_imm(type, 1)));
+      return bld.CreateFAdd(poly, expo, "log2");
+   }
+
+   // sin(2 * pi * t), t in turns so range reduction is a single floor
+   llvm::Value* create_sin_turns(llvm::Value * t, unsigned precision)
+   {
+      llvm::Type * type = t->getType();
+      // [-0.5, 0.5] turns
+      t = bld.CreateFSub(t, create_floor(bld.CreateFAdd(t, llvm_imm(type, 0.5))), "sin.reduce");
+
+      if (ir_precision_low == precision) {
+         // parabola through zeros and extremes, then one correction step, max error ~0.001
+         llvm::Value * y = bld.CreateFMul(t, bld.CreateFSub(llvm_imm(type, 8),
+                                          bld.CreateFMul(create_fabs(t), llvm_imm(type, 16))));
+         llvm::Value * yy = bld.CreateFSub(bld.CreateFMul(y, create_fabs(y)), y);
+         return bld.CreateFAdd(bld.CreateFMul(yy, llvm_imm(type, 0.225)), y, "sin.lowp");
+      }
+
+      // fold into [-0.25, 0.25] turns where the odd Taylor series converges fast
+      t = create_select(bld.CreateFCmpOGT(t, llvm_imm(type, 0.25)),
+                        bld.CreateFSub(llvm_imm(type, 0.5), t), t, "sin.fold");
+      t = create_select(bld.CreateFCmpOLT(t, llvm_imm(type, -0.25)),
+                        bld.CreateFSub(llvm_imm(type, -0.5), t), t, "sin.fold");
+      llvm::Value * x = bld.CreateFMul(t, llvm_imm(type, 2 * M_PI));
+      llvm::Value * x2 = bld.CreateFMul(x, x);
+
+      static const double taylor[] = {1.0, -1.0 / 6, 1.0 / 120, -1.0 / 5040,
+                                      1.0 / 362880, -1.0 / 39916800};
+      // truncation error at pi/2: 1.6e-4 after x^7, 5.7e-8 after x^11
+      const unsigned terms = ir_precision_medium == precision ? 4 : 6;
+      return bld.CreateFMul(x, create_polynomial(x2, taylor, terms), "sin");
+   }
+
+   // reducedPrecision keeps lowp float math in 8.8 fixed point i16 lanes, which
+   // covers the lowp range of (-2, 2) at 2^-8 precision with headroom to spare;
+   // values leave fixed point only where an unsupported operation needs them
+
+   llvm::Type* llvm_fixed_type(const glsl_type * type)
+   {
+      if (type->vector_elements > 1)
+         return llvm::VectorType::get(bld.getInt16Ty(), type->vector_elements);
+      return bld.getInt16Ty();
+   }
+
+   llvm::Type* llvm_wide_type(llvm::Type * type)
+   {
+      if (type->isVectorTy())
+         return llvm::VectorType::get(bld.getInt32Ty(), ((llvm::VectorType*)type)->getNumElements());
+      return bld.getInt32Ty();
+   }
+
+   llvm::Value* float_to_fixed(llvm::Value * x, const glsl_type * type)
+   {
+      x = create_fmin(create_fmax(x, llvm_imm(x->getType(), -127.99)), llvm_imm(x->getType(), 127.99));
+      x = bld.CreateFPToSI(bld.CreateFMul(x, llvm_imm(x->getType(), 256)), llvm_int_type(x->getType()));
+      return bld.CreateTrunc(x, llvm_fixed_type(type), "fixed");
+   }
+
+   llvm::Value* fixed_to_float(llvm::Value * x, const glsl_type * type)
+   {
+      llvm::Type * floatType = llvm_type(type);
+      x = bld.CreateSIToFP(x, floatType);
+      return bld.CreateFMul(x, llvm_imm(floatType, 1 / 256.0), "unfixed");
+   }
+
+   // [0, 255] to [0, 256] so that 255 is exactly 1.0
+   llvm::Value* fixed8_to_fixed(llvm::Value * x, const glsl_type * type)
+   {
+      x = bld.CreateTrunc(x, llvm_fixed_type(type));
+      return bld.CreateAdd(x, bld.CreateLShr(x, llvm_imm(x->getType(), 7)), "fixed");
+   }
+
+   // rounded x * 255 / 256, the exact inverse of fixed8_to_fixed
+   llvm::Value* fixed_to_fixed8(llvm::Value * x)
    {
-      if (1 == width)
-         return bld.CreateSelect(cond, tru, fal, name);
+      llvm::Type * type = x->getType();
+      x = create_select(bld.CreateICmpSLT(x, llvm_imm(type, 0)), llvm_imm(type, 0), x);
+      x = create_select(bld.CreateICmpSGT(x, llvm_imm(type, 256)), llvm_imm(type, 256), x);
+      llvm::Type * wideType = llvm_wide_type(type);
+      x = bld.CreateMul(bld.CreateZExt(x, wideType), llvm_imm(wideType, 255));
+      x = bld.CreateAdd(x, llvm_imm(wideType, 128));
+      return bld.CreateLShr(x, llvm_imm(wideType, 8), "fixed8");
+   }
 
-      llvm::Type * vectorType = tru->getType();
-      llvm::Value * vector = llvm::Constant::getNullValue(vectorType);
-      for (unsigned int i = 0; i < width; i++) {
-         llvm::Value * c = bld.CreateExtractElement(cond, llvm_int(i));
-         llvm::Value * t = bld.CreateExtractElement(tru, llvm_int(i));
-         llvm::Value * f = bld.CreateExtractElement(fal, llvm_int(i));
-         llvm::Value * v = bld.CreateSelect(c, t, f, name);
-         vector = bld.CreateInsertElement(vector, v, llvm_int(i), "vslct");
+   // same conversion GenerateFSBlend does for float colors
+   llvm::Value* float_to_fixed8(llvm::Value * x)
+   {
+      x = bld.CreateFMul(x, llvm_imm(x->getType(), 255));
+      x = bld.CreateFPToSI(x, llvm_int_type(x->getType()));
+      llvm::Type * type = x->getType();
+      x = create_select(bld.CreateICmpSLT(x, llvm_imm(type, 0)), llvm_imm(type, 0), x);
+      return create_select(bld.CreateICmpSGT(x, llvm_imm(type, 255)), llvm_imm(type, 255), x, "fixed8");
+   }
+
+   static bool is_fixed_operation(ir_expression_operation op)
+   {
+      switch (op) {
+      case ir_unop_neg:
+      case ir_binop_add:
+      case ir_binop_sub:
+      case ir_binop_mul:
+      case ir_binop_min:
+      case ir_binop_max:
+         return true;
+      default:
+         return false;
       }
-      return vector;
+   }
+
+   static bool is_float_vector(const glsl_type * type)
+   {
+      return GLSL_TYPE_FLOAT == type->base_type && (type->is_scalar() || type->is_vector());
+   }
+
+   bool use_fixed(ir_expression * ir)
+   {
+      if (!reducedPrecision || !is_fixed_operation(ir->operation) || !is_float_vector(ir->type))
+         return false;
+      for (unsigned i = 0; i < ir->get_num_operands(); i++)
+         if (!is_float_vector(ir->operands[i]->type))
+            return false;
+      return ir_precision_low == expression_precision(ir);
+   }
+
+   // gl_FragColor is handed to the scanline as GGL_CHANNEL_FIXED8 in reducedPrecision,
+   // GenerateScanLine makes the same decision
+   bool is_fixed8_color(ir_variable * var)
+   {
+      return reducedPrecision && ir_var_out == var->mode && !strcmp("gl_FragColor", var->name);
+   }
+
+   llvm::Value* llvm_fixed(ir_rvalue * rvalue)
+   {
+      const glsl_type * type = rvalue->type;
+      switch (rvalue->ir_type) {
+      case ir_type_constant: {
+         ir_constant * constant = (ir_constant *)rvalue;
+         std::vector<llvm::Constant*> values;
+         for (unsigned i = 0; i < type->vector_elements; i++) {
+            float f = constant->value.f[i] * 256;
+            f = f < -32768 ? -32768 : f > 32767 ? 32767 : f;
+            values.push_back(bld.getInt16((int)f));
+         }
+         if (1 == values.size())
+            return values[0];
+         return llvm::ConstantVector::get(values);
+      }
+      case ir_type_swizzle: {
+         ir_swizzle * swz = (ir_swizzle *)rvalue;
+         int mask[4] = {swz->mask.x, swz->mask.y, swz->mask.z, swz->mask.w};
+         return llvm_shuffle(llvm_fixed(swz->val), mask, swz->mask.num_components, "swizzle");
+      }
+      case ir_type_texture: {
+         ir_texture * tex = (ir_texture *)rvalue;
+         llvm::Value * texel = llvm_texture(tex, GGL_CHANNEL_FIXED8);
+         if (texel)
+            return fixed8_to_fixed(texel, type);
+         break;
+      }
+      case ir_type_expression: {
+         ir_expression * ir = (ir_expression *)rvalue;
+         if (!use_fixed(ir))
+            break;
+         llvm::Value * ops[2];
+         for (unsigned i = 0; i < ir->get_num_operands(); i++)
+            ops[i] = llvm_fixed(ir->operands[i]);
+         if (2 == ir->get_num_operands())
+            for (unsigned i = 0; i < 2; i++)
+               if (ir->operands[i]->type->vector_elements < type->vector_elements) {
+                  int mask[4] = {0, 0, 0, 0};
+                  ops[i] = llvm_shuffle(ops[i], mask, type->vector_elements, "sca2vec");
+               }
+
+         switch (ir->operation) {
+         case ir_unop_neg:
+            return bld.CreateNeg(ops[0]);
+         case ir_binop_add:
+            return bld.CreateAdd(ops[0], ops[1]);
+         case ir_binop_sub:
+            return bld.CreateSub(ops[0], ops[1]);
+         case ir_binop_mul: {
+            llvm::Type * wideType = llvm_wide_type(ops[0]->getType());
+            llvm::Value * product = bld.CreateMul(bld.CreateSExt(ops[0], wideType),
+                                                  bld.CreateSExt(ops[1], wideType));
+            product = bld.CreateAShr(product, llvm_imm(wideType, 8));
+            return bld.CreateTrunc(product, ops[0]->getType(), "fixed.mul");
+         }
+         case ir_binop_min:
+            return create_select(bld.CreateICmpSLT(ops[0], ops[1]), ops[0], ops[1], "fixed.min");
+         case ir_binop_max:
+            return create_select(bld.CreateICmpSGT(ops[0], ops[1]), ops[0], ops[1], "fixed.max");
+         default:
+            assert(0);
+         }
+      }
+      default:
+         break;
+      }
+      return float_to_fixed(llvm_value(rvalue), type);
    }
 
    llvm::Value* create_dot_product(llvm::Value* ops0, llvm::Value* ops1, glsl_base_type type, unsigned width)
@@ -550,13 +1213,10 @@ public:
          case GLSL_TYPE_BOOL:
             return ops[0];
          case GLSL_TYPE_INT:
-            return create_select(ir->operands[0]->type->vector_elements,
-                                 bld.CreateICmpSGE(ops[0], llvm_imm(ops[0]->getType(), 0), "sabs.ge"),
+            return create_select(bld.CreateICmpSGE(ops[0], llvm_imm(ops[0]->getType(), 0), "sabs.ge"),
                                  ops[0], bld.CreateNeg(ops[0], "sabs.neg"), "sabs.select");
          case GLSL_TYPE_FLOAT:
-            return create_select(ir->operands[0]->type->vector_elements,
-                                 bld.CreateFCmpUGE(ops[0], llvm_imm(ops[0]->getType(), 0), "fabs.ge"),
-                                 ops[0], bld.CreateFNeg(ops[0], "fabs.neg"), "fabs.select");
+            return create_fabs(ops[0]);
          default:
             assert(0);
          }
@@ -579,15 +1239,30 @@ public:
          }
       case ir_unop_rcp:
          assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-         return bld.CreateFDiv(llvm_imm(ops[0]->getType(), 1), ops[0]);
-      case ir_unop_exp: // fall through
-      case ir_unop_exp2: // fall through
-      case ir_unop_log: // fall through
-      case ir_unop_log2: // fall through
-      case ir_unop_sin: // fall through
+         return create_fdiv(llvm_imm(ops[0]->getType(), 1), ops[0], use_estimate(ir));
+      case ir_unop_exp:
+         assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+         return create_exp2(bld.CreateFMul(ops[0], llvm_imm(ops[0]->getType(), M_LOG2E)),
+                            expression_precision(ir));
+      case ir_unop_exp2:
+         assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+         return create_exp2(ops[0], expression_precision(ir));
+      case ir_unop_log:
+         assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+         return bld.CreateFMul(create_log2(ops[0], expression_precision(ir)),
+                               llvm_imm(ops[0]->getType(), M_LN2), "log");
+      case ir_unop_log2:
+         assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+         return create_log2(ops[0], expression_precision(ir));
+      case ir_unop_sin:
+         assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+         return create_sin_turns(bld.CreateFMul(ops[0], llvm_imm(ops[0]->getType(), 0.5 * M_1_PI)),
+                                 expression_precision(ir));
       case ir_unop_cos:
          assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-         return llvm_intrinsic_unop(ir->operation, ops[0]);
+         return create_sin_turns(bld.CreateFAdd(bld.CreateFMul(ops[0], llvm_imm(ops[0]->getType(), 0.5 * M_1_PI)),
+                                                llvm_imm(ops[0]->getType(), 0.25)),
+                                 expression_precision(ir));
          // TODO: implement these somehow
       case ir_unop_dFdx:
          assert(0);
@@ -656,7 +1331,7 @@ public:
          case GLSL_TYPE_INT:
             return bld.CreateSDiv(ops[0], ops[1]);
          case GLSL_TYPE_FLOAT:
-            return bld.CreateFDiv(ops[0], ops[1]);
+            return create_fdiv(ops[0], ops[1], use_estimate(ir));
          default:
             assert(0);
          }
@@ -783,7 +1458,7 @@ public:
          return llvm_intrinsic_unop(ir->operation, ops[0]);
       case ir_unop_rsq:
          assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-         return bld.CreateFDiv(llvm_imm(ops[0]->getType(), 1), llvm_intrinsic_unop(ir_unop_sqrt, ops[0]), "rsqrt.rcp");
+         return create_rsqrt(ops[0], use_estimate(ir));
       case ir_unop_i2f:
          return bld.CreateSIToFP(ops[0], llvm_type(ir->type));
       case ir_unop_u2f:
@@ -798,34 +1473,27 @@ public:
       case ir_unop_i2b:
          return bld.CreateICmpNE(ops[0], llvm_imm(ops[0]->getType(), 0));
       case ir_unop_trunc:
-      {
          if(ir->operands[0]->type->base_type != GLSL_TYPE_FLOAT)
             return ops[0];
-         glsl_type int_type = *ir->operands[0]->type;
-         int_type.base_type = GLSL_TYPE_INT;
-         return bld.CreateSIToFP(bld.CreateFPToSI(ops[0], llvm_type(&int_type), "trunc.fptosi"),ops[0]->getType(), "trunc.sitofp");
-      }
+         if (USE_SSE41_INTRINSICS && is_vec_width(ops[0]->getType(), 4))
+            return create_sse41_round(ops[0], 3);
+         return create_trunc(ops[0]);
       case ir_unop_floor:
-      {
          if(ir->operands[0]->type->base_type != GLSL_TYPE_FLOAT)
             return ops[0];
-         llvm::Value* one = llvm_imm(ops[0]->getType(), 1);
-         return bld.CreateFSub(ops[0], bld.CreateFRem(ops[0], one));
-      }
+         return create_floor(ops[0]);
       case ir_unop_ceil:
-      {
          if(ir->operands[0]->type->base_type != GLSL_TYPE_FLOAT)
             return ops[0];
-         llvm::Value* one = llvm_imm(ops[0]->getType(), 1);
-         return bld.CreateFAdd(bld.CreateFSub(ops[0], bld.CreateFRem(ops[0], one)), one);
-      }
+         return create_ceil(ops[0]);
+      case ir_unop_round_even:
+         if(ir->operands[0]->type->base_type != GLSL_TYPE_FLOAT)
+            return ops[0];
+         return create_round_even(ops[0]);
       case ir_unop_fract:
-      {
          if(ir->operands[0]->type->base_type != GLSL_TYPE_FLOAT)
             return llvm_imm(ops[0]->getType(), 0);
-         llvm::Value* one = llvm_imm(ops[0]->getType(), 1);
-         return bld.CreateFRem(ops[0], one);
-      }
+         return bld.CreateFSub(ops[0], create_floor(ops[0]), "fract");
       // TODO: NaNs might be wrong in min/max, not sure how to fix it
       case ir_binop_min:
          switch(ir->operands[0]->type->base_type)
@@ -837,7 +1505,7 @@ public:
          case GLSL_TYPE_INT:
             return bld.CreateSelect(bld.CreateICmpSLE(ops[0], ops[1], "smin.le"), ops[0], ops[1], "smin.select");
          case GLSL_TYPE_FLOAT:
-            return bld.CreateSelect(bld.CreateFCmpULE(ops[0], ops[1], "fmin.le"), ops[0], ops[1], "fmin.select");
+            return create_fmin(ops[0], ops[1]);
          default:
             assert(0);
          }
@@ -851,14 +1519,15 @@ public:
          case GLSL_TYPE_INT:
             return bld.CreateSelect(bld.CreateICmpSGE(ops[0], ops[1], "smax.ge"), ops[0], ops[1], "smax.select");
          case GLSL_TYPE_FLOAT:
-            return bld.CreateSelect(bld.CreateFCmpUGE(ops[0], ops[1], "fmax.ge"), ops[0], ops[1], "fmax.select");
+            return create_fmax(ops[0], ops[1]);
          default:
             assert(0);
          }
       case ir_binop_pow:
          assert(GLSL_TYPE_FLOAT == ir->operands[0]->type->base_type);
          assert(GLSL_TYPE_FLOAT == ir->operands[1]->type->base_type);
-         return llvm_intrinsic_binop(ir_binop_pow, ops[0], ops[1]);
+         return create_exp2(bld.CreateFMul(ops[1], create_log2(ops[0], expression_precision(ir))),
+                            expression_precision(ir));
       case ir_unop_bit_not:
          return bld.CreateNot(ops[0]);
       case ir_binop_bit_and:
@@ -898,12 +1567,18 @@ public:
 
    virtual void visit(class ir_expression * ir)
    {
-      result = llvm_expression(ir);
+      if (use_fixed(ir))
+         result = fixed_to_float(llvm_fixed(ir), ir->type);
+      else
+         result = llvm_expression(ir);
    }
 
    virtual void visit(class ir_dereference_array *ir)
    {
-      result = bld.CreateLoad(llvm_pointer(ir));
+      if (ir->array->type->is_vector())
+         result = bld.CreateExtractElement(llvm_value(ir->array), llvm_value(ir->array_index));
+      else
+         result = bld.CreateLoad(llvm_pointer(ir));
    }
 
    virtual void visit(class ir_dereference_record *ir)
@@ -913,10 +1588,15 @@ public:
 
    virtual void visit(class ir_dereference_variable *ir)
    {
-      result = bld.CreateLoad(llvm_pointer(ir), ir->variable_referenced()->name);
+      result = load_variable(ir->variable_referenced());
+      if (is_fixed8_color(ir->variable_referenced())) {
+         result = bld.CreateBitCast(result, llvm_int_type(result->getType()));
+         result = bld.CreateFMul(bld.CreateSIToFP(result, llvm_type(ir->type)),
+                                 llvm_imm(llvm_type(ir->type), 1 / 255.0), "unfixed8");
+      }
    }
 
-   virtual void visit(class ir_texture * ir)
+   llvm::Value* llvm_texture(ir_texture * ir, const GGLChannelType dstType)
    {
       llvm::Value * coordinate = llvm_value(ir->coordinate);
       if (ir->projector)
@@ -935,7 +1615,7 @@ public:
       else if(ir_dereference_array* deref = ir->sampler->as_dereference_array())
       {
          assert(0); // not implemented
-         return;
+         return NULL;
          deref->array_index;
          deref->array;
       }
@@ -960,11 +1640,17 @@ public:
          sampler->type->sampler_dimensionality, sampler->type->sampler_type,
          ir->projector ? 1 : 0, ir->lod_info.lod ? 1 : 0);
       if (GLSL_SAMPLER_DIM_CUBE == sampler->type->sampler_dimensionality)
-         result = texCube(bld, coordinate, sampler->location, gglCtx);
+         return texCube(bld, coordinate, sampler->location, gglCtx, dstType);
       else if (GLSL_SAMPLER_DIM_2D == sampler->type->sampler_dimensionality)
-         result = tex2D(bld, coordinate, sampler->location, gglCtx);
+         return tex2D(bld, coordinate, sampler->location, gglCtx, dstType);
       else
          assert(0);
+      return NULL;
+   }
+
+   virtual void visit(class ir_texture * ir)
+   {
+      result = llvm_texture(ir, GGL_CHANNEL_FLOAT);
    }
 
    virtual void visit(class ir_discard * ir)
@@ -981,6 +1667,8 @@ public:
          after = llvm::BasicBlock::Create(ctx, "dead_code.discard", fun);
          bld.CreateBr(discard);
       }
+      seal_block(discard);
+      seal_block(after);
 
       bld.SetInsertPoint(discard);
 
@@ -1013,47 +1701,64 @@ public:
       bld.CreateBr(target);
 
       bb = llvm::BasicBlock::Create(ctx, "dead_code.jump", fun);
+      seal_block(bb);
       bld.SetInsertPoint(bb);
    }
 
+   /** the terminating condition set_loop_controls stored in ir_loop::cmp */
+   llvm::Value* llvm_loop_exit(int cmp, const glsl_type * type, llvm::Value* counter, llvm::Value* to)
+   {
+      if (GLSL_TYPE_FLOAT == type->base_type)
+         switch (cmp) {
+         case ir_binop_less: return bld.CreateFCmpOLT(counter, to, "loop.exit");
+         case ir_binop_greater: return bld.CreateFCmpOGT(counter, to, "loop.exit");
+         case ir_binop_lequal: return bld.CreateFCmpOLE(counter, to, "loop.exit");
+         case ir_binop_gequal: return bld.CreateFCmpOGE(counter, to, "loop.exit");
+         }
+      else if (GLSL_TYPE_INT == type->base_type)
+         switch (cmp) {
+         case ir_binop_less: return bld.CreateICmpSLT(counter, to, "loop.exit");
+         case ir_binop_greater: return bld.CreateICmpSGT(counter, to, "loop.exit");
+         case ir_binop_lequal: return bld.CreateICmpSLE(counter, to, "loop.exit");
+         case ir_binop_gequal: return bld.CreateICmpSGE(counter, to, "loop.exit");
+         }
+      else
+         switch (cmp) {
+         case ir_binop_less: return bld.CreateICmpULT(counter, to, "loop.exit");
+         case ir_binop_greater: return bld.CreateICmpUGT(counter, to, "loop.exit");
+         case ir_binop_lequal: return bld.CreateICmpULE(counter, to, "loop.exit");
+         case ir_binop_gequal: return bld.CreateICmpUGE(counter, to, "loop.exit");
+         }
+      assert(0);
+      return bld.getTrue();
+   }
+
    virtual void visit(class ir_loop * ir)
    {
       llvm::BasicBlock* body = llvm::BasicBlock::Create(ctx, "loop", fun);
       llvm::BasicBlock* header = body;
       llvm::BasicBlock* after = llvm::BasicBlock::Create(ctx, "loop.after", fun);
-      llvm::Value* ctr;
 
       if(ir->counter)
       {
-         ctr = llvm_variable(ir->counter);
          if(ir->from)
-            bld.CreateStore(llvm_value(ir->from), ctr);
+            store_variable(ir->counter, llvm_value(ir->from));
          if(ir->to)
             header = llvm::BasicBlock::Create(ctx, "loop.header", fun);
       }
 
       bld.CreateBr(header);
 
+      // counted loop from set_loop_controls: the if-break it removed from the
+      // body becomes the header test, so the counter stays in a register and
+      // the trip count is visible to LLVM
       if(ir->counter && ir->to)
       {
          bld.SetInsertPoint(header);
-         llvm::Value* cond;
-         llvm::Value* load = bld.CreateLoad(ctr);
+         llvm::Value* counter = load_variable(ir->counter);
          llvm::Value* to = llvm_value(ir->to);
-         switch(ir->counter->type->base_type)
-         {
-         case GLSL_TYPE_BOOL:
-         case GLSL_TYPE_UINT:
-            cond = bld.CreateICmpULT(load, to);
-            break;
-         case GLSL_TYPE_INT:
-            cond = bld.CreateICmpSLT(load, to);
-            break;
-         case GLSL_TYPE_FLOAT:
-            cond = bld.CreateFCmpOLT(load, to);
-            break;
-         }
-         bld.CreateCondBr(cond, body, after);
+         bld.CreateCondBr(llvm_loop_exit(ir->cmp, ir->counter->type, counter, to), after, body);
+         seal_block(body);
       }
 
       bld.SetInsertPoint(body);
@@ -1063,21 +1768,10 @@ public:
       visit_exec_list(&ir->body_instructions, this);
       loop = saved_loop;
 
-      if(ir->counter && ir->increment)
-      {
-         switch(ir->counter->type->base_type)
-         {
-         case GLSL_TYPE_BOOL:
-         case GLSL_TYPE_UINT:
-         case GLSL_TYPE_INT:
-            bld.CreateStore(bld.CreateAdd(bld.CreateLoad(ctr), llvm_value(ir->increment)), ctr);
-            break;
-         case GLSL_TYPE_FLOAT:
-            bld.CreateStore(bld.CreateFAdd(bld.CreateLoad(ctr), llvm_value(ir->increment)), ctr);
-            break;
-         }
-      }
+      // ir->increment is only informational, the body still steps the counter
       bld.CreateBr(header);
+      seal_block(header);
+      seal_block(after);
 
       bb = after;
       bld.SetInsertPoint(bb);
@@ -1089,6 +1783,8 @@ public:
       llvm::BasicBlock* bbf = llvm::BasicBlock::Create(ctx, "else", fun);
       llvm::BasicBlock* bbe = llvm::BasicBlock::Create(ctx, "endif", fun);
       bld.CreateCondBr(llvm_value(ir->condition), bbt, bbf);
+      seal_block(bbt);
+      seal_block(bbf);
 
       bld.SetInsertPoint(bbt);
       visit_exec_list(&ir->then_instructions, this);
@@ -1097,6 +1793,7 @@ public:
       bld.SetInsertPoint(bbf);
       visit_exec_list(&ir->else_instructions, this);
       bld.CreateBr(bbe);
+      seal_block(bbe);
 
       bb = bbe;
       bld.SetInsertPoint(bb);
@@ -1110,6 +1807,7 @@ public:
          bld.CreateRet(llvm_value(ir->value));
 
       bb = llvm::BasicBlock::Create(ctx, "dead_code.return", fun);
+      seal_block(bb);
       bld.SetInsertPoint(bb);
    }
 
@@ -1123,7 +1821,14 @@ public:
          args.push_back(llvm_value(arg));
       }
 
-      result = bld.CreateCall(llvm_function(ir->get_callee()), llvm::ArrayRef<llvm::Value*>(args));
+      llvm::Function * const function = llvm_function(ir->get_callee());
+      if (function->hasInternalLinkage()) {
+         args.push_back(inputs);
+         args.push_back(outputs);
+         args.push_back(constants);
+         args.push_back(globals);
+      }
+      result = bld.CreateCall(function, llvm::ArrayRef<llvm::Value*>(args));
 
       llvm::AttrListPtr attr;
       ((llvm::CallInst*)result)->setAttributes(attr);
@@ -1272,11 +1977,54 @@ public:
       result = llvm_shuffle(val, mask, swz->mask.num_components, "swizzle");
    }
 
-   virtual void visit(class ir_assignment * ir)
+   /** vec[index] = scalar, inserted into the whole vector */
+   void assign_component(ir_assignment * ir, ir_dereference_array * lhs)
    {
-      llvm::Value* lhs = llvm_pointer(ir->lhs);
+      llvm::Value* index = llvm_value(lhs->array_index);
+      llvm::Value* vector = llvm_value(lhs->array);
       llvm::Value* rhs = llvm_value(ir->rhs);
+      if (ir->condition)
+         rhs = bld.CreateSelect(llvm_value(ir->condition), rhs,
+                                bld.CreateExtractElement(vector, index), "assign.conditional");
+      vector = bld.CreateInsertElement(vector, rhs, index, "assign.component");
+
+      ir_variable * var = lhs->array->variable_referenced();
+      if (var && ir_precision_undefined == var->precision)
+         precisions[var] = merge_precision(variable_precision(var), rvalue_precision(ir->rhs));
+      if (var && is_fixed8_color(var))
+         vector = bld.CreateBitCast(float_to_fixed8(vector), llvm_type(lhs->array->type), "fixed8.store");
+      if (lhs->array->as_dereference_variable() && is_ssa(var))
+         store_variable(var, vector);
+      else
+         bld.CreateStore(vector, llvm_pointer(lhs->array));
+   }
+
+   virtual void visit(class ir_assignment * ir)
+   {
+      ir_dereference_array * component = ir->lhs->as_dereference_array();
+      if (component && component->array->type->is_vector()) {
+         assign_component(ir, component);
+         return;
+      }
+
+      ir_variable * var = ir->lhs->variable_referenced();
+      const bool ssa = ir->lhs->as_dereference_variable() && is_ssa(var);
+      llvm::Value* lhs = ssa ? NULL : llvm_pointer(ir->lhs);
+      llvm::Value* rhs = NULL;
       unsigned width = ir->lhs->type->vector_elements;
+
+      if (var && ir_precision_undefined == var->precision)
+         precisions[var] = merge_precision(variable_precision(var), rvalue_precision(ir->rhs));
+
+      if (var && is_fixed8_color(var)) {
+         // lowp colors go from fixed point to [0, 255] without a float round trip
+         if (is_float_vector(ir->rhs->type) && ir_precision_low == rvalue_precision(ir->rhs))
+            rhs = fixed_to_fixed8(llvm_fixed(ir->rhs));
+         else
+            rhs = float_to_fixed8(llvm_value(ir->rhs));
+         rhs = bld.CreateBitCast(rhs, llvm_type(ir->rhs->type), "fixed8.store");
+      } else
+         rhs = llvm_value(ir->rhs);
       unsigned mask = (1 << width) - 1;
       assert(rhs);
 
@@ -1309,18 +2057,23 @@ public:
             else
                blend_mask[i] = llvm_int(i);
          }
-         rhs = bld.CreateShuffleVector(bld.CreateLoad(lhs), rhs, llvm::ConstantVector::get(pack(blend_mask, width)), "assign.writemask");
+         rhs = bld.CreateShuffleVector(ssa ? load_variable(var) : bld.CreateLoad(lhs), rhs, llvm::ConstantVector::get(pack(blend_mask, width)), "assign.writemask");
       }
 
       if(ir->condition)
-         rhs = bld.CreateSelect(llvm_value(ir->condition), rhs, bld.CreateLoad(lhs), "assign.conditional");
+         rhs = bld.CreateSelect(llvm_value(ir->condition), rhs,
+                                ssa ? load_variable(var) : bld.CreateLoad(lhs), "assign.conditional");
 
-      bld.CreateStore(rhs, lhs);
+      if (ssa)
+         store_variable(var, rhs);
+      else
+         bld.CreateStore(rhs, lhs);
    }
 
    virtual void visit(class ir_variable * var)
    {
-      llvm_variable(var);
+      if (!is_ssa(var))
+         llvm_variable(var);
    }
 
    virtual void visit(ir_function_signature *sig)
@@ -1334,35 +2087,62 @@ public:
       bb = llvm::BasicBlock::Create(ctx, "entry", fun);
       bld.SetInsertPoint(bb);
 
+      // values of the previous function cannot be referenced from this one
+      for (llvm_variables_t::iterator it = llvm_variables.begin(); it != llvm_variables.end();)
+         if (llvm::isa<llvm::Instruction>(it->second) || llvm::isa<llvm::Argument>(it->second))
+            llvm_variables.erase(it++);
+         else
+            ++it;
+      ssaVariables.clear();
+      currentDefs.clear();
+      incompletePhis.clear();
+      sealedBlocks.clear();
+      seal_block(bb);
+
       llvm::Function::arg_iterator ai = fun->arg_begin();
-      if (!strcmp("main",sig->function_name()))
-      {
-         assert(3 == fun->arg_size());
-         bld.CreateStore(ai, inputsPtr);
-         inputs = ai;
-         ai++;
-         bld.CreateStore(ai, outputsPtr);
-         outputs = ai;
-         ai++;
-         bld.CreateStore(ai, constantsPtr);
-         constants = ai;
-         ai++;
-      }
-      else
+      const bool isMain = !strcmp("main",sig->function_name());
+      if (!isMain)
       {
          foreach_iter(exec_list_iterator, iter, sig->parameters) {
             ir_variable* arg = (ir_variable*)iter.get();
             ai->setName(arg->name);
-            bld.CreateStore(ai, llvm_variable(arg));
+            if (arg->type->is_scalar() || arg->type->is_vector()) {
+               ssaVariables.insert(arg);
+               write_variable(arg, bb, ai);
+            } else {
+               // copied in to an alloca rather than llvm_variable, which maps
+               // ir_var_in to the shader inputs
+               llvm::Value * v = bld.CreateAlloca(llvm_type(arg->type), 0, arg->name);
+               bld.CreateStore(ai, v);
+               llvm_variables[arg] = v;
+            }
             ++ai;
          }
-         inputs = bld.CreateLoad(inputsPtr);
-         outputs = bld.CreateLoad(outputsPtr);
-         constants = bld.CreateLoad(constantsPtr);
       }
+      inputs = ai++;
+      outputs = ai++;
+      constants = ai++;
       inputs->setName("gl_inputs");
       outputs->setName("gl_outputs");
       constants->setName("gl_constants");
+      if (isMain)
+      {
+         assert(3 == fun->arg_size());
+         globals = bld.CreateAlloca(globalsType, 0, "gl_globals");
+      }
+      else
+         globals = ai++;
+      globals->setName("gl_globals");
+      assert(fun->arg_end() == ai);
+
+      for (std::map<ir_variable *, unsigned>::iterator it = globalFields.begin();
+           it != globalFields.end(); ++it)
+      {
+         llvm::Value * field = bld.CreateStructGEP(globals, it->second, it->first->name);
+         llvm_variables[it->first] = field;
+         if (isMain && it->first->constant_value)
+            bld.CreateStore(llvm_constant(it->first->constant_value), field);
+      }
 
 
 
@@ -1397,6 +2177,7 @@ glsl_ir_to_llvm_module(struct exec_list *ir, llvm::Module * mod,
 {
    ir_to_llvm_visitor v(mod, gglCtx, shaderSuffix);
 
+   v.declare_globals(ir);
    visit_exec_list(ir, &v);
 
 //   mod->dump();
@@ -1411,3 +2192,89 @@ glsl_ir_to_llvm_module(struct exec_list *ir, llvm::Module * mod,
    return mod;
    //v.ir_to_llvm_emit_op1(NULL, OPCODE_END, ir_to_llvm_undef_dst, ir_to_llvm_undef);
 }
+
+// coordinate must be the .xy of an input varying
+static ir_variable * passthrough_texcoord(ir_rvalue * coordinate)
+{
+   if (ir_swizzle * swiz = coordinate->as_swizzle()) {
+      if (2 != swiz->mask.num_components || 0 != swiz->mask.x || 1 != swiz->mask.y)
+         return NULL;
+      coordinate = swiz->val;
+   } else if (2 != coordinate->type->vector_elements)
+      return NULL;
+   ir_dereference_variable * deref = coordinate->as_dereference_variable();
+   if (!deref || ir_var_in != deref->var->mode || !deref->type->is_float())
+      return NULL;
+   if (deref->var->location_frac) // packed behind another varying
+      return NULL;
+   return deref->var;
+}
+
+bool glsl_fragment_passthrough(struct exec_list * ir, GGLFragmentPassthrough * passthrough)
+{
+   memset(passthrough, 0, sizeof(*passthrough));
+   passthrough->type = GGLFragmentPassthrough::GGL_PASSTHROUGH_NONE;
+
+   ir_function_signature * main = NULL;
+   foreach_iter(exec_list_iterator, iter, *ir) {
+      ir_function * fun = ((ir_instruction *)iter.get())->as_function();
+      if (!fun || strcmp("main", fun->name))
+         continue;
+      foreach_iter(exec_list_iterator, sigIter, *fun) {
+         ir_function_signature * sig = (ir_function_signature *)sigIter.get();
+         if (sig->is_defined)
+            main = sig;
+      }
+   }
+   if (!main)
+      return false;
+
+   // declarations are fine, but the only statement must be the color write
+   ir_assignment * assign = NULL;
+   foreach_iter(exec_list_iterator, iter, main->body) {
+      ir_instruction * inst = (ir_instruction *)iter.get();
+      if (inst->as_variable())
+         continue;
+      if (assign || !inst->as_assignment())
+         return false;
+      assign = inst->as_assignment();
+   }
+   if (!assign || assign->condition || 0xf != assign->write_mask)
+      return false;
+   ir_dereference_variable * lhs = assign->lhs->as_dereference_variable();
+   if (!lhs || strcmp("gl_FragColor", lhs->var->name))
+      return false;
+
+   ir_rvalue * rhs = assign->rhs;
+   if (ir_type_texture == rhs->ir_type) {
+      ir_texture * tex = (ir_texture *)rhs;
+      if (ir_tex != tex->op || tex->projector || tex->shadow_comparitor)
+         return false;
+      ir_dereference_variable * sampler = tex->sampler->as_dereference_variable();
+      if (!sampler || GLSL_SAMPLER_DIM_2D != sampler->type->sampler_dimensionality)
+         return false;
+      ir_variable * texcoord = passthrough_texcoord(tex->coordinate);
+      if (!texcoord)
+         return false;
+      assert(sampler->var->location >= 0 && texcoord->location >= 0);
+      passthrough->type = GGLFragmentPassthrough::GGL_PASSTHROUGH_TEXTURE;
+      passthrough->sampler = sampler->var->location;
+      passthrough->location = texcoord->location;
+      return true;
+   } else if (ir_constant * constant = rhs->as_constant()) {
+      if (!constant->type->is_float())
+         return false;
+      for (unsigned i = 0; i < 4; i++)
+         passthrough->color[i] = constant->value.f[i];
+      passthrough->type = GGLFragmentPassthrough::GGL_PASSTHROUGH_CONSTANT;
+      return true;
+   } else if (ir_dereference_variable * deref = rhs->as_dereference_variable()) {
+      if (ir_var_uniform != deref->var->mode)
+         return false;
+      assert(deref->var->location >= 0);
+      passthrough->type = GGLFragmentPassthrough::GGL_PASSTHROUGH_UNIFORM;
+      passthrough->location = deref->var->location;
+      return true;
+   }
+   return false;
+}
@@ -4,6 +4,32 @@
 #include "llvm/Module.h"
 #include "ir.h"
 
+// representation of colors handed from texture sampling through the fragment
+// shader to blending; gl_FragColor is GGL_CHANNEL_FIXED8 when reducedPrecision is set
+enum GGLChannelType {
+   GGL_CHANNEL_FLOAT = 0, // <4 x float> [0.0, 1.0]
+   GGL_CHANNEL_FIXED8, // <4 x i32> [0, 255]
+   GGL_CHANNEL_PACKED8, // i32 RGBA_8888 texel, only from GL_NEAREST tex2D
+};
+
+// fragment shader that is only gl_FragColor = texture2D(sampler, varying.xy) or
+// gl_FragColor = constant; GenerateScanLine then skips the shader call and keeps
+// the color as integers from the texel fetch through blending to the store
+struct GGLFragmentPassthrough {
+   enum Type {
+      GGL_PASSTHROUGH_NONE = 0,
+      GGL_PASSTHROUGH_TEXTURE,
+      GGL_PASSTHROUGH_UNIFORM,
+      GGL_PASSTHROUGH_CONSTANT,
+   } type;
+   int sampler; // GGL_PASSTHROUGH_TEXTURE, sampler unit
+   int location; // texcoord varying location in VertexOutput, or uniform location
+   float color[4]; // GGL_PASSTHROUGH_CONSTANT
+};
+
+// returns false and GGL_PASSTHROUGH_NONE for anything else, ir is a linked fragment shader
+bool glsl_fragment_passthrough(struct exec_list * ir, GGLFragmentPassthrough * passthrough);
+
 struct llvm::Module * glsl_ir_to_llvm_module(struct exec_list *ir, llvm::Module * mod,
                const struct GGLState * gglCtx, const char * shaderSuffix);
 
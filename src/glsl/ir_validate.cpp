@@ -47,9 +47,11 @@ public:
 				 hash_table_pointer_compare);
 
       this->current_function = NULL;
+      this->abort_on_error = true;
+      this->failed = false;
 
       this->callback = ir_validate::validate_ir;
-      this->data = ht;
+      this->data = this;
    }
 
    ~ir_validate()
@@ -73,6 +75,23 @@ public:
 
    static void validate_ir(ir_instruction *ir, void *data);
 
+   /**
+    * Abort, or when validating IR that was not produced by the compiler,
+    * record the failure and stop the traversal
+    */
+   ir_visitor_status error()
+   {
+      if (this->abort_on_error)
+	 abort();
+      this->failed = true;
+      return visit_stop;
+   }
+
+   ir_visitor_status expression_error(ir_expression *ir, const char *check);
+
+   bool abort_on_error;
+   bool failed;
+
    ir_function *current_function;
 
    struct hash_table *ht;
@@ -85,14 +104,14 @@ ir_validate::visit(ir_dereference_variable *ir)
    if ((ir->var == NULL) || (ir->var->as_variable() == NULL)) {
       printf("ir_dereference_variable @ %p does not specify a variable %p\n",
 	     (void *) ir, (void *) ir->var);
-      abort();
+      return error();
    }
 
    if (hash_table_find(ht, ir->var) == NULL) {
       printf("ir_dereference_variable @ %p specifies undeclared variable "
 	     "`%s' @ %p\n",
 	     (void *) ir, ir->var->name, (void *) ir->var);
-      abort();
+      return error();
    }
 
    this->validate_ir(ir, this->data);
@@ -108,7 +127,7 @@ ir_validate::visit(ir_if *ir)
 	     ir->condition->type->name);
       ir->print();
       printf("\n");
-      abort();
+      return error();
    }
 
    return visit_continue;
@@ -127,12 +146,12 @@ ir_validate::visit_leave(ir_loop *ir)
 		"    increment: %p\n",
 		(void *) ir->counter, (void *) ir->from, (void *) ir->to,
                 (void *) ir->increment);
-	 abort();
+	 return error();
       }
 
       if ((ir->cmp < ir_binop_less) || (ir->cmp > ir_binop_nequal)) {
 	 printf("ir_loop has invalid comparitor %d\n", ir->cmp);
-	 abort();
+	 return error();
       }
    } else {
       if ((ir->from != NULL) || (ir->from != NULL) || (ir->increment != NULL)) {
@@ -143,7 +162,7 @@ ir_validate::visit_leave(ir_loop *ir)
 		"    increment: %p\n",
 		(void *) ir->counter, (void *) ir->from, (void *) ir->to,
                 (void *) ir->increment);
-	 abort();
+	 return error();
       }
    }
 
@@ -162,7 +181,7 @@ ir_validate::visit_enter(ir_function *ir)
       printf("%s %p inside %s %p\n",
 	     ir->name, (void *) ir,
 	     this->current_function->name, (void *) this->current_function);
-      abort();
+      return error();
    }
 
    /* Store the current function hierarchy being traversed.  This is used
@@ -195,7 +214,7 @@ ir_validate::visit_enter(ir_function_signature *ir)
 	     (void *) ir,
 	     this->current_function->name, (void *) this->current_function,
 	     ir->function_name(), (void *) ir->function());
-      abort();
+      return error();
    }
 
    this->validate_ir(ir, this->data);
@@ -203,16 +222,28 @@ ir_validate::visit_enter(ir_function_signature *ir)
    return visit_continue;
 }
 
+ir_visitor_status
+ir_validate::expression_error(ir_expression *ir, const char *check)
+{
+   printf("ir_expression @ %p fails %s:\n", (void *) ir, check);
+   ir->print();
+   printf("\n");
+   return error();
+}
+
+#define expression_check(cond) \
+   do { if (!(cond)) return expression_error(ir, #cond); } while (0)
+
 ir_visitor_status
 ir_validate::visit_leave(ir_expression *ir)
 {
    switch (ir->operation) {
    case ir_unop_bit_not:
-      assert(ir->operands[0]->type == ir->type);
+      expression_check(ir->operands[0]->type == ir->type);
       break;
    case ir_unop_logic_not:
-      assert(ir->type->base_type == GLSL_TYPE_BOOL);
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
       break;
 
    case ir_unop_neg:
@@ -221,49 +252,49 @@ ir_validate::visit_leave(ir_expression *ir)
    case ir_unop_rcp:
    case ir_unop_rsq:
    case ir_unop_sqrt:
-      assert(ir->type == ir->operands[0]->type);
+      expression_check(ir->type == ir->operands[0]->type);
       break;
 
    case ir_unop_exp:
    case ir_unop_log:
    case ir_unop_exp2:
    case ir_unop_log2:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-      assert(ir->type == ir->operands[0]->type);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->type == ir->operands[0]->type);
       break;
 
    case ir_unop_f2i:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-      assert(ir->type->base_type == GLSL_TYPE_INT);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->type->base_type == GLSL_TYPE_INT);
       break;
    case ir_unop_i2f:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_INT);
-      assert(ir->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_INT);
+      expression_check(ir->type->base_type == GLSL_TYPE_FLOAT);
       break;
    case ir_unop_f2b:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-      assert(ir->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->type->base_type == GLSL_TYPE_BOOL);
       break;
    case ir_unop_b2f:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
-      assert(ir->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->type->base_type == GLSL_TYPE_FLOAT);
       break;
    case ir_unop_i2b:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_INT);
-      assert(ir->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_INT);
+      expression_check(ir->type->base_type == GLSL_TYPE_BOOL);
       break;
    case ir_unop_b2i:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
-      assert(ir->type->base_type == GLSL_TYPE_INT);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->type->base_type == GLSL_TYPE_INT);
       break;
    case ir_unop_u2f:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_UINT);
-      assert(ir->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_UINT);
+      expression_check(ir->type->base_type == GLSL_TYPE_FLOAT);
       break;
 
    case ir_unop_any:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
-      assert(ir->type == glsl_type::bool_type);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->type == glsl_type::bool_type);
       break;
 
    case ir_unop_trunc:
@@ -277,8 +308,8 @@ ir_validate::visit_leave(ir_expression *ir)
    case ir_unop_cos_reduced:
    case ir_unop_dFdx:
    case ir_unop_dFdy:
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-      assert(ir->operands[0]->type == ir->type);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->operands[0]->type == ir->type);
       break;
 
    case ir_unop_noise:
@@ -294,13 +325,13 @@ ir_validate::visit_leave(ir_expression *ir)
    case ir_binop_max:
    case ir_binop_pow:
       if (ir->operands[0]->type->is_scalar())
-	 assert(ir->operands[1]->type == ir->type);
+	 expression_check(ir->operands[1]->type == ir->type);
       else if (ir->operands[1]->type->is_scalar())
-	 assert(ir->operands[0]->type == ir->type);
+	 expression_check(ir->operands[0]->type == ir->type);
       else if (ir->operands[0]->type->is_vector() &&
 	       ir->operands[1]->type->is_vector()) {
-	 assert(ir->operands[0]->type == ir->operands[1]->type);
-	 assert(ir->operands[0]->type == ir->type);
+	 expression_check(ir->operands[0]->type == ir->operands[1]->type);
+	 expression_check(ir->operands[0]->type == ir->type);
       }
       break;
 
@@ -315,11 +346,11 @@ ir_validate::visit_leave(ir_expression *ir)
        * comparison on scalar or vector types and return a boolean scalar or
        * vector type of the same size.
        */
-      assert(ir->type->base_type == GLSL_TYPE_BOOL);
-      assert(ir->operands[0]->type == ir->operands[1]->type);
-      assert(ir->operands[0]->type->is_vector()
+      expression_check(ir->type->base_type == GLSL_TYPE_BOOL);
+      expression_check(ir->operands[0]->type == ir->operands[1]->type);
+      expression_check(ir->operands[0]->type->is_vector()
 	     || ir->operands[0]->type->is_scalar());
-      assert(ir->operands[0]->type->vector_elements
+      expression_check(ir->operands[0]->type->vector_elements
 	     == ir->type->vector_elements);
       break;
 
@@ -328,34 +359,34 @@ ir_validate::visit_leave(ir_expression *ir)
       /* GLSL == and != operate on scalars, vectors, matrices and arrays, and
        * return a scalar boolean.  The IR matches that.
        */
-      assert(ir->type == glsl_type::bool_type);
-      assert(ir->operands[0]->type == ir->operands[1]->type);
+      expression_check(ir->type == glsl_type::bool_type);
+      expression_check(ir->operands[0]->type == ir->operands[1]->type);
       break;
 
    case ir_binop_lshift:
    case ir_binop_rshift:
-      assert(ir->operands[0]->type->is_integer() &&
+      expression_check(ir->operands[0]->type->is_integer() &&
              ir->operands[1]->type->is_integer());
       if (ir->operands[0]->type->is_scalar()) {
-          assert(ir->operands[1]->type->is_scalar());
+          expression_check(ir->operands[1]->type->is_scalar());
       }
       if (ir->operands[0]->type->is_vector() &&
           ir->operands[1]->type->is_vector()) {
-          assert(ir->operands[0]->type->components() ==
+          expression_check(ir->operands[0]->type->components() ==
                  ir->operands[1]->type->components());
       }
-      assert(ir->type == ir->operands[0]->type);
+      expression_check(ir->type == ir->operands[0]->type);
       break;
 
    case ir_binop_bit_and:
    case ir_binop_bit_xor:
    case ir_binop_bit_or:
-       assert(ir->operands[0]->type->base_type ==
+       expression_check(ir->operands[0]->type->base_type ==
               ir->operands[1]->type->base_type);
-       assert(ir->type->is_integer());
+       expression_check(ir->type->is_integer());
        if (ir->operands[0]->type->is_vector() &&
            ir->operands[1]->type->is_vector()) {
-           assert(ir->operands[0]->type->vector_elements ==
+           expression_check(ir->operands[0]->type->vector_elements ==
                   ir->operands[1]->type->vector_elements);
        }
        break;
@@ -363,16 +394,16 @@ ir_validate::visit_leave(ir_expression *ir)
    case ir_binop_logic_and:
    case ir_binop_logic_xor:
    case ir_binop_logic_or:
-      assert(ir->type == glsl_type::bool_type);
-      assert(ir->operands[0]->type == glsl_type::bool_type);
-      assert(ir->operands[1]->type == glsl_type::bool_type);
+      expression_check(ir->type == glsl_type::bool_type);
+      expression_check(ir->operands[0]->type == glsl_type::bool_type);
+      expression_check(ir->operands[1]->type == glsl_type::bool_type);
       break;
 
    case ir_binop_dot:
-      assert(ir->type == glsl_type::float_type);
-      assert(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
-      assert(ir->operands[0]->type->is_vector());
-      assert(ir->operands[0]->type == ir->operands[1]->type);
+      expression_check(ir->type == glsl_type::float_type);
+      expression_check(ir->operands[0]->type->base_type == GLSL_TYPE_FLOAT);
+      expression_check(ir->operands[0]->type->is_vector());
+      expression_check(ir->operands[0]->type == ir->operands[1]->type);
       break;
 
    case ir_quadop_vector:
@@ -383,40 +414,40 @@ ir_validate::visit_leave(ir_expression *ir)
        *  - Number of operands must matche the size of the resulting vector.
        *  - Base type of the operands must match the base type of the result.
        */
-      assert(ir->type->is_vector());
+      expression_check(ir->type->is_vector());
       switch (ir->type->vector_elements) {
       case 2:
-	 assert(ir->operands[0]->type->is_scalar());
-	 assert(ir->operands[0]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[1]->type->is_scalar());
-	 assert(ir->operands[1]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[2] == NULL);
-	 assert(ir->operands[3] == NULL);
+	 expression_check(ir->operands[0]->type->is_scalar());
+	 expression_check(ir->operands[0]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[1]->type->is_scalar());
+	 expression_check(ir->operands[1]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[2] == NULL);
+	 expression_check(ir->operands[3] == NULL);
 	 break;
       case 3:
-	 assert(ir->operands[0]->type->is_scalar());
-	 assert(ir->operands[0]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[1]->type->is_scalar());
-	 assert(ir->operands[1]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[2]->type->is_scalar());
-	 assert(ir->operands[2]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[3] == NULL);
+	 expression_check(ir->operands[0]->type->is_scalar());
+	 expression_check(ir->operands[0]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[1]->type->is_scalar());
+	 expression_check(ir->operands[1]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[2]->type->is_scalar());
+	 expression_check(ir->operands[2]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[3] == NULL);
 	 break;
       case 4:
-	 assert(ir->operands[0]->type->is_scalar());
-	 assert(ir->operands[0]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[1]->type->is_scalar());
-	 assert(ir->operands[1]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[2]->type->is_scalar());
-	 assert(ir->operands[2]->type->base_type == ir->type->base_type);
-	 assert(ir->operands[3]->type->is_scalar());
-	 assert(ir->operands[3]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[0]->type->is_scalar());
+	 expression_check(ir->operands[0]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[1]->type->is_scalar());
+	 expression_check(ir->operands[1]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[2]->type->is_scalar());
+	 expression_check(ir->operands[2]->type->base_type == ir->type->base_type);
+	 expression_check(ir->operands[3]->type->is_scalar());
+	 expression_check(ir->operands[3]->type->base_type == ir->type->base_type);
 	 break;
       default:
 	 /* The is_vector assertion above should prevent execution from ever
 	  * getting here.
 	  */
-	 assert(!"Should not get here.");
+	 expression_check(!"Should not get here.");
 	 break;
       }
    }
@@ -434,7 +465,7 @@ ir_validate::visit_leave(ir_swizzle *ir)
 	 printf("ir_swizzle @ %p specifies a channel not present "
 		"in the value.\n", (void *) ir);
 	 ir->print();
-	 abort();
+	 return error();
       }
    }
 
@@ -465,7 +496,7 @@ ir_validate::visit_enter(ir_assignment *ir)
 	 printf("Assignment LHS is %s, but write mask is 0:\n",
 		lhs->type->is_scalar() ? "scalar" : "vector");
 	 ir->print();
-	 abort();
+	 return error();
       }
 
       int lhs_components = 0;
@@ -479,7 +510,7 @@ ir_validate::visit_enter(ir_assignment *ir)
 		"matching RHS vector size (%d LHS, %d RHS).\n",
 		lhs_components, ir->rhs->type->vector_elements);
 	 ir->print();
-	 abort();
+	 return error();
       }
    }
 
@@ -491,39 +522,61 @@ ir_validate::visit_enter(ir_assignment *ir)
 void
 ir_validate::validate_ir(ir_instruction *ir, void *data)
 {
-   struct hash_table *ht = (struct hash_table *) data;
+   ir_validate *v = (ir_validate *) data;
 
-   if (hash_table_find(ht, ir)) {
+   if (hash_table_find(v->ht, ir)) {
       printf("Instruction node present twice in ir tree:\n");
       ir->print();
       printf("\n");
-      abort();
+      if (v->abort_on_error)
+	 abort();
+      v->failed = true;
+      return;
    }
-   hash_table_insert(ht, ir, ir);
+   hash_table_insert(v->ht, ir, ir);
 }
 
 void
 check_node_type(ir_instruction *ir, void *data)
 {
-   (void) data;
+   ir_validate *v = (ir_validate *) data;
 
    if (ir->ir_type <= ir_type_unset || ir->ir_type >= ir_type_max) {
       printf("Instruction node with unset type\n");
       ir->print(); printf("\n");
+      v->failed = true;
    }
-   assert(ir->type != glsl_type::error_type);
+   assert(!v->abort_on_error || ir->type != glsl_type::error_type);
+   if (ir->type == glsl_type::error_type)
+      v->failed = true;
 }
 
-void
-validate_ir_tree(exec_list *instructions)
+static bool
+validate_ir_list(exec_list *instructions, bool abort_on_error)
 {
    ir_validate v;
 
+   v.abort_on_error = abort_on_error;
    v.run(instructions);
+   if (v.failed)
+      return false;
 
    foreach_iter(exec_list_iterator, iter, *instructions) {
       ir_instruction *ir = (ir_instruction *)iter.get();
 
-      visit_tree(ir, check_node_type, NULL);
+      visit_tree(ir, check_node_type, &v);
    }
+   return !v.failed;
+}
+
+void
+validate_ir_tree(exec_list *instructions)
+{
+   validate_ir_list(instructions, true);
+}
+
+bool
+ir_tree_is_valid(exec_list *instructions)
+{
+   return validate_ir_list(instructions, false);
 }
@@ -82,6 +82,7 @@ extern "C" {
 #include "program/hash_table.h"
 #include "linker.h"
 #include "ir_optimization.h"
+#include "ir_variable_refcount.h"
 
 #include "main/shaderobj.h"
 
@@ -1387,11 +1388,79 @@ demote_shader_inputs_and_outputs(gl_shader *sh, enum ir_variable_mode mode)
    }
 }
 
+/**
+ * Consumer input fed by a producer output, or NULL if the consumer never reads it
+ */
+static ir_variable *
+read_varying(gl_shader *consumer, ir_variable_refcount_visitor *consumer_refs,
+	     ir_variable *output_var)
+{
+   ir_variable *const input_var =
+      consumer->symbols->get_variable(output_var->name);
+
+   if ((input_var == NULL) || (input_var->mode != ir_var_in)
+       || (input_var->location != -1))
+      return NULL;
+
+   /* Dead code elimination may have dropped the declaration or every read.
+    */
+   if (consumer_refs->get_variable_entry(input_var)->referenced_count == 0)
+      return NULL;
+
+   return input_var;
+}
+
+
+/**
+ * Value of an output the producer only ever assigns one constant to
+ *
+ * Reads of an output the producer did not write are undefined, so the
+ * constant is the varying's value wherever the assignment sits.
+ */
+static ir_constant *
+constant_varying(ir_variable_refcount_visitor *producer_refs,
+		 ir_variable *output_var)
+{
+   if (output_var->type->is_array() || output_var->type->is_matrix())
+      return NULL;
+
+   /* The one assignment must also be the only reference; writes through
+    * out parameters of calls are not counted as assignments.
+    */
+   variable_entry *const entry = producer_refs->get_variable_entry(output_var);
+   if ((entry->assigned_count != 1) || (entry->referenced_count != 1))
+      return NULL;
+
+   ir_assignment *const assign = entry->assign;
+   if (assign->condition != NULL)
+      return NULL;
+   const unsigned mask = (1U << output_var->type->vector_elements) - 1;
+   if ((assign->lhs->as_dereference_variable() == NULL)
+       || ((assign->write_mask & mask) != mask))
+      return NULL;
+
+   return assign->rhs->as_constant();
+}
+
+
+/**
+ * Components of a varying that may share its vec4 slot, 0 if it needs whole slots
+ */
+static unsigned
+packed_varying_components(const ir_variable *var)
+{
+   if (var->type->is_array() || var->type->is_matrix())
+      return 0;
+   return (var->type->vector_elements < 4) ? var->type->vector_elements : 0;
+}
+
+
 void
 assign_varying_locations(struct gl_shader_program *prog,
 			 gl_shader *producer, gl_shader *consumer)
 {
    prog->VaryingSlots = 0;
+   prog->VaryingFlat = 0;
    prog->UsesFragCoord = false;
    prog->UsesPointCoord = false;
    /* FINISHME: Set dynamically when geometry shader support is added. */
@@ -1439,6 +1508,25 @@ assign_varying_locations(struct gl_shader_program *prog,
          var->location = -1;
    }
 
+   ir_variable_refcount_visitor producer_refs;
+   ir_variable_refcount_visitor consumer_refs;
+   producer_refs.run(producer->ir);
+   consumer_refs.run(consumer->ir);
+
+   /* Varyings the consumer reads are assigned in three groups:
+    *
+    * - outputs always written with one constant are not interpolated at all;
+    *   the constant is assigned to the input at the start of the consumer.
+    *
+    * - arrays, matrices and vec4s get whole slots.
+    *
+    * - float, vec2 and vec3 are packed, largest first, into the first
+    *   slot with enough components left and the same interpolation.
+    *   Largest first also keeps each one naturally aligned in its slot.
+    *
+    * Varyings the consumer does not read get no slot, so neither stage keeps
+    * them and the rasterizer does not interpolate them.
+    */
    foreach_list(node, producer->ir) {
       ir_variable *const output_var = ((ir_instruction *) node)->as_variable();
 
@@ -1455,12 +1543,27 @@ assign_varying_locations(struct gl_shader_program *prog,
       }
 
       ir_variable *const input_var =
-	 consumer->symbols->get_variable(output_var->name);
+	 read_varying(consumer, &consumer_refs, output_var);
 
-      if ((input_var == NULL) || (input_var->mode != ir_var_in))
+      if (input_var == NULL)
 	 continue;
 
-      assert(input_var->location == -1);
+      if (ir_constant *const value = constant_varying(&producer_refs, output_var)) {
+	 void *const mem_ctx = hieralloc_parent(input_var);
+	 ir_function_signature *const main_sig =
+	    get_main_function_signature(consumer);
+
+	 if (main_sig != NULL) {
+	    input_var->mode = ir_var_auto;
+	    main_sig->body.push_head(new(mem_ctx)
+	       ir_assignment(new(mem_ctx) ir_dereference_variable(input_var),
+			     value->clone(mem_ctx, NULL), NULL));
+	    continue;
+	 }
+      }
+
+      if (packed_varying_components(output_var) != 0)
+	 continue;
 
       param->BindLocation = output_var->location = output_index;
       param->Location = input_var->location = input_index;
@@ -1484,6 +1587,65 @@ assign_varying_locations(struct gl_shader_program *prog,
       }
    }
 
+   const unsigned packed_base = output_index;
+   unsigned packed_slots = 0;
+   unsigned packed_overflow = 0; /* packed varyings that found no free slot */
+   unsigned packed_used[GGL_MAXVARYINGVECTORS];
+   unsigned packed_interpolation[GGL_MAXVARYINGVECTORS];
+   for (unsigned components = 3; components > 0; components--) {
+      foreach_list(node, producer->ir) {
+	 ir_variable *const output_var = ((ir_instruction *) node)->as_variable();
+
+	 if ((output_var == NULL) || (output_var->mode != ir_var_out)
+	     || (output_var->location != -1)
+	     || (packed_varying_components(output_var) != components))
+	    continue;
+
+	 ir_variable *const input_var =
+	    read_varying(consumer, &consumer_refs, output_var);
+
+	 if (input_var == NULL)
+	    continue;
+
+	 const unsigned interpolation = input_var->interpolation
+	    | input_var->centroid << 2;
+	 unsigned slot;
+	 for (slot = 0; slot < packed_slots; slot++) {
+	    if (packed_used[slot] + components <= 4
+		&& packed_interpolation[slot] == interpolation)
+	       break;
+	 }
+	 if (slot == packed_slots) {
+	    /* Too many varyings; left unassigned and reported below. */
+	    if (packed_slots == GGL_MAXVARYINGVECTORS) {
+	       packed_overflow++;
+	       continue;
+	    }
+	    packed_slots++;
+	    packed_used[slot] = 0;
+	    packed_interpolation[slot] = interpolation;
+	 }
+
+	 output_var->location = input_var->location = packed_base + slot;
+	 output_var->location_frac = input_var->location_frac = packed_used[slot];
+	 packed_used[slot] += components;
+
+	 const int paramIndex = _mesa_get_parameter(prog->Varying, output_var->name);
+	 assert(paramIndex >= 0);
+	 prog->Varying->Parameters[paramIndex].BindLocation = output_var->location;
+	 prog->Varying->Parameters[paramIndex].Location = input_var->location;
+      }
+   }
+   prog->VaryingSlots += packed_slots;
+
+   if (prog->VaryingSlots > GGL_MAXVARYINGVECTORS || packed_overflow) {
+      linker_error_printf(prog, "too many varyings (%u vec4 slots and %u "
+			  "packed varyings that do not fit, %u available)\n",
+			  prog->VaryingSlots, packed_overflow,
+			  GGL_MAXVARYINGVECTORS);
+      prog->LinkStatus = false;
+   }
+
    foreach_list(node, consumer->ir) {
       ir_variable *const var = ((ir_instruction *) node)->as_variable();
 
@@ -1519,12 +1681,48 @@ assign_varying_locations(struct gl_shader_program *prog,
 	  */
          var->mode = ir_var_auto;
       }
-      else
+      else {
          param->Location = var->location;
+
+	 const int slot = var->location
+	    - int(offsetof(VertexOutput,varyings) / sizeof(Vector4));
+	 if ((var->interpolation == ir_var_flat) && (slot >= 0)) {
+	    const unsigned slots = var->type->is_array()
+	       ? var->type->length * var->type->fields.array->matrix_columns
+	       : var->type->matrix_columns;
+	    prog->VaryingFlat |= ((1U << slots) - 1) << slot;
+	 }
+      }
    }
 }
 
 
+/**
+ * Allocate the uniform and vertex input / output storage of a linked program
+ *
+ * Also used when a program is restored from a binary instead of linked.
+ * Returns false when out of memory.
+ */
+bool
+link_allocate_values(struct gl_shader_program *prog)
+{
+   //prog->InputOuputBase = malloc(1024 * 8);
+   //memset(prog->InputOuputBase, 0xdd, 1024 * 8);
+   char *base = hieralloc_realloc(prog, prog->InputOuputBase, char, 
+      (prog->Uniforms->Slots + prog->Uniforms->SamplerSlots) * sizeof(float) * 4 + sizeof(VertexInput) + sizeof(VertexOutput) + 16);
+   if (base == NULL)
+      return false;
+   prog->InputOuputBase = base;
+   prog->ValuesVertexInput = (float (*)[4])((((unsigned long)prog->InputOuputBase) + 15L) & (~15L));
+   prog->ValuesVertexOutput = (float (*)[4])((unsigned long)prog->ValuesVertexInput + sizeof(VertexInput));
+   prog->ValuesUniform = (float (*)[4])((unsigned long)prog->ValuesVertexOutput + sizeof(VertexOutput));
+
+   // initialize uniforms to zero after link
+   memset(prog->ValuesUniform, 0, sizeof(float) * 4 * (prog->Uniforms->Slots + prog->Uniforms->SamplerSlots));
+   prog->UniformGeneration++;
+   return true;
+}
+
 void
 link_shaders(const struct gl_context *ctx, struct gl_shader_program *prog)
 {
@@ -1742,17 +1940,22 @@ link_shaders(const struct gl_context *ctx, struct gl_shader_program *prog)
             assert(0);
       }
    }
-   
-   //prog->InputOuputBase = malloc(1024 * 8);
-   //memset(prog->InputOuputBase, 0xdd, 1024 * 8);
-   prog->InputOuputBase = hieralloc_realloc(prog, prog->InputOuputBase, char, 
-      (prog->Uniforms->Slots + prog->Uniforms->SamplerSlots) * sizeof(float) * 4 + sizeof(VertexInput) + sizeof(VertexOutput) + 16);
-   prog->ValuesVertexInput = (float (*)[4])((((unsigned long)prog->InputOuputBase) + 15L) & (~15L));
-   prog->ValuesVertexOutput = (float (*)[4])((unsigned long)prog->ValuesVertexInput + sizeof(VertexInput));
-   prog->ValuesUniform = (float (*)[4])((unsigned long)prog->ValuesVertexOutput + sizeof(VertexOutput));
 
-   // initialize uniforms to zero after link
-   memset(prog->ValuesUniform, 0, sizeof(float) * 4 * (prog->Uniforms->Slots + prog->Uniforms->SamplerSlots));
+   /* Demoted varyings leave dead writes in the producer and constant
+    * propagated inputs in the consumer; clean both up.
+    */
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+	 continue;
+
+      while (do_common_optimization(prog->_LinkedShaders[i]->ir, true, 32))
+	 ;
+   }
+
+   if (!link_allocate_values(prog)) {
+      linker_error_printf(prog, "out of memory for uniform values\n");
+      prog->LinkStatus = false;
+   }
 
 done:
    free(vert_shader_list);
@@ -56,6 +56,12 @@ extern bool
 set_loop_controls(exec_list *instructions, loop_state *ls);
 
 
+/**
+ * Unroll loops with a known iteration count
+ *
+ * A loop is unrolled when the IR it expands to is no larger than
+ * \c max_iterations copies of a small (32 node) loop body.
+ */
 extern bool
 unroll_loops(exec_list *instructions, loop_state *ls, unsigned max_iterations);
 
@@ -43,6 +43,23 @@ public:
 };
 
 
+/**
+ * IR nodes an unrolled loop may grow to, per unit of \c max_iterations
+ *
+ * A loop is unrolled when its iteration count times its body size fits in
+ * \c max_iterations bodies of this size, so short bodies unroll further than
+ * \c max_iterations while large blur kernels stay loops.
+ */
+#define UNROLL_NODES_PER_ITERATION 32
+
+static void
+count_node(ir_instruction *ir, void *data)
+{
+   (void) ir;
+   (*(unsigned *) data)++;
+}
+
+
 static bool
 is_break(ir_instruction *ir)
 {
@@ -73,9 +90,13 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
    if (iterations < 0)
       return visit_continue;
 
-   /* Don't try to unroll loops that have zillions of iterations either.
+   /* Don't try to unroll loops that would expand to zillions of instructions
+    * either.
     */
-   if (iterations > (int) max_iterations)
+   unsigned nodes = 0;
+   visit_tree(ir, count_node, &nodes);
+   if ((unsigned long long) iterations * nodes >
+       (unsigned long long) max_iterations * UNROLL_NODES_PER_ITERATION)
       return visit_continue;
 
    if (ls->num_loop_jumps > 1)
@@ -2144,9 +2144,11 @@ struct gl_shader_program
    GLfloat (*ValuesVertexInput)[4];    /**< actually a VertexInput */
    GLfloat (*ValuesVertexOutput)[4];   /**< actually a VertexOutput */
    void * InputOuputBase;              /**< allocation base for Values* */
+   unsigned UniformGeneration;         /**< bumped whenever ValuesUniform changes, versions cached vertices and deferred uniform snapshots */
    
    unsigned AttributeSlots;/**< [0,AttributeSlots-1] read by vertex shader */
    unsigned VaryingSlots;  /**< [0,VaryingSlots-1] read by fragment shader */
+   unsigned VaryingFlat;   /**< bit i set: varyings[i] is flat, not interpolated */
    unsigned UsesFragCoord : 1, UsesPointCoord : 1;
 };   
 
@@ -25,32 +25,167 @@
  * \file hash_table.c
  * \brief Implementation of a generic, opaque hash table data type.
  *
+ * Open addressing with Robin Hood probing.  Entries live inline in a power
+ * of two array of slots, and an entry never sits further from its home slot
+ * than the entries it passed, so a lookup stops at the first slot closer to
+ * home than the probe.  The array doubles once it is 7/8 full, and removal
+ * shifts the rest of the run back instead of leaving tombstones.
+ *
  * \author Ian Romanick <ian.d.romanick@intel.com>
  */
 
 #include "main/imports.h"
-#include "main/simple_list.h"
 #include "hash_table.h"
 
-struct node {
-   struct node *next;
-   struct node *prev;
+struct hash_slot {
+    unsigned hash;      /**< Mixed hash of \c key, 0 for an empty slot. */
+    const void *key;
+    void *data;
 };
 
 struct hash_table {
     hash_func_t    hash;
     hash_compare_func_t  compare;
 
-    unsigned num_buckets;
-    struct node buckets[1];
+    /**
+     * Table uses \c hash_table_pointer_hash and \c hash_table_pointer_compare,
+     * which are done inline instead of through the function pointers.
+     */
+    int pointer_keys;
+
+    unsigned shift;     /**< 32 - log2 of the number of slots. */
+    unsigned mask;      /**< Number of slots - 1. */
+    unsigned entries;
+    struct hash_slot *slots;
 };
 
 
-struct hash_node {
-    struct node link;
-    const void *key;
-    void *data;
-};
+static INLINE unsigned
+slot_hash(const struct hash_table *ht, const void *key)
+{
+    unsigned hash_value = ht->pointer_keys
+        ? hash_table_pointer_hash(key) : (*ht->hash)(key);
+
+    /* Fibonacci hashing; the home slot comes from the well mixed high bits,
+     * since pointer and DJB2 hashes are poor in the low bits.
+     */
+    hash_value *= 2654435769u;
+    return hash_value ? hash_value : 1;
+}
+
+
+static INLINE unsigned
+slot_home(const struct hash_table *ht, unsigned hash_value)
+{
+    return hash_value >> ht->shift;
+}
+
+
+static INLINE unsigned
+slot_distance(const struct hash_table *ht, unsigned hash_value, unsigned i)
+{
+    return (i - slot_home(ht, hash_value)) & ht->mask;
+}
+
+
+static INLINE int
+slot_matches(const struct hash_table *ht, const struct hash_slot *slot,
+             unsigned hash_value, const void *key)
+{
+    if (slot->hash != hash_value)
+        return 0;
+    if (ht->pointer_keys)
+        return slot->key == key;
+    return (*ht->compare)(slot->key, key) == 0;
+}
+
+
+static struct hash_slot *
+find_slot(const struct hash_table *ht, unsigned hash_value, const void *key)
+{
+    unsigned i = slot_home(ht, hash_value);
+    unsigned dist;
+
+    for (dist = 0; ; dist++) {
+        struct hash_slot *slot = & ht->slots[i];
+
+        if (slot->hash == 0 || slot_distance(ht, slot->hash, i) < dist)
+            return NULL;
+
+        if (slot_matches(ht, slot, hash_value, key))
+            return slot;
+
+        i = (i + 1) & ht->mask;
+    }
+}
+
+
+/**
+ * Place a key that is not in the table yet, displacing entries that are
+ * closer to their home slot than the one being placed.
+ */
+static void
+place_slot(struct hash_table *ht, unsigned hash_value, const void *key,
+           void *data)
+{
+    struct hash_slot entry;
+    unsigned i = slot_home(ht, hash_value);
+    unsigned dist = 0;
+
+    entry.hash = hash_value;
+    entry.key = key;
+    entry.data = data;
+
+    for (;;) {
+        struct hash_slot *slot = & ht->slots[i];
+        unsigned slot_dist;
+
+        if (slot->hash == 0) {
+            *slot = entry;
+            return;
+        }
+
+        slot_dist = slot_distance(ht, slot->hash, i);
+        if (slot_dist < dist) {
+            const struct hash_slot temp = *slot;
+
+            *slot = entry;
+            entry = temp;
+            dist = slot_dist;
+        }
+
+        i = (i + 1) & ht->mask;
+        dist++;
+    }
+}
+
+
+static int
+resize_slots(struct hash_table *ht, unsigned size_log2)
+{
+    struct hash_slot *const old_slots = ht->slots;
+    const unsigned old_size = old_slots ? ht->mask + 1 : 0;
+    struct hash_slot *slots;
+    unsigned i;
+
+
+    slots = calloc(1u << size_log2, sizeof(*slots));
+    if (slots == NULL)
+        return 0;
+
+    ht->slots = slots;
+    ht->shift = 32 - size_log2;
+    ht->mask = (1u << size_log2) - 1;
+
+    for (i = 0; i < old_size; i++) {
+        if (old_slots[i].hash != 0)
+            place_slot(ht, old_slots[i].hash, old_slots[i].key,
+                       old_slots[i].data);
+    }
+
+    free(old_slots);
+    return 1;
+}
 
 
 struct hash_table *
@@ -58,22 +193,22 @@ hash_table_ctor(unsigned num_buckets, hash_func_t hash,
                 hash_compare_func_t compare)
 {
     struct hash_table *ht;
-    unsigned i;
+    unsigned size_log2 = 4;
 
 
-    if (num_buckets < 16) {
-        num_buckets = 16;
-    }
+    while ((1u << size_log2) < num_buckets && size_log2 < 30)
+        size_log2++;
 
-    ht = malloc(sizeof(*ht) + ((num_buckets - 1) 
-				     * sizeof(ht->buckets[0])));
+    ht = calloc(1, sizeof(*ht));
     if (ht != NULL) {
         ht->hash = hash;
         ht->compare = compare;
-        ht->num_buckets = num_buckets;
+        ht->pointer_keys = hash == hash_table_pointer_hash
+            && compare == hash_table_pointer_compare;
 
-        for (i = 0; i < num_buckets; i++) {
-            make_empty_list(& ht->buckets[i]);
+        if (!resize_slots(ht, size_log2)) {
+            free(ht);
+            return NULL;
         }
     }
 
@@ -84,7 +219,7 @@ hash_table_ctor(unsigned num_buckets, hash_func_t hash,
 void
 hash_table_dtor(struct hash_table *ht)
 {
-   hash_table_clear(ht);
+   free(ht->slots);
    free(ht);
 }
 
@@ -92,72 +227,73 @@ hash_table_dtor(struct hash_table *ht)
 void
 hash_table_clear(struct hash_table *ht)
 {
-   struct node *node;
-   struct node *temp;
-   unsigned i;
-
-
-   for (i = 0; i < ht->num_buckets; i++) {
-      foreach_s(node, temp, & ht->buckets[i]) {
-	 remove_from_list(node);
-	 free(node);
-      }
-
-      assert(is_empty_list(& ht->buckets[i]));
-   }
+   memset(ht->slots, 0, (ht->mask + 1) * sizeof(ht->slots[0]));
+   ht->entries = 0;
 }
 
 
 void *
 hash_table_find(struct hash_table *ht, const void *key)
 {
-    const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct node *node;
+    const struct hash_slot *slot = find_slot(ht, slot_hash(ht, key), key);
 
-    foreach(node, & ht->buckets[bucket]) {
-       struct hash_node *hn = (struct hash_node *) node;
-
-       if ((*ht->compare)(hn->key, key) == 0) {
-	  return hn->data;
-       }
-    }
-
-    return NULL;
+    return slot ? slot->data : NULL;
 }
 
 
 void
 hash_table_insert(struct hash_table *ht, void *data, const void *key)
 {
-    const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct hash_node *node;
-
-    node = calloc(1, sizeof(*node));
+    const unsigned hash_value = slot_hash(ht, key);
+    struct hash_slot *slot = find_slot(ht, hash_value, key);
+
+    /* Inserting an existing key replaces it, so the newest data is found.
+     */
+    if (slot != NULL) {
+        slot->key = key;
+        slot->data = data;
+        return;
+    }
 
-    node->data = data;
-    node->key = key;
+    if ((ht->entries + 1) * 8 > (ht->mask + 1) * 7) {
+        /* Keep going in the current slots if growing fails, as long as one
+         * empty slot remains to terminate probing.
+         */
+        if (!resize_slots(ht, 33 - ht->shift) && ht->entries + 1 > ht->mask)
+            return;
+    }
 
-    insert_at_head(& ht->buckets[bucket], & node->link);
+    place_slot(ht, hash_value, key, data);
+    ht->entries++;
 }
 
 void
 hash_table_remove(struct hash_table *ht, const void *key)
 {
-    const unsigned hash_value = (*ht->hash)(key);
-    const unsigned bucket = hash_value % ht->num_buckets;
-    struct node *node;
+    struct hash_slot *slot = find_slot(ht, slot_hash(ht, key), key);
+    unsigned i;
+
+    if (slot == NULL)
+        return;
 
-    foreach(node, & ht->buckets[bucket]) {
-       struct hash_node *hn = (struct hash_node *) node;
+    /* Backward shift: pull the rest of the run one slot closer to home.
+     */
+    i = slot - ht->slots;
+    for (;;) {
+        const unsigned next = (i + 1) & ht->mask;
+        const unsigned next_hash = ht->slots[next].hash;
 
-       if ((*ht->compare)(hn->key, key) == 0) {
-	  remove_from_list(node);
-	  free(node);
-	  return;
-       }
+        if (next_hash == 0 || slot_distance(ht, next_hash, next) == 0)
+            break;
+
+        ht->slots[i] = ht->slots[next];
+        i = next;
     }
+
+    ht->slots[i].hash = 0;
+    ht->slots[i].key = NULL;
+    ht->slots[i].data = NULL;
+    ht->entries--;
 }
 
 unsigned
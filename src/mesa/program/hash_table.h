@@ -43,11 +43,13 @@ extern "C" {
 /**
  * Hash table constructor
  *
- * Creates a hash table with the specified number of buckets.  The supplied
- * \c hash and \c compare routines are used when adding elements to the table
- * and when searching for elements in the table.
+ * Creates a hash table sized for about the specified number of entries;
+ * the table grows as needed.  The supplied \c hash and \c compare
+ * routines are used when adding elements to the table and when searching for
+ * elements in the table.  Tables using \c hash_table_pointer_hash and
+ * \c hash_table_pointer_compare compare keys inline.
  *
- * \param num_buckets  Number of buckets (bins) in the hash table.
+ * \param num_buckets  Initial capacity hint, 0 for the default.
  * \param hash         Function used to compute hash value of input keys.
  * \param compare      Function used to compare keys.
  */
@@ -88,6 +90,9 @@ extern void *hash_table_find(struct hash_table *ht, const void *key);
 
 /**
  * Add an element to a hash table
+ *
+ * If an element with a matching key is already in the table, its key and
+ * data are replaced.
  */
 extern void hash_table_insert(struct hash_table *ht, void *data,
     const void *key);
@@ -0,0 +1,254 @@
+/*
+ * Copyright © 2008 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file hash_table_bench.c
+ * \brief Microbenchmark of hash_table against the former chained table.
+ *
+ * Times insert, successful and failed find, and remove for pointer keys (the
+ * IR visitors' tables) and string keys (glcpp defines, glsl_type caches) at
+ * several table sizes.  The chained table is the fixed bucket implementation
+ * hash_table.c used before it moved to open addressing, kept here for
+ * comparison only.
+ *
+ * usage: hash_table_bench [max_entries]
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "main/imports.h"
+#include "main/simple_list.h"
+#include "hash_table.h"
+
+struct chained_node {
+   struct chained_node *next;
+   struct chained_node *prev;
+};
+
+struct chained_table {
+   hash_func_t hash;
+   hash_compare_func_t compare;
+   unsigned num_buckets;
+   struct chained_node buckets[1];
+};
+
+struct chained_hash_node {
+   struct chained_node link;
+   const void *key;
+   void *data;
+};
+
+static struct chained_table *
+chained_ctor(unsigned num_buckets, hash_func_t hash, hash_compare_func_t compare)
+{
+   struct chained_table *ht;
+   unsigned i;
+
+   if (num_buckets < 16)
+      num_buckets = 16;
+
+   ht = malloc(sizeof(*ht) + (num_buckets - 1) * sizeof(ht->buckets[0]));
+   ht->hash = hash;
+   ht->compare = compare;
+   ht->num_buckets = num_buckets;
+   for (i = 0; i < num_buckets; i++)
+      make_empty_list(& ht->buckets[i]);
+   return ht;
+}
+
+static void
+chained_dtor(struct chained_table *ht)
+{
+   struct chained_node *node;
+   struct chained_node *temp;
+   unsigned i;
+
+   for (i = 0; i < ht->num_buckets; i++) {
+      foreach_s(node, temp, & ht->buckets[i]) {
+         remove_from_list(node);
+         free(node);
+      }
+   }
+   free(ht);
+}
+
+static void *
+chained_find(struct chained_table *ht, const void *key)
+{
+   const unsigned bucket = (*ht->hash)(key) % ht->num_buckets;
+   struct chained_node *node;
+
+   foreach(node, & ht->buckets[bucket]) {
+      struct chained_hash_node *hn = (struct chained_hash_node *) node;
+
+      if ((*ht->compare)(hn->key, key) == 0)
+         return hn->data;
+   }
+   return NULL;
+}
+
+static void
+chained_insert(struct chained_table *ht, void *data, const void *key)
+{
+   const unsigned bucket = (*ht->hash)(key) % ht->num_buckets;
+   struct chained_hash_node *node = calloc(1, sizeof(*node));
+
+   node->data = data;
+   node->key = key;
+   insert_at_head(& ht->buckets[bucket], & node->link);
+}
+
+static void
+chained_remove(struct chained_table *ht, const void *key)
+{
+   const unsigned bucket = (*ht->hash)(key) % ht->num_buckets;
+   struct chained_node *node;
+
+   foreach(node, & ht->buckets[bucket]) {
+      struct chained_hash_node *hn = (struct chained_hash_node *) node;
+
+      if ((*ht->compare)(hn->key, key) == 0) {
+         remove_from_list(node);
+         free(node);
+         return;
+      }
+   }
+}
+
+static double
+now_ms(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* total ms for count inserts, 4 * count hits, count misses and count removes */
+static double
+bench_chained(void **keys, void **misses, unsigned count, unsigned rounds,
+              unsigned num_buckets, hash_func_t hash, hash_compare_func_t compare)
+{
+   const double start = now_ms();
+   unsigned r, i, found = 0;
+
+   for (r = 0; r < rounds; r++) {
+      struct chained_table *ht = chained_ctor(num_buckets, hash, compare);
+
+      for (i = 0; i < count; i++)
+         chained_insert(ht, keys[i], keys[i]);
+      for (i = 0; i < count * 4; i++)
+         found += chained_find(ht, keys[(i * 7) % count]) != NULL;
+      for (i = 0; i < count; i++)
+         found += chained_find(ht, misses[i]) != NULL;
+      for (i = 0; i < count; i++)
+         chained_remove(ht, keys[i]);
+      chained_dtor(ht);
+   }
+   if (found != count * 4 * rounds)
+      printf("chained table lookup mismatch\n");
+   return now_ms() - start;
+}
+
+static double
+bench_open(void **keys, void **misses, unsigned count, unsigned rounds,
+           unsigned num_buckets, hash_func_t hash, hash_compare_func_t compare)
+{
+   const double start = now_ms();
+   unsigned r, i, found = 0;
+
+   for (r = 0; r < rounds; r++) {
+      struct hash_table *ht = hash_table_ctor(num_buckets, hash, compare);
+
+      for (i = 0; i < count; i++)
+         hash_table_insert(ht, keys[i], keys[i]);
+      for (i = 0; i < count * 4; i++)
+         found += hash_table_find(ht, keys[(i * 7) % count]) != NULL;
+      for (i = 0; i < count; i++)
+         found += hash_table_find(ht, misses[i]) != NULL;
+      for (i = 0; i < count; i++)
+         hash_table_remove(ht, keys[i]);
+      hash_table_dtor(ht);
+   }
+   if (found != count * 4 * rounds)
+      printf("open addressing table lookup mismatch\n");
+   return now_ms() - start;
+}
+
+static void
+bench(const char *name, void **keys, void **misses, unsigned count,
+      unsigned num_buckets, hash_func_t hash, hash_compare_func_t compare)
+{
+   /* about 250k operations per measurement */
+   const unsigned rounds = 250000 / (count * 7) + 1;
+   const double chained = bench_chained(keys, misses, count, rounds,
+                                        num_buckets, hash, compare);
+   const double open = bench_open(keys, misses, count, rounds,
+                                  num_buckets, hash, compare);
+
+   printf("%-8s entries=%-7u buckets=%-3u chained=%8.2fms open=%8.2fms speedup=%.2fx\n",
+          name, count, num_buckets, chained, open, chained / open);
+}
+
+int
+main(int argc, char **argv)
+{
+   const unsigned max_entries = argc > 1 ? strtoul(argv[1], NULL, 0) : 4096;
+   void **keys = malloc(max_entries * sizeof(*keys));
+   void **misses = malloc(max_entries * sizeof(*misses));
+   char (*names)[24] = malloc(max_entries * 2 * sizeof(*names));
+   unsigned count, i;
+
+   if (!keys || !misses || !names)
+      return 1;
+
+   for (count = 16; count <= max_entries; count *= 4) {
+      /* heap pointers, like ir_instruction and ir_variable keys */
+      for (i = 0; i < count; i++) {
+         keys[i] = malloc(32);
+         misses[i] = malloc(32);
+      }
+      bench("pointer", keys, misses, count, 0,
+            hash_table_pointer_hash, hash_table_pointer_compare);
+      for (i = 0; i < count; i++) {
+         free(keys[i]);
+         free(misses[i]);
+      }
+
+      /* identifiers, like glcpp defines and glsl_type array names */
+      for (i = 0; i < count; i++) {
+         snprintf(names[i], sizeof(names[i]), "var_%u", i);
+         snprintf(names[max_entries + i], sizeof(names[i]), "vec4[%u]", i);
+         keys[i] = names[i];
+         misses[i] = names[max_entries + i];
+      }
+      bench("string", keys, misses, count, 64,
+            hash_table_string_hash, hash_table_string_compare);
+   }
+
+   free(names);
+   free(misses);
+   free(keys);
+   return 0;
+}
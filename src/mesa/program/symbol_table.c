@@ -101,6 +101,14 @@ struct _mesa_symbol_table {
     /** Hash table containing all symbols in the symbol table. */
     struct hash_table *ht;
 
+    /**
+     * Symbol headers keyed by the address of their interned name
+     *
+     * Names returned by \c _mesa_symbol_table_intern are found here without
+     * hashing or comparing the string.
+     */
+    struct hash_table *names;
+
     /** Top of scope stack. */
     struct scope_level *current_scope;
 
@@ -197,10 +205,31 @@ _mesa_symbol_table_push_scope(struct _mesa_symbol_table *table)
 static struct symbol_header *
 find_symbol(struct _mesa_symbol_table *table, const char *name)
 {
+    struct symbol_header *hdr;
+
+    hdr = (struct symbol_header *) hash_table_find(table->names, name);
+    if (hdr != NULL)
+        return hdr;
+
     return (struct symbol_header *) hash_table_find(table->ht, name);
 }
 
 
+static struct symbol_header *
+add_header(struct _mesa_symbol_table *table, const char *name)
+{
+    struct symbol_header *const hdr = calloc(1, sizeof(*hdr));
+
+    hdr->name = strdup(name);
+
+    hash_table_insert(table->ht, hdr, hdr->name);
+    hash_table_insert(table->names, hdr, hdr->name);
+    hdr->next = table->hdr;
+    table->hdr = hdr;
+    return hdr;
+}
+
+
 struct _mesa_symbol_table_iterator *
 _mesa_symbol_table_iterator_ctor(struct _mesa_symbol_table *table,
                                  int name_space, const char *name)
@@ -335,14 +364,8 @@ _mesa_symbol_table_add_symbol(struct _mesa_symbol_table *table,
 
     check_symbol_table(table);
 
-    if (hdr == NULL) {
-       hdr = calloc(1, sizeof(*hdr));
-       hdr->name = strdup(name);
-
-       hash_table_insert(table->ht, hdr, hdr->name);
-       hdr->next = table->hdr;
-       table->hdr = hdr;
-    }
+    if (hdr == NULL)
+       hdr = add_header(table, name);
 
     check_symbol_table(table);
 
@@ -392,14 +415,8 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
 
     check_symbol_table(table);
 
-    if (hdr == NULL) {
-        hdr = calloc(1, sizeof(*hdr));
-        hdr->name = strdup(name);
-
-        hash_table_insert(table->ht, hdr, hdr->name);
-        hdr->next = table->hdr;
-        table->hdr = hdr;
-    }
+    if (hdr == NULL)
+        hdr = add_header(table, name);
 
     check_symbol_table(table);
 
@@ -451,6 +468,24 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
 
 
 
+/**
+ * Return the table's unique copy of \c name
+ *
+ * The returned string stays valid until the table is destroyed.  Looking up
+ * symbols by an interned name skips hashing and comparing the string.
+ */
+const char *
+_mesa_symbol_table_intern(struct _mesa_symbol_table *table, const char *name)
+{
+    struct symbol_header *hdr = find_symbol(table, name);
+
+    if (hdr == NULL)
+        hdr = add_header(table, name);
+
+    return hdr->name;
+}
+
+
 struct _mesa_symbol_table *
 _mesa_symbol_table_ctor(void)
 {
@@ -459,6 +494,8 @@ _mesa_symbol_table_ctor(void)
     if (table != NULL) {
        table->ht = hash_table_ctor(32, hash_table_string_hash,
 				   hash_table_string_compare);
+       table->names = hash_table_ctor(32, hash_table_pointer_hash,
+				      hash_table_pointer_compare);
 
        _mesa_symbol_table_push_scope(table);
     }
@@ -484,5 +521,6 @@ _mesa_symbol_table_dtor(struct _mesa_symbol_table *table)
    }
 
    hash_table_dtor(table->ht);
+   hash_table_dtor(table->names);
    free(table);
 }
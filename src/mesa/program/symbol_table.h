@@ -43,6 +43,9 @@ extern int _mesa_symbol_table_symbol_scope(struct _mesa_symbol_table *table,
 extern void *_mesa_symbol_table_find_symbol(
     struct _mesa_symbol_table *symtab, int name_space, const char *name);
 
+extern const char *_mesa_symbol_table_intern(
+    struct _mesa_symbol_table *table, const char *name);
+
 extern struct _mesa_symbol_table *_mesa_symbol_table_ctor(void);
 
 extern void _mesa_symbol_table_dtor(struct _mesa_symbol_table *);
@@ -17,6 +17,7 @@
 
 #include "src/pixelflinger2/pixelflinger2.h"
 
+#include <limits.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -136,11 +137,34 @@ static void ClearDepthf(GGLInterface * iface, GLclampf d)
       ctx->clearState.depth ^= 0x7fffffff; // since -FLT_MAX is close to -1 when bitcasted
 }
 
+// Z_16 and SZ_24 keep window z as fixed point, truncated the same way as in the scanline JIT
+static inline unsigned ClearDepthFixed(int depth, const unsigned max)
+{
+   if (0x80000000 & depth) // undo the flip in ClearDepthf
+      depth ^= 0x7fffffff;
+   const float z = MAX2(MIN2((float &)depth, 1.0f), 0.0f);
+   return z * max;
+}
+
+static inline short ClearColor565(const unsigned color)
+{
+   unsigned r = color & 0xf8, g = color & 0xfc00, b = color & 0xf80000;
+   return (b >> 19) | (g >> 5) | (r >> 3);
+}
+
 static void Clear(const GGLInterface * iface, GLbitfield buf)
 {
    GGL_GET_CONST_CONTEXT(ctx, iface);
 
-   // TODO DXL scissor test
+   if (ctx->deferred)
+      return DeferClear(iface, buf);
+
+   if (ctx->scissor.enable) {
+      GGLRect rect; // ClearRect clips it to each surface
+      ScissorRect(ctx, INT_MAX, INT_MAX, &rect);
+      return ClearRect(&ctx->frameSurface, &ctx->depthSurface, &ctx->stencilSurface,
+                       &ctx->clearState, buf, &rect);
+   }
    if (GL_COLOR_BUFFER_BIT & buf && ctx->frameSurface.data) {
       if (GGL_PIXEL_FORMAT_RGBA_8888 == ctx->frameSurface.format) {
          unsigned * const end = (unsigned *)ctx->frameSurface.data +
@@ -151,33 +175,108 @@ static void Clear(const GGLInterface * iface, GLbitfield buf)
       } else if (GGL_PIXEL_FORMAT_RGB_565 == ctx->frameSurface.format) {
          short * const end = (short *)ctx->frameSurface.data +
                              ctx->frameSurface.width * ctx->frameSurface.height;
-         unsigned r = ctx->clearState.color & 0xf8, g = ctx->clearState.color & 0xfc00,
-                      b = ctx->clearState.color & 0xf80000;
-         const short color = (b >> 19) | (g >> 5) | (r >> 3);
+         const short color = ClearColor565(ctx->clearState.color);
          for (short * start = (short *)ctx->frameSurface.data; start < end; start++)
             *start = color;
       } else
          assert(0);
    }
-   if (GL_DEPTH_BUFFER_BIT & buf && ctx->depthSurface.data) {
-      assert(GGL_PIXEL_FORMAT_Z_32 == ctx->depthSurface.format);
+   if (GL_DEPTH_BUFFER_BIT & buf && ctx->depthSurface.data &&
+         GGL_PIXEL_FORMAT_Z_32 == ctx->depthSurface.format) {
       unsigned * const end = (unsigned *)ctx->depthSurface.data +
                              ctx->depthSurface.width * ctx->depthSurface.height;
       const unsigned depth = ctx->clearState.depth;
       for (unsigned * start = (unsigned *)ctx->depthSurface.data; start < end; start++)
          *start = depth;
+      buf &= ~GL_DEPTH_BUFFER_BIT;
+   }
+   if (GL_STENCIL_BUFFER_BIT & buf && ctx->stencilSurface.data &&
+         GGL_PIXEL_FORMAT_S_8 == ctx->stencilSurface.format &&
+         GGL_PIXEL_FORMAT_SZ_24 != ctx->depthSurface.format) { // else stencil is in depth
+      // byte count need not be a multiple of 4
+      memset(ctx->stencilSurface.data, ctx->clearState.stencil & 0xff,
+             ctx->stencilSurface.width * ctx->stencilSurface.height);
+      buf &= ~GL_STENCIL_BUFFER_BIT;
    }
-   if (GL_STENCIL_BUFFER_BIT & buf && ctx->stencilSurface.data) {
-      assert(GGL_PIXEL_FORMAT_S_8 == ctx->stencilSurface.format);
-      unsigned * const end = (unsigned *)((unsigned char *)ctx->stencilSurface.data +
-                                          ctx->stencilSurface.width * ctx->stencilSurface.height);
-      unsigned * start = (unsigned *)ctx->stencilSurface.data;
-      const unsigned stencil = ctx->clearState.stencil;
-      for (start; start < end; start++)
-         *start = stencil;
-      start--;
-      for (unsigned char * i = (unsigned char *)start; i < (unsigned char *)end; i++)
-         *i = stencil & 0xff;
+   if ((GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT) & buf) { // Z_16 and SZ_24
+      GGLRect rect = {0, 0, INT_MAX, INT_MAX};
+      ClearRect(&ctx->frameSurface, &ctx->depthSurface, &ctx->stencilSurface,
+                &ctx->clearState, buf & ~GL_COLOR_BUFFER_BIT, &rect);
+   }
+}
+
+void ClearRect(const GGLSurface * frameSurface, const GGLSurface * depthSurface,
+               const GGLSurface * stencilSurface, const GGLContext::ClearState * clearState,
+               GLbitfield buf, const GGLRect * rect)
+{
+   // same buffers as Clear, rect is clipped to the dimensions of each
+   if (GL_COLOR_BUFFER_BIT & buf && frameSurface->data) {
+      const int right = MIN2(rect->right, (int)frameSurface->width - 1);
+      const int bottom = MIN2(rect->bottom, (int)frameSurface->height - 1);
+      if (GGL_PIXEL_FORMAT_RGBA_8888 == frameSurface->format) {
+         for (int y = rect->top; y <= bottom; y++) {
+            unsigned * row = (unsigned *)frameSurface->data + y * frameSurface->width;
+            for (int x = rect->left; x <= right; x++)
+               row[x] = clearState->color;
+         }
+      } else if (GGL_PIXEL_FORMAT_RGB_565 == frameSurface->format) {
+         const short color = ClearColor565(clearState->color);
+         for (int y = rect->top; y <= bottom; y++) {
+            short * row = (short *)frameSurface->data + y * frameSurface->width;
+            for (int x = rect->left; x <= right; x++)
+               row[x] = color;
+         }
+      } else
+         assert(0);
+   }
+   // like the scanline JIT, SZ_24 depth always holds stencil in the high byte of each
+   // depth value and any other stencil surface is not used; both are cleared in one pass
+   const bool packed = GGL_PIXEL_FORMAT_SZ_24 == depthSurface->format;
+   const unsigned packedBits = (GL_DEPTH_BUFFER_BIT & buf ? 0xffffff : 0) |
+                               (GL_STENCIL_BUFFER_BIT & buf ? 0xff000000 : 0);
+   if ((GL_DEPTH_BUFFER_BIT & buf || packed && packedBits) && depthSurface->data) {
+      const int right = MIN2(rect->right, (int)depthSurface->width - 1);
+      const int bottom = MIN2(rect->bottom, (int)depthSurface->height - 1);
+      if (GGL_PIXEL_FORMAT_Z_32 == depthSurface->format) {
+         for (int y = rect->top; y <= bottom; y++) {
+            int * row = (int *)depthSurface->data + y * depthSurface->width;
+            for (int x = rect->left; x <= right; x++)
+               row[x] = clearState->depth;
+         }
+      } else if (GGL_PIXEL_FORMAT_Z_16 == depthSurface->format) {
+         const unsigned short depth = ClearDepthFixed(clearState->depth, 0xffff);
+         for (int y = rect->top; y <= bottom; y++) {
+            unsigned short * row = (unsigned short *)depthSurface->data + y * depthSurface->width;
+            for (int x = rect->left; x <= right; x++)
+               row[x] = depth;
+         }
+      } else if (GGL_PIXEL_FORMAT_SZ_24 == depthSurface->format) {
+         const unsigned depth = (ClearDepthFixed(clearState->depth, 0xffffff) |
+                                 (clearState->stencil & 0xff) << 24) & packedBits;
+         for (int y = rect->top; y <= bottom; y++) {
+            unsigned * row = (unsigned *)depthSurface->data + y * depthSurface->width;
+            for (int x = rect->left; x <= right; x++)
+               row[x] = (row[x] & ~packedBits) | depth;
+         }
+      } else
+         assert(0);
+   }
+   if (GL_STENCIL_BUFFER_BIT & buf && stencilSurface->data && !packed) {
+      const int right = MIN2(rect->right, (int)stencilSurface->width - 1);
+      const int bottom = MIN2(rect->bottom, (int)stencilSurface->height - 1);
+      if (GGL_PIXEL_FORMAT_S_8 == stencilSurface->format) {
+         for (int y = rect->top; y <= bottom && rect->left <= right; y++)
+            memset((unsigned char *)stencilSurface->data + y * stencilSurface->width + rect->left,
+                   clearState->stencil & 0xff, right - rect->left + 1);
+      } else if (GGL_PIXEL_FORMAT_SZ_24 == stencilSurface->format) {
+         const unsigned stencil = (clearState->stencil & 0xff) << 24;
+         for (int y = rect->top; y <= bottom; y++) {
+            unsigned * row = (unsigned *)stencilSurface->data + y * stencilSurface->width;
+            for (int x = rect->left; x <= right; x++)
+               row[x] = (row[x] & 0xffffff) | stencil;
+         }
+      } else
+         assert(0);
    }
 }
 
@@ -185,10 +284,11 @@ static void SetBuffer(GGLInterface * iface, const GLenum type, GGLSurface * surf
 {
    GGL_GET_CONTEXT(ctx, iface);
    bool changed = false;
+   iface->Flush(iface); // recorded commands keep drawing to the previous surfaces
    if (GL_COLOR_BUFFER_BIT == type) {
       if (surface) {
-         ctx->frameSurface = *surface;
          changed |= ctx->frameSurface.format ^ surface->format;
+         ctx->frameSurface = *surface;
          switch (surface->format) {
          case GGL_PIXEL_FORMAT_RGBA_8888:
          case GGL_PIXEL_FORMAT_RGB_565:
@@ -205,9 +305,17 @@ static void SetBuffer(GGLInterface * iface, const GLenum type, GGLSurface * surf
       ctx->state.bufferState.colorFormat = ctx->frameSurface.format;
    } else if (GL_DEPTH_BUFFER_BIT == type) {
       if (surface) {
-         ctx->depthSurface = *surface;
          changed |= ctx->depthSurface.format ^ surface->format;
-         assert(GGL_PIXEL_FORMAT_Z_32 == ctx->depthSurface.format);
+         ctx->depthSurface = *surface;
+         switch (surface->format) {
+         case GGL_PIXEL_FORMAT_Z_32:
+         case GGL_PIXEL_FORMAT_Z_16:
+         case GGL_PIXEL_FORMAT_SZ_24: // stencil in high byte, set it as stencil surface too
+            break;
+         default:
+            ALOGD("pf2: SetBuffer 0x%.04X format=0x%.02X \n", type, surface->format);
+            assert(0);
+         }
       } else {
          memset(&ctx->depthSurface, 0, sizeof(ctx->depthSurface));
          changed = true;
@@ -215,9 +323,16 @@ static void SetBuffer(GGLInterface * iface, const GLenum type, GGLSurface * surf
       ctx->state.bufferState.depthFormat = ctx->depthSurface.format;
    } else if (GL_STENCIL_BUFFER_BIT == type) {
       if (surface) {
-         ctx->stencilSurface = *surface;
          changed |= ctx->stencilSurface.format ^ surface->format;
-         assert(GGL_PIXEL_FORMAT_S_8 == ctx->stencilSurface.format);
+         ctx->stencilSurface = *surface;
+         switch (surface->format) {
+         case GGL_PIXEL_FORMAT_S_8:
+         case GGL_PIXEL_FORMAT_SZ_24: // must also be the depth surface
+            break;
+         default:
+            ALOGD("pf2: SetBuffer 0x%.04X format=0x%.02X \n", type, surface->format);
+            assert(0);
+         }
       } else {
          memset(&ctx->stencilSurface, 0, sizeof(ctx->stencilSurface));
          changed = true;
@@ -0,0 +1,459 @@
+/**
+ **
+ ** Copyright 2011, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+// Deferred (sort-middle) rendering: DrawTriangle still runs the vertex shader on the
+// caller thread, but the resulting triangle is recorded with a snapshot of what its
+// scanline needs instead of being rasterized. Flush bins the recorded commands into
+// screen tiles and worker threads replay one tile at a time, so no two threads ever
+// touch the same pixel and commands within a tile keep their order.
+// ValuesUniform is copied into the recording batch once per UniformGeneration, and
+// targets recorded until the next uniform write share that copy; the two batches
+// alternate, so a copy is reclaimed when the replay that reads it has finished.
+// Each copy is all Uniforms->Slots of the program, even if a single uniform changed,
+// so a program with many uniforms updated between draws still copies them all per draw.
+
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "pixelflinger2.h"
+#include "src/mesa/main/mtypes.h"
+#include "src/mesa/program/prog_uniform.h"
+
+static const int TILE_SIZE = 64; // pixels, square
+static const unsigned MAX_WORKERS = 16;
+static const unsigned MAX_BATCH_TRIANGLES = 16384; // Flush when reached, up to ~9MB of vertices
+
+// Batch::commands are index << COMMAND_SHIFT | kind, index into the vector for kind
+enum DeferredCommand {
+   COMMAND_TRIANGLE = 0, COMMAND_CLEAR, COMMAND_RECT,
+   COMMAND_SHIFT = 2, COMMAND_MASK = (1 << COMMAND_SHIFT) - 1
+};
+
+struct DeferredTriangle {
+   unsigned vertices; // into Batch::vertices, 3 * VertexOutputVectors(target varyingCount)
+   GGLActiveStencil activeStencil; // chosen by facing in DrawTriangle
+   unsigned target; // index into Batch::targets
+};
+
+struct Batch {
+   GGLSurface frameSurface, depthSurface, stencilSurface; // from first recorded command
+
+   std::vector<DeferredTriangle> triangles;
+   std::vector<Vector4> vertices; // VertexOutput up to last varying, after viewport transform
+   std::vector<GGLContext::ClearState> clearStates;
+   std::vector<GLbitfield> clearBuffers;
+   std::vector<GGLRect> clearRects; // scissor box, or unbounded
+   std::vector<GGLRectBlit> rects; // from DrawRect
+   std::vector<GGLScanLineTarget> targets; // constants resolved from uniformOffsets at Flush
+   std::vector<unsigned> uniformOffsets; // slot into uniforms, for each target
+   // ValuesUniform snapshots, kept capacity is reused; JIT code reads them with
+   // aligned vector loads like ValuesUniform, std::vector only has malloc alignment
+   Vector4 * uniforms;
+   unsigned uniformCount, uniformCapacity; // slots
+
+   std::vector<unsigned> commands; // DeferredCommand
+   std::vector<std::vector<unsigned> > bins; // commands for each tile, in record order
+   unsigned tilesX, tilesY, width, height;
+
+   Batch() : uniforms(NULL), uniformCount(0), uniformCapacity(0) {}
+   ~Batch() {
+      free(uniforms);
+   }
+
+   // appends count slots to uniforms, returns first
+   Vector4 * AllocUniforms(const unsigned count) {
+      if (uniformCount + count > uniformCapacity) {
+         const unsigned capacity = MAX2(uniformCapacity * 2, uniformCount + count);
+         void * grown = NULL;
+         if (posix_memalign(&grown, 16, capacity * sizeof(Vector4)))
+            return NULL;
+         if (uniforms)
+            memcpy(grown, uniforms, uniformCount * sizeof(Vector4));
+         free(uniforms);
+         uniforms = (Vector4 *)grown;
+         uniformCapacity = capacity;
+      }
+      uniformCount += count;
+      return uniforms + uniformCount - count;
+   }
+
+   void Reset() {
+      triangles.clear();
+      vertices.clear();
+      clearStates.clear();
+      clearBuffers.clear();
+      clearRects.clear();
+      rects.clear();
+      targets.clear();
+      uniformOffsets.clear();
+      uniformCount = 0;
+      commands.clear();
+      for (unsigned i = 0; i < bins.size(); i++)
+         bins[i].clear();
+   }
+};
+
+struct GGLDeferred {
+   Batch batches[2];
+   Batch * recording; // appended to by DeferTriangle and DeferClear
+   Batch * replaying; // being rasterized by workers, NULL if idle
+
+   // program, JIT function and uniform version of the last target in recording
+   const gl_shader_program * program;
+   void (* function)();
+   unsigned uniformGeneration;
+
+   unsigned workerCount;
+   pthread_t workers[MAX_WORKERS];
+   pthread_mutex_t lock;
+   pthread_cond_t startCond; // generation changed or quit
+   pthread_cond_t finishCond; // busy reached 0
+   unsigned generation; // incremented for each replay
+   unsigned busy; // workers still replaying current generation
+   unsigned nextTile; // next tile of replaying to claim
+   bool quit;
+};
+
+static void ReplayTile(Batch * batch, const unsigned index)
+{
+   const std::vector<unsigned> & bin = batch->bins[index];
+   GGLRect tile;
+   tile.left = (index % batch->tilesX) * TILE_SIZE;
+   tile.top = (index / batch->tilesX) * TILE_SIZE;
+   tile.right = MIN2(tile.left + TILE_SIZE, (int)batch->width) - 1;
+   tile.bottom = MIN2(tile.top + TILE_SIZE, (int)batch->height) - 1;
+
+   for (unsigned i = 0; i < bin.size(); i++) {
+      const unsigned command = bin[i] >> COMMAND_SHIFT;
+      if (COMMAND_RECT == (bin[i] & COMMAND_MASK)) {
+         BlitRect(&batch->rects[command], &tile);
+         continue;
+      }
+      if (COMMAND_CLEAR == (bin[i] & COMMAND_MASK)) {
+         const GGLRect & clearRect = batch->clearRects[command];
+         GGLRect rect;
+         rect.left = MAX2(tile.left, clearRect.left);
+         rect.top = MAX2(tile.top, clearRect.top);
+         rect.right = MIN2(tile.right, clearRect.right);
+         rect.bottom = MIN2(tile.bottom, clearRect.bottom);
+         ClearRect(&batch->frameSurface, &batch->depthSurface, &batch->stencilSurface,
+                   &batch->clearStates[command], batch->clearBuffers[command], &rect);
+         continue;
+      }
+      const DeferredTriangle & triangle = batch->triangles[command];
+      const GGLScanLineTarget * target = &batch->targets[triangle.target];
+      const unsigned stride = VertexOutputVectors(target->varyingCount);
+      const Vector4 * vertices = &batch->vertices[triangle.vertices];
+      VertexOutput v[3];
+      for (unsigned j = 0; j < 3; j++)
+         memcpy(v + j, vertices + j * stride, stride * sizeof(Vector4));
+      GGLActiveStencil activeStencil = triangle.activeStencil;
+      RasterTriangleTile(target, &activeStencil, v + 0, v + 1, v + 2, &tile);
+   }
+}
+
+static void * ReplayWorker(void * threadArgs)
+{
+   GGLDeferred * deferred = (GGLDeferred *)threadArgs;
+   unsigned generation = 0;
+
+   pthread_mutex_lock(&deferred->lock);
+   while (true) {
+      while (!deferred->quit && generation == deferred->generation)
+         pthread_cond_wait(&deferred->startCond, &deferred->lock);
+      if (deferred->quit)
+         break;
+      generation = deferred->generation;
+      Batch * batch = deferred->replaying;
+      pthread_mutex_unlock(&deferred->lock);
+
+      const unsigned tileCount = batch->tilesX * batch->tilesY;
+      for (unsigned tile = __sync_fetch_and_add(&deferred->nextTile, 1); tile < tileCount;
+            tile = __sync_fetch_and_add(&deferred->nextTile, 1))
+         ReplayTile(batch, tile);
+
+      pthread_mutex_lock(&deferred->lock);
+      if (0 == --deferred->busy)
+         pthread_cond_signal(&deferred->finishCond);
+   }
+   pthread_mutex_unlock(&deferred->lock);
+   return NULL;
+}
+
+// waits for workers to finish replaying and recycles the batch
+static void Wait(GGLDeferred * deferred)
+{
+   pthread_mutex_lock(&deferred->lock);
+   while (deferred->busy)
+      pthread_cond_wait(&deferred->finishCond, &deferred->lock);
+   pthread_mutex_unlock(&deferred->lock);
+   if (deferred->replaying) {
+      deferred->replaying->Reset();
+      deferred->replaying = NULL;
+   }
+}
+
+static void Bin(Batch * batch)
+{
+   batch->width = MAX2(batch->frameSurface.width,
+                       MAX2(batch->depthSurface.width, batch->stencilSurface.width));
+   batch->height = MAX2(batch->frameSurface.height,
+                        MAX2(batch->depthSurface.height, batch->stencilSurface.height));
+   batch->tilesX = (batch->width + TILE_SIZE - 1) / TILE_SIZE;
+   batch->tilesY = (batch->height + TILE_SIZE - 1) / TILE_SIZE;
+   const unsigned tileCount = batch->tilesX * batch->tilesY;
+   if (batch->bins.size() < tileCount)
+      batch->bins.resize(tileCount);
+
+   for (unsigned i = 0; i < batch->targets.size(); i++)
+      batch->targets[i].constants = batch->targets[i].constants ? (const float (*)[4])
+                                    (batch->uniforms + batch->uniformOffsets[i]) : NULL;
+
+   for (unsigned i = 0; i < batch->commands.size(); i++) {
+      const unsigned command = batch->commands[i];
+      unsigned tileLeft, tileRight, tileTop, tileBottom;
+      if (COMMAND_RECT == (command & COMMAND_MASK)) {
+         const GGLRect & rect = batch->rects[command >> COMMAND_SHIFT].clip; // never empty
+         tileLeft = rect.left / TILE_SIZE;
+         tileTop = rect.top / TILE_SIZE;
+         tileRight = rect.right / TILE_SIZE;
+         tileBottom = rect.bottom / TILE_SIZE;
+      } else if (COMMAND_CLEAR == (command & COMMAND_MASK)) {
+         const GGLRect & rect = batch->clearRects[command >> COMMAND_SHIFT];
+         if (rect.right < rect.left || rect.bottom < rect.top ||
+               rect.left >= (int)batch->width || rect.top >= (int)batch->height)
+            continue;
+         tileLeft = rect.left / TILE_SIZE;
+         tileTop = rect.top / TILE_SIZE;
+         tileRight = MIN2((unsigned)rect.right / TILE_SIZE, batch->tilesX - 1);
+         tileBottom = MIN2((unsigned)rect.bottom / TILE_SIZE, batch->tilesY - 1);
+      } else {
+         // raster clips to frame surface and scissor, so only tiles over clip get triangles
+         const DeferredTriangle & triangle = batch->triangles[command >> COMMAND_SHIFT];
+         const GGLRect & clip = batch->targets[triangle.target].clip;
+         const unsigned stride = VertexOutputVectors(batch->targets[triangle.target].varyingCount);
+         const Vector4 * v = &batch->vertices[triangle.vertices + GGL_VS_OUTPUT_POSITION_INDEX];
+         const Vector4 & p0 = v[0], & p1 = v[stride], & p2 = v[stride * 2];
+         const float left = MIN2(p0.x, MIN2(p1.x, p2.x));
+         const float right = MAX2(p0.x, MAX2(p1.x, p2.x));
+         const float top = MIN2(p0.y, MIN2(p1.y, p2.y));
+         const float bottom = MAX2(p0.y, MAX2(p1.y, p2.y));
+         if (!(right >= clip.left && left <= clip.right && bottom >= clip.top && top <= clip.bottom))
+            continue; // also rejects NaN
+         tileLeft = (unsigned)MAX2(left, (float)clip.left) / TILE_SIZE;
+         tileRight = (unsigned)MIN2(right, (float)clip.right) / TILE_SIZE;
+         tileTop = (unsigned)MAX2(top, (float)clip.top) / TILE_SIZE;
+         tileBottom = (unsigned)MIN2(bottom, (float)clip.bottom) / TILE_SIZE;
+      }
+      for (unsigned y = tileTop; y <= tileBottom; y++)
+         for (unsigned x = tileLeft; x <= tileRight; x++)
+            batch->bins[y * batch->tilesX + x].push_back(command);
+   }
+}
+
+static void Flush(const GGLInterface * iface)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   GGLDeferred * deferred = ctx->deferred;
+   if (!deferred)
+      return;
+   Wait(deferred); // one batch in flight, so recording reuses the other
+   Batch * batch = deferred->recording;
+   if (batch->commands.empty())
+      return;
+
+   Bin(batch);
+   deferred->recording = batch == deferred->batches ? deferred->batches + 1 : deferred->batches;
+   deferred->program = NULL;
+   deferred->function = NULL;
+
+   pthread_mutex_lock(&deferred->lock);
+   deferred->replaying = batch;
+   deferred->nextTile = 0;
+   deferred->busy = deferred->workerCount;
+   deferred->generation++;
+   pthread_cond_broadcast(&deferred->startCond);
+   pthread_mutex_unlock(&deferred->lock);
+}
+
+static void Finish(const GGLInterface * iface)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   if (!ctx->deferred)
+      return;
+   Flush(iface);
+   Wait(ctx->deferred);
+}
+
+// first command of a batch fixes the surfaces it draws to; SetBuffer flushes
+static Batch * Record(const GGLContext * ctx)
+{
+   Batch * batch = ctx->deferred->recording;
+   if (batch->commands.empty()) {
+      batch->frameSurface = ctx->frameSurface;
+      batch->depthSurface = ctx->depthSurface;
+      batch->stencilSurface = ctx->stencilSurface;
+   }
+   return batch;
+}
+
+void DeferTriangle(const GGLInterface * iface, const VertexOutput * v1,
+                   const VertexOutput * v2, const VertexOutput * v3)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   GGLDeferred * deferred = ctx->deferred;
+   assert(deferred);
+   Batch * batch = Record(ctx);
+
+   // programs are JIT for current state before raster, so function matches GGLState now
+   const gl_shader_program * program = ctx->CurrentProgram;
+   void (* function)() = program->_LinkedShaders[MESA_SHADER_FRAGMENT]->function;
+   const unsigned uniformSlots = program->Uniforms->Slots;
+   GGLRect clip;
+   ScissorRect(ctx, batch->frameSurface.width, batch->frameSurface.height, &clip);
+   if (clip.right < clip.left || clip.bottom < clip.top)
+      return; // nothing would be drawn
+   // program is NULL after Flush, so a new batch never shares the previous batch's snapshot
+   const bool uniformsChanged = deferred->program != program ||
+                                deferred->uniformGeneration != program->UniformGeneration;
+   if (batch->targets.empty() || uniformsChanged || deferred->function != function ||
+         memcmp(&batch->targets.back().clip, &clip, sizeof(clip))) {
+      GGLScanLineTarget target;
+      target.function = function;
+      target.varyingCount = program->VaryingSlots;
+      target.varyingFlat = program->VaryingFlat;
+      target.constants = uniformSlots ? program->ValuesUniform : NULL; // replaced in Bin
+      target.colorFormat = batch->frameSurface.format;
+      target.depthFormat = batch->depthSurface.format;
+      target.frameBuffer = batch->frameSurface.data;
+      target.depthBuffer = batch->depthSurface.data;
+      target.stencilBuffer = (unsigned char *)batch->stencilSurface.data;
+      target.width = batch->frameSurface.width;
+      target.height = batch->frameSurface.height;
+      target.clip = clip;
+      batch->targets.push_back(target);
+      if (uniformsChanged || batch->uniformOffsets.empty()) {
+         // whole snapshot, UniformGeneration does not say which slots were written
+         batch->uniformOffsets.push_back(batch->uniformCount);
+         if (uniformSlots) {
+            Vector4 * snapshot = batch->AllocUniforms(uniformSlots);
+            if (!snapshot) {
+               batch->targets.pop_back();
+               batch->uniformOffsets.pop_back();
+               deferred->program = NULL;
+               return gglError(GL_OUT_OF_MEMORY);
+            }
+            memcpy(snapshot, program->ValuesUniform, uniformSlots * sizeof(Vector4));
+         }
+      } else // same version, only clip or function changed
+         batch->uniformOffsets.push_back(batch->uniformOffsets.back());
+      deferred->program = program;
+      deferred->function = function;
+      deferred->uniformGeneration = program->UniformGeneration;
+   }
+
+   batch->commands.push_back(batch->triangles.size() << COMMAND_SHIFT | COMMAND_TRIANGLE);
+   batch->triangles.resize(batch->triangles.size() + 1);
+   DeferredTriangle & triangle = batch->triangles.back();
+   const unsigned stride = VertexOutputVectors(program->VaryingSlots);
+   triangle.vertices = batch->vertices.size();
+   batch->vertices.insert(batch->vertices.end(), (const Vector4 *)v1, (const Vector4 *)v1 + stride);
+   batch->vertices.insert(batch->vertices.end(), (const Vector4 *)v2, (const Vector4 *)v2 + stride);
+   batch->vertices.insert(batch->vertices.end(), (const Vector4 *)v3, (const Vector4 *)v3 + stride);
+   triangle.activeStencil = ctx->activeStencil;
+   triangle.target = batch->targets.size() - 1;
+
+   if (batch->triangles.size() >= MAX_BATCH_TRIANGLES)
+      Flush(iface);
+}
+
+void DeferClear(const GGLInterface * iface, GLbitfield buf)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   Batch * batch = Record(ctx);
+   batch->commands.push_back(batch->clearStates.size() << COMMAND_SHIFT | COMMAND_CLEAR);
+   batch->clearStates.push_back(ctx->clearState);
+   batch->clearBuffers.push_back(buf);
+   GGLRect rect; // clipped to each surface by ClearRect
+   ScissorRect(ctx, INT_MAX, INT_MAX, &rect);
+   batch->clearRects.push_back(rect);
+}
+
+void DeferRect(const GGLInterface * iface, const GGLRectBlit * blit)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   Batch * batch = Record(ctx);
+   batch->commands.push_back(batch->rects.size() << COMMAND_SHIFT | COMMAND_RECT);
+   batch->rects.push_back(*blit);
+}
+
+bool SetDeferredRendering(GGLInterface * iface, bool enable)
+{
+   GGL_GET_CONTEXT(ctx, iface);
+   if (enable == (NULL != ctx->deferred))
+      return false;
+
+   if (enable) {
+      GGLDeferred * deferred = new GGLDeferred();
+      deferred->recording = deferred->batches;
+      pthread_mutex_init(&deferred->lock, NULL);
+      pthread_cond_init(&deferred->startCond, NULL);
+      pthread_cond_init(&deferred->finishCond, NULL);
+
+      const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      const unsigned count = cpus > 0 ? MIN2((unsigned)cpus, MAX_WORKERS) : 1;
+      for (unsigned i = 0; i < count; i++) {
+         if (pthread_create(deferred->workers + i, NULL, ReplayWorker, deferred))
+            break;
+         deferred->workerCount++;
+      }
+      if (!deferred->workerCount) { // stay immediate
+         ALOGD("pf2: GGL_DEFERRED_RENDERING could not create worker threads");
+         pthread_cond_destroy(&deferred->startCond);
+         pthread_cond_destroy(&deferred->finishCond);
+         pthread_mutex_destroy(&deferred->lock);
+         delete deferred;
+         return false;
+      }
+      ctx->deferred = deferred;
+   } else {
+      GGLDeferred * deferred = ctx->deferred;
+      Finish(iface);
+      pthread_mutex_lock(&deferred->lock);
+      deferred->quit = true;
+      pthread_cond_broadcast(&deferred->startCond);
+      pthread_mutex_unlock(&deferred->lock);
+      for (unsigned i = 0; i < deferred->workerCount; i++)
+         pthread_join(deferred->workers[i], NULL);
+      pthread_cond_destroy(&deferred->startCond);
+      pthread_cond_destroy(&deferred->finishCond);
+      pthread_mutex_destroy(&deferred->lock);
+      delete deferred;
+      ctx->deferred = NULL;
+   }
+   return true;
+}
+
+void InitializeDeferredFunctions(GGLInterface * iface)
+{
+   iface->Flush = Flush;
+   iface->Finish = Finish;
+}
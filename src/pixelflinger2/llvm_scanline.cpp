@@ -18,6 +18,8 @@
 #include "src/pixelflinger2/pixelflinger2.h"
 #include "src/pixelflinger2/llvm_helper.h"
 #include "src/mesa/main/mtypes.h"
+#include "src/mesa/program/prog_parameter.h"
+#include "src/glsl/ir_to_llvm.h"
 
 #include <llvm/Module.h>
 
@@ -26,100 +28,157 @@
 
 using namespace llvm;
 
-static void StencilOp(IRBuilder<> &builder, const unsigned char op,
-                      Value * sPtr, Value * sRef)
+// stencil values are kept in registers; ops and funcs are selects, not branches
+static Value * StencilOp(IRBuilder<> &builder, const unsigned char op,
+                         Value * s, Value * sRef)
 {
-   CondBranch condBranch(builder);
-   Value * s = builder.CreateLoad(sPtr, "stenciOpS");
    switch (op) {
    case 0 : // GL_ZERO
-      builder.CreateStore(builder.getInt8(0), sPtr);
-      break;
+      return builder.getInt8(0);
    case 1 : // GL_KEEP
-      builder.CreateStore(s, sPtr);
-      break;
+      return s;
    case 2 : // GL_REPLACE
-      builder.CreateStore(sRef, sPtr);
-      break;
+      return sRef;
    case 3 : // GL_INCR
-      condBranch.ifCond(builder.CreateICmpEQ(s, builder.getInt8(255)));
-      builder.CreateStore(s, sPtr);
-      condBranch.elseop();
-      builder.CreateStore(builder.CreateAdd(s, builder.getInt8(1)), sPtr);
-      condBranch.endif();
-      break;
+      return builder.CreateSelect(builder.CreateICmpEQ(s, builder.getInt8(255)), s,
+                                  builder.CreateAdd(s, builder.getInt8(1)));
    case 4 : // GL_DECR
-      condBranch.ifCond(builder.CreateICmpEQ(s, builder.getInt8(0)));
-      builder.CreateStore(s, sPtr);
-      condBranch.elseop();
-      builder.CreateStore(builder.CreateSub(s, builder.getInt8(1)), sPtr);
-      condBranch.endif();
-      break;
+      return builder.CreateSelect(builder.CreateICmpEQ(s, builder.getInt8(0)), s,
+                                  builder.CreateSub(s, builder.getInt8(1)));
    case 5 : // GL_INVERT
-      builder.CreateStore(builder.CreateNot(s), sPtr);
-      break;
+      return builder.CreateNot(s);
    case 6 : // GL_INCR_WRAP
-      builder.CreateStore(builder.CreateAdd(s, builder.getInt8(1)), sPtr);
-      break;
+      return builder.CreateAdd(s, builder.getInt8(1));
    case 7 : // GL_DECR_WRAP
-      builder.CreateStore(builder.CreateSub(s, builder.getInt8(1)), sPtr);
-      break;
+      return builder.CreateSub(s, builder.getInt8(1));
    default:
       assert(0);
-      break;
+      return s;
    }
 }
 
 static Value * StencilOp(IRBuilder<> & builder, Value * face,
                          const unsigned char frontOp, const unsigned char backOp,
-                         Value * sPtr, Value * sRef)
+                         Value * s, Value * sRef)
 {
-   CondBranch condBranch(builder);
-   if (frontOp != backOp)
-      condBranch.ifCond(builder.CreateICmpEQ(face, builder.getInt8(0)));
-
-   StencilOp(builder, frontOp, sPtr, sRef);
-
-   if (frontOp != backOp) {
-      condBranch.elseop();
-      StencilOp(builder, backOp, sPtr, sRef);
-      condBranch.endif();
-   }
-   return builder.CreateLoad(sPtr);
+   Value * front = StencilOp(builder, frontOp, s, sRef);
+   if (frontOp == backOp)
+      return front;
+   Value * back = StencilOp(builder, backOp, s, sRef);
+   return builder.CreateSelect(builder.CreateICmpEQ(face, builder.getInt8(0)), front, back);
 }
 
-static void StencilFunc(IRBuilder<> & builder, const unsigned char func,
-                        Value * s, Value * sRef, Value * sCmpPtr)
+static Value * StencilFunc(IRBuilder<> & builder, const unsigned char func,
+                           Value * s, Value * sRef)
 {
    switch (func) {
    case GL_NEVER & 0x7:
-      builder.CreateStore(builder.getFalse(), sCmpPtr);
-      break;
+      return builder.getFalse();
    case GL_LESS & 0x7:
-      builder.CreateStore(builder.CreateICmpULT(sRef, s), sCmpPtr);
-      break;
+      return builder.CreateICmpULT(sRef, s);
    case GL_EQUAL & 0x7:
-      builder.CreateStore(builder.CreateICmpEQ(sRef, s), sCmpPtr);
-      break;
+      return builder.CreateICmpEQ(sRef, s);
    case GL_LEQUAL & 0x7:
-      builder.CreateStore(builder.CreateICmpULE(sRef, s), sCmpPtr);
-      break;
+      return builder.CreateICmpULE(sRef, s);
    case GL_GREATER & 0x7:
-      builder.CreateStore(builder.CreateICmpUGT(sRef, s), sCmpPtr);
-      break;
+      return builder.CreateICmpUGT(sRef, s);
    case GL_NOTEQUAL & 0x7:
-      builder.CreateStore(builder.CreateICmpNE(sRef, s), sCmpPtr);
-      break;
+      return builder.CreateICmpNE(sRef, s);
    case GL_GEQUAL & 0x7:
-      builder.CreateStore(builder.CreateICmpUGE(sRef, s), sCmpPtr);
-      break;
+      return builder.CreateICmpUGE(sRef, s);
    case GL_ALWAYS & 0x7:
-      builder.CreateStore(builder.getTrue(), sCmpPtr);
-      break;
+      return builder.getTrue();
+   default:
+      assert(0);
+      return builder.getTrue();
+   }
+}
+
+// z and depthZ are i32 or <4 x i32>, ordered as ints; returns i1 or <4 x i1>
+static Value * DepthFunc(IRBuilder<> & builder, const unsigned char func,
+                         Value * z, Value * depthZ)
+{
+   Type * const cmpType = CmpInst::makeCmpResultType(z->getType());
+   switch (0x200 | func) {
+   case GL_NEVER:
+      return Constant::getNullValue(cmpType);
+   case GL_LESS:
+      return builder.CreateICmpSLT(z, depthZ);
+   case GL_EQUAL:
+      return builder.CreateICmpEQ(z, depthZ);
+   case GL_LEQUAL:
+      return builder.CreateICmpSLE(z, depthZ);
+   case GL_GREATER:
+      return builder.CreateICmpSGT(z, depthZ);
+   case GL_NOTEQUAL:
+      return builder.CreateICmpNE(z, depthZ);
+   case GL_GEQUAL:
+      return builder.CreateICmpSGE(z, depthZ);
+   case GL_ALWAYS:
+      return Constant::getAllOnesValue(cmpType);
    default:
       assert(0);
       break;
    }
+   return NULL;
+}
+
+// int32 or vector of int32 with as many elements as type
+static Type * Int32Type(IRBuilder<> & builder, Type * type)
+{
+   if (VectorType * vectorType = dyn_cast<VectorType>(type))
+      return VectorType::get(builder.getInt32Ty(), vectorType->getNumElements());
+   return builder.getInt32Ty();
+}
+
+// Z_16 and SZ_24 keep window z clamped to [0, 1] as 16 or 24 bit fixed point;
+// z is float or vector of float, truncated the same way as the clear value
+static Value * FixedDepth(IRBuilder<> & builder, const GGLPixelFormat format, Value * z)
+{
+   Type * const type = z->getType();
+   Value * const zero = ConstantFP::get(type, 0), * const one = ConstantFP::get(type, 1);
+   z = builder.CreateSelect(builder.CreateFCmpOGT(z, zero), z, zero);
+   z = builder.CreateSelect(builder.CreateFCmpOLT(z, one), z, one);
+   z = builder.CreateFMul(z, ConstantFP::get(type, GGL_PIXEL_FORMAT_Z_16 == format ?
+                          0xffff : 0xffffff));
+   return builder.CreateFPToSI(z, Int32Type(builder, type));
+}
+
+// depth buffer value as loaded to the int z that DepthFunc compares
+static Value * LoadedDepth(IRBuilder<> & builder, const GGLPixelFormat format, Value * depthValue)
+{
+   if (GGL_PIXEL_FORMAT_Z_16 == format)
+      return builder.CreateZExt(depthValue, Int32Type(builder, depthValue->getType()));
+   if (GGL_PIXEL_FORMAT_SZ_24 == format) // stencil in high byte
+      return builder.CreateAnd(depthValue, ConstantInt::get(depthValue->getType(), 0xffffff));
+   return depthValue;
+}
+
+// z to depth buffer value, keeping the stencil byte of depthValue for SZ_24
+static Value * StoredDepth(IRBuilder<> & builder, const GGLPixelFormat format, Value * z,
+                           Value * depthValue)
+{
+   if (GGL_PIXEL_FORMAT_Z_16 == format)
+      return builder.CreateTrunc(z, depthValue->getType());
+   if (GGL_PIXEL_FORMAT_SZ_24 == format)
+      return builder.CreateOr(z, builder.CreateAnd(depthValue, ConstantInt::get(
+                                 depthValue->getType(), 0xff000000)));
+   return z;
+}
+
+// S_8 stencil has its own buffer; packed SZ_24 stencil goes to the high byte of depth
+// together with z, or with the depth already in depthValue if z is NULL
+static void StoreStencil(IRBuilder<> & builder, const bool packed, Value * s, Value * stencil,
+                         Value * depth, Value * depthValue, Value * z)
+{
+   if (!packed) {
+      builder.CreateStore(s, stencil);
+      return;
+   }
+   if (!z)
+      z = builder.CreateAnd(depthValue, builder.getInt32(0xffffff));
+   s = builder.CreateShl(builder.CreateZExt(s, builder.getInt32Ty()), 24);
+   builder.CreateStore(builder.CreateOr(s, z), depth);
 }
 
 static Value * BlendFactor(const unsigned mode, Value * src, Value * dst,
@@ -257,12 +316,22 @@ static Value * ScreenColorToIntVector(IRBuilder<> & builder, const GGLPixelForma
    return dst;
 }
 
-// src is <4 x float> approx [0,1]; dst is <4 x i32> [0,255] from frame buffer; return is i32
+// src is <4 x float> approx [0,1], or <4 x i32> [0,255] bitcast to <4 x float> for
+// GGL_CHANNEL_FIXED8, or i32 RGBA_8888 for GGL_CHANNEL_PACKED8;
+// dst is <4 x i32> [0,255] from frame buffer; return is i32
 Value * GenerateFSBlend(const GGLState * gglCtx, const GGLPixelFormat format, /*const RegDesc * regDesc,*/
-                        IRBuilder<> & builder, Value * src, Value * dst)
+                        const GGLChannelType srcType, IRBuilder<> & builder, Value * src, Value * dst)
 {
    Type * const intType = builder.getInt32Ty();
 
+   if (GGL_CHANNEL_PACKED8 == srcType) {
+      // texel is already in frame buffer layout
+      if (!gglCtx->blendState.enable && GGL_PIXEL_FORMAT_RGBA_8888 == format)
+         return src;
+      src = ScreenColorToIntVector(builder, GGL_PIXEL_FORMAT_RGBA_8888, src);
+   } else if (GGL_CHANNEL_FIXED8 == srcType) // fragment shader already converted and saturated
+      src = builder.CreateBitCast(src, intVecType(builder));
+
    // TODO cast the outputs pointer type to int for writing to minimize bandwidth
    if (!gglCtx->blendState.enable) {
 //        if (regDesc->IsInt32Color())
@@ -273,9 +342,11 @@ Value * GenerateFSBlend(const GGLState * gglCtx, const GGLPixelFormat format, /*
 //        }
 //        else if (regDesc->IsVectorType(Float))
 //        {
-      src = builder.CreateFMul(src, constFloatVec(builder,255,255,255,255));
-      src = builder.CreateFPToSI(src, intVecType(builder));
-      src = Saturate(builder, src);
+      if (GGL_CHANNEL_FLOAT == srcType) {
+         src = builder.CreateFMul(src, constFloatVec(builder,255,255,255,255));
+         src = builder.CreateFPToSI(src, intVecType(builder));
+         src = Saturate(builder, src);
+      }
       src = IntVectorToScreenColor(builder, format, src);
 //        }
 //        else if (regDesc->IsVectorType(Fixed8))
@@ -320,8 +391,10 @@ Value * GenerateFSBlend(const GGLState * gglCtx, const GGLPixelFormat format, /*
 //    }
 //    else if (regDesc->IsVectorType(Float))
 //    {
-   src = builder.CreateFMul(src, constFloatVec(builder,255,255,255,255));
-   src = builder.CreateFPToSI(src, intVecType(builder));
+   if (GGL_CHANNEL_FLOAT == srcType) {
+      src = builder.CreateFMul(src, constFloatVec(builder,255,255,255,255));
+      src = builder.CreateFPToSI(src, intVecType(builder));
+   }
 //    }
 //    else
 //        assert(0);
@@ -417,6 +490,282 @@ Value * GenerateFSBlend(const GGLState * gglCtx, const GGLPixelFormat format, /*
    return res;
 }
 
+Value * tex2D(IRBuilder<> & builder, Value * in1, const unsigned sampler,
+              const GGLState * gglCtx, const GGLChannelType dstType);
+
+// calls the fragment shader for the pixel at start, or inlines its passthrough,
+// and blends with frame; returns the color to store to frame
+static Value * ShadeFragment(IRBuilder<> & builder, const GGLState * gglCtx,
+                             const gl_shader_program * program, Function * fsFunction,
+                             const GGLFragmentPassthrough & passthrough,
+                             const GGLChannelType passthroughType, Value * passthroughColor,
+                             Value * start, Value * constants, Value * frame)
+{
+   Value * inputs = start;
+   Value * outputs = start;
+
+   Value * fsOutputs = builder.CreateConstInBoundsGEP1_32(start,
+                       offsetof(VertexOutput,fragColor)/sizeof(Vector4));
+
+   if (GGLFragmentPassthrough::GGL_PASSTHROUGH_NONE == passthrough.type) {
+      CallInst *call = builder.CreateCall3(fsFunction,inputs, outputs, constants);
+      call->setCallingConv(CallingConv::C);
+      call->setTailCall(false);
+   }
+
+   Value * dst = Constant::getNullValue(intVecType(builder));
+   if (gglCtx->blendState.enable && (0 != gglCtx->blendState.dcf || 0 != gglCtx->blendState.daf)) {
+      Value * frameColor = builder.CreateLoad(frame, "frameColor");
+      dst = ScreenColorToIntVector(builder, gglCtx->bufferState.colorFormat, frameColor);
+   }
+
+   if (GGLFragmentPassthrough::GGL_PASSTHROUGH_NONE == passthrough.type) {
+      Value * src = builder.CreateConstInBoundsGEP1_32(fsOutputs, 0);
+      src = builder.CreateLoad(src);
+
+      // ir_to_llvm_visitor::is_fixed8_color makes the same decision
+      GGLChannelType srcType = GGL_CHANNEL_FLOAT;
+      if (gglCtx->reducedPrecision && 0 <= _mesa_get_parameter(program->Varying, "gl_FragColor"))
+         srcType = GGL_CHANNEL_FIXED8;
+      return GenerateFSBlend(gglCtx, gglCtx->bufferState.colorFormat,/*&prog->outputRegDesc,*/
+                             srcType, builder, src, dst);
+   } else if (GGLFragmentPassthrough::GGL_PASSTHROUGH_TEXTURE == passthrough.type) {
+      Value * texcoord = builder.CreateConstInBoundsGEP1_32(start, passthrough.location);
+      texcoord = builder.CreateLoad(texcoord, "texcoord");
+      Value * texel = tex2D(builder, texcoord, passthrough.sampler, gglCtx, passthroughType);
+      return GenerateFSBlend(gglCtx, gglCtx->bufferState.colorFormat, passthroughType,
+                             builder, texel, dst);
+   } else if (gglCtx->blendState.enable)
+      return GenerateFSBlend(gglCtx, gglCtx->bufferState.colorFormat, GGL_CHANNEL_FIXED8,
+                             builder, passthroughColor, dst);
+   return passthroughColor;
+}
+
+// step of each varying slot, loaded once per span; NULL for flat slots
+struct VaryingSteps {
+   Value * dx[GGL_MAXVARYINGVECTORS];
+};
+
+static void LoadVaryingSteps(IRBuilder<> & builder, const gl_shader_program * program,
+                             Value * step, VaryingSteps * varyings)
+{
+   for (unsigned i = 0; i < program->VaryingSlots; ++i) {
+      varyings->dx[i] = NULL;
+      if (program->VaryingFlat & (1 << i))
+         continue;
+      Value * dx = builder.CreateConstInBoundsGEP1_32(step, GGL_FS_INPUT_OFFSET +
+                                                      GGL_FS_INPUT_VARYINGS_INDEX + i);
+      varyings->dx[i] = builder.CreateLoad(dx, "varyingDx");
+   }
+}
+
+// start += step * scale for fragcoord (or just its z for depth test), pointcoord and varyings;
+// every varying that is not flat is stepped here, including ones constant over the trapezoid.
+// Only the line stepping in raster.cpp skips those, through TrapezoidSteps::interpolated;
+// that mask changes per trapezoid while this code is generated per state, and their zero
+// step is cheaper to add than to test for every pixel
+static void StepFragmentInputs(IRBuilder<> & builder, const GGLState * gglCtx,
+                               const gl_shader_program * program, Value * start,
+                               Value * step, const VaryingSteps & varyings, const float scale)
+{
+   Value * const scaleVec = constFloatVec(builder, scale, scale, scale, scale);
+   Value * vPtr = NULL, * v = NULL, * dx = NULL;
+   if (program->UsesFragCoord) {
+      vPtr = builder.CreateConstInBoundsGEP1_32(start, GGL_FS_INPUT_OFFSET +
+             GGL_FS_INPUT_FRAGCOORD_INDEX);
+      v = builder.CreateLoad(vPtr);
+      dx = builder.CreateConstInBoundsGEP1_32(step, GGL_FS_INPUT_OFFSET +
+                                              GGL_FS_INPUT_FRAGCOORD_INDEX);
+      dx = builder.CreateLoad(dx);
+      if (1 != scale)
+         dx = builder.CreateFMul(dx, scaleVec);
+      v = builder.CreateFAdd(v, dx);
+      builder.CreateStore(v, vPtr);
+   } else if (gglCtx->bufferState.depthTest) {
+      Type * floatType = builder.getFloatTy();
+      PointerType * floatPointerType = PointerType::get(floatType, 0);
+      vPtr = builder.CreateBitCast(start, floatPointerType);
+      vPtr = builder.CreateConstInBoundsGEP1_32(vPtr,
+             (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_FRAGCOORD_INDEX) * 4 + 2);
+      v = builder.CreateLoad(vPtr);
+      dx = builder.CreateBitCast(step, floatPointerType);
+      dx = builder.CreateConstInBoundsGEP1_32(dx,
+                                              (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_FRAGCOORD_INDEX) * 4 + 2);
+      dx = builder.CreateLoad(dx);
+      if (1 != scale)
+         dx = builder.CreateFMul(dx, constFloat(builder, scale));
+      v = builder.CreateFAdd(v, dx);
+      builder.CreateStore(v, vPtr);
+   }
+
+   if (program->UsesPointCoord) {
+      vPtr = builder.CreateConstInBoundsGEP1_32(start, GGL_FS_INPUT_OFFSET +
+             GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX);
+      v = builder.CreateLoad(vPtr);
+      dx = builder.CreateConstInBoundsGEP1_32(step, GGL_FS_INPUT_OFFSET +
+                                              GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX);
+      dx = builder.CreateLoad(dx);
+      if (1 != scale)
+         dx = builder.CreateFMul(dx, scaleVec);
+      v = builder.CreateFAdd(v, dx);
+      builder.CreateStore(v, vPtr);
+   }
+
+   for (unsigned i = 0; i < program->VaryingSlots; ++i) {
+      if (!varyings.dx[i])
+         continue; // flat
+      vPtr = builder.CreateConstInBoundsGEP1_32(start, offsetof(VertexOutput,varyings)/sizeof(Vector4) + i);
+      v = builder.CreateLoad(vPtr);
+      dx = varyings.dx[i];
+      if (1 != scale)
+         dx = builder.CreateFMul(dx, scaleVec);
+      v = builder.CreateFAdd(v, dx);
+      builder.CreateStore(v, vPtr);
+   }
+}
+
+// pixels per iteration of GenerateScanLineGroups, so depth is one <4 x i32>
+static const unsigned GGL_SCANLINE_GROUP = 4;
+
+// loop carried value; the back edge is added with addIncoming before endLoop
+static PHINode * LoopValue(IRBuilder<> & builder, BasicBlock * preheader, Value * value,
+                           const char * name)
+{
+   PHINode * phi = builder.CreatePHI(value->getType(), 2, name);
+   phi->addIncoming(value, preheader);
+   return phi;
+}
+
+// while (count >= GGL_SCANLINE_GROUP): depth test, depth store and constant color
+// store are done for the whole group with vector compare and select; groups failing
+// the depth test for every pixel skip shading and step inputs once; the per pixel
+// loop that follows finishes the tail without touching memory past the span
+static void GenerateScanLineGroups(IRBuilder<> & builder, const GGLState * gglCtx,
+                                   const gl_shader_program * program, Function * fsFunction,
+                                   const GGLFragmentPassthrough & passthrough,
+                                   const GGLChannelType passthroughType, Value * passthroughColor,
+                                   Value * start, Value * step, const VaryingSteps & varyings,
+                                   Value * constants, Value *& frame, Value *& depth,
+                                   Value *& count)
+{
+   const unsigned group = GGL_SCANLINE_GROUP;
+   const GGLPixelFormat depthFormat = gglCtx->bufferState.depthFormat;
+   Type * const intType = builder.getInt32Ty();
+   Type * const floatType = builder.getFloatTy();
+   Type * const colorType = GGL_PIXEL_FORMAT_RGB_565 == gglCtx->bufferState.colorFormat ?
+                            builder.getInt16Ty() : intType;
+   const bool constantColor = !gglCtx->blendState.enable &&
+                              (GGLFragmentPassthrough::GGL_PASSTHROUGH_UNIFORM == passthrough.type ||
+                               GGLFragmentPassthrough::GGL_PASSTHROUGH_CONSTANT == passthrough.type);
+   CondBranch condBranch(builder);
+
+   BasicBlock * preheader = builder.GetInsertBlock();
+   condBranch.beginLoop(); // while (count >= group)
+
+   PHINode * countPhi = LoopValue(builder, preheader, count, "groupCount");
+   PHINode * framePhi = LoopValue(builder, preheader, frame, "groupFramePtr");
+   PHINode * depthPhi = NULL;
+   if (gglCtx->bufferState.depthTest)
+      depthPhi = LoopValue(builder, preheader, depth, "groupDepth");
+
+   condBranch.ifCond(builder.CreateICmpSLT(countPhi, builder.getInt32(group)), "if_break_group_loop");
+   condBranch.brk();
+   condBranch.endif();
+
+   Value * groupFrame = builder.CreateBitCast(framePhi, PointerType::get(colorType, 0), "groupFrame");
+
+   Value * zMask = Constant::getAllOnesValue(VectorType::get(builder.getInt1Ty(), group));
+   Value * depthVecPtr = NULL, * depthValue = NULL, * depthZ = NULL, * z = NULL;
+   const unsigned depthAlign = GGL_PIXEL_FORMAT_Z_16 == depthFormat ? 2 : 4;
+   if (gglCtx->bufferState.depthTest) {
+      Type * const depthType = GGL_PIXEL_FORMAT_Z_16 == depthFormat ? builder.getInt16Ty() : intType;
+      depthVecPtr = builder.CreateBitCast(depthPhi, PointerType::get(VectorType::get(depthType, group), 0));
+      LoadInst * depthLoad = builder.CreateLoad(depthVecPtr, "groupDepthValue");
+      depthLoad->setAlignment(depthAlign);
+      depthValue = depthLoad;
+      depthZ = LoadedDepth(builder, depthFormat, depthValue);
+
+      // z of each pixel, accumulated the same way the per pixel loop steps it
+      PointerType * floatPointerType = PointerType::get(floatType, 0);
+      const unsigned zIndex = (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_FRAGCOORD_INDEX) * 4 + 2;
+      Value * zf = builder.CreateBitCast(start, floatPointerType);
+      zf = builder.CreateLoad(builder.CreateConstInBoundsGEP1_32(zf, zIndex), "z");
+      Value * dz = builder.CreateBitCast(step, floatPointerType);
+      dz = builder.CreateLoad(builder.CreateConstInBoundsGEP1_32(dz, zIndex), "dz");
+      z = UndefValue::get(VectorType::get(floatType, group));
+      for (unsigned i = 0; i < group; i++) {
+         z = builder.CreateInsertElement(z, zf, builder.getInt32(i));
+         zf = builder.CreateFAdd(zf, dz);
+      }
+      if (GGL_PIXEL_FORMAT_Z_32 == depthFormat) {
+         z = builder.CreateBitCast(z, intVecType(builder));
+         // if (0x80000000 & z) z ^= 0x7fffffff since smaller -ve float means bigger -ve int
+         Value * sign = builder.CreateAShr(z, constIntVec(builder, 31, 31, 31, 31));
+         z = builder.CreateXor(z, builder.CreateAnd(sign, constIntVec(builder, 0x7fffffff,
+                               0x7fffffff, 0x7fffffff, 0x7fffffff)), "groupZ");
+      } else
+         z = FixedDepth(builder, depthFormat, z);
+      zMask = DepthFunc(builder, gglCtx->bufferState.depthFunc, z, depthZ);
+   }
+
+   Value * anyPass = builder.getFalse();
+   for (unsigned i = 0; i < group; i++)
+      anyPass = builder.CreateOr(anyPass, builder.CreateExtractElement(zMask, builder.getInt32(i)));
+
+   condBranch.ifCond(anyPass, "if_group_zCmp", "group_zCmp_fail");
+   if (constantColor) {
+      // passthroughColor is already in screen format, select it into the group
+      Value * frameVecPtr = builder.CreateBitCast(groupFrame, PointerType::get(
+                               VectorType::get(colorType, group), 0));
+      LoadInst * frameColor = builder.CreateLoad(frameVecPtr, "groupFrameColor");
+      frameColor->setAlignment(2);
+      Value * color = UndefValue::get(frameColor->getType());
+      for (unsigned i = 0; i < group; i++)
+         color = builder.CreateInsertElement(color, passthroughColor, builder.getInt32(i));
+      color = builder.CreateSelect(zMask, color, frameColor);
+      builder.CreateStore(color, frameVecPtr)->setAlignment(2);
+      StepFragmentInputs(builder, gglCtx, program, start, step, varyings, group);
+   } else
+      for (unsigned i = 0; i < group; i++) {
+         condBranch.ifCond(builder.CreateExtractElement(zMask, builder.getInt32(i)),
+                           "if_lane_zCmp", "lane_zCmp_fail");
+         Value * laneFrame = builder.CreateConstInBoundsGEP1_32(groupFrame, i);
+         Value * color = ShadeFragment(builder, gglCtx, program, fsFunction, passthrough,
+                                       passthroughType, passthroughColor, start, constants,
+                                       laneFrame);
+         builder.CreateStore(color, laneFrame);
+         condBranch.endif();
+         StepFragmentInputs(builder, gglCtx, program, start, step, varyings, 1);
+      }
+   // TODO DXL depthmask check
+   if (gglCtx->bufferState.depthTest)
+      builder.CreateStore(builder.CreateSelect(zMask, StoredDepth(builder, depthFormat, z, depthValue),
+                                               depthValue), depthVecPtr)->setAlignment(depthAlign);
+   condBranch.elseop(); // every pixel failed z test
+   StepFragmentInputs(builder, gglCtx, program, start, step, varyings, group);
+   condBranch.endif();
+
+   Value * nextFrame = builder.CreateConstInBoundsGEP1_32(groupFrame, group);
+   nextFrame = builder.CreateBitCast(nextFrame, PointerType::get(intType, 0));
+   Value * nextDepth = NULL;
+   if (gglCtx->bufferState.depthTest)
+      nextDepth = builder.CreateConstInBoundsGEP1_32(depthPhi, group);
+   Value * nextCount = builder.CreateSub(countPhi, builder.getInt32(group));
+
+   BasicBlock * latch = builder.GetInsertBlock();
+   framePhi->addIncoming(nextFrame, latch);
+   if (gglCtx->bufferState.depthTest)
+      depthPhi->addIncoming(nextDepth, latch);
+   countPhi->addIncoming(nextCount, latch);
+
+   condBranch.endLoop();
+
+   // the loop is only left through the break at its top
+   count = countPhi;
+   frame = framePhi;
+   depth = depthPhi;
+}
+
 static FunctionType * ScanLineFunctionType(IRBuilder<> & builder)
 {
    std::vector<Type*> funcArgs;
@@ -443,7 +792,7 @@ static FunctionType * ScanLineFunctionType(IRBuilder<> & builder)
 }
 
 // generated scanline function parameters are VertexOutput * start, VertexOutput * step,
-// unsigned * frame, int * depth, unsigned char * stencil,
+// unsigned * frame, void * depth (Z_32, Z_16 or SZ_24), unsigned char * stencil (S_8),
 // GGLActiveStencilState * stencilState, unsigned count
 void GenerateScanLine(const GGLState * gglCtx, const gl_shader_program * program, Module * mod,
                       const char * shaderName, const char * scanlineName)
@@ -453,8 +802,6 @@ void GenerateScanLine(const GGLState * gglCtx, const gl_shader_program * program
 
    Type * intType = builder.getInt32Ty();
    PointerType * intPointerType = PointerType::get(intType, 0);
-   Type * byteType = builder.getInt8Ty();
-   PointerType * bytePointerType = PointerType::get(byteType, 0);
 
    Function * func = mod->getFunction(scanlineName);
    if (func)
@@ -475,17 +822,34 @@ void GenerateScanLine(const GGLState * gglCtx, const gl_shader_program * program
    Value * constants = args++;
    constants->setName("constants");
 
-   // need alloc to be able to assign to it by using store
-   Value * framePtr = builder.CreateAlloca(intPointerType);
-   builder.CreateStore(args++, framePtr);
-   Value * depthPtr = builder.CreateAlloca(intPointerType);
-   builder.CreateStore(args++, depthPtr);
-   Value * stencilPtr = builder.CreateAlloca(bytePointerType);
-   builder.CreateStore(args++, stencilPtr);
+   // frame, depth, stencil and count are stepped as loop carried SSA values
+   Value * frame = args++;
+   frame->setName("frame");
+   Value * depth = args++;
+   depth->setName("depth");
+   Value * stencil = args++;
+   stencil->setName("stencil");
    Value * stencilState = args++;
    stencilState->setName("stencilState");
-   Value * countPtr = builder.CreateAlloca(intType);
-   builder.CreateStore(args++, countPtr);
+   Value * count = args++;
+   count->setName("count");
+
+   VaryingSteps varyings;
+   LoadVaryingSteps(builder, program, step, &varyings);
+
+   // SZ_24 keeps stencil in the high byte of depth, so one 32 bit load and store
+   // through depth serves both tests; any S_8 surface is ignored, as in ClearRect
+   const GGLPixelFormat depthFormat = gglCtx->bufferState.depthFormat;
+   const bool packedStencil = gglCtx->bufferState.stencilTest &&
+                              GGL_PIXEL_FORMAT_SZ_24 == depthFormat;
+   const bool depthBuffer = gglCtx->bufferState.depthTest || packedStencil;
+   const bool stencilBuffer = gglCtx->bufferState.stencilTest && !packedStencil;
+   assert(!gglCtx->bufferState.depthTest || GGL_PIXEL_FORMAT_Z_32 == depthFormat ||
+          GGL_PIXEL_FORMAT_Z_16 == depthFormat || GGL_PIXEL_FORMAT_SZ_24 == depthFormat);
+   assert(!gglCtx->bufferState.stencilTest || packedStencil ||
+          GGL_PIXEL_FORMAT_SZ_24 != gglCtx->bufferState.stencilFormat);
+   if (GGL_PIXEL_FORMAT_Z_16 == depthFormat)
+      depth = builder.CreateBitCast(depth, PointerType::get(builder.getInt16Ty(), 0), "depth16");
 
    Value * sFace = NULL, * sRef = NULL, *sMask = NULL, * sFunc = NULL;
    if (gglCtx->bufferState.stencilTest) {
@@ -504,121 +868,113 @@ void GenerateScanLine(const GGLState * gglCtx, const gl_shader_program * program
          sFunc = builder.CreateLoad(builder.CreateConstInBoundsGEP1_32(stencilState, 3), "sFunc");
    }
 
-   condBranch.beginLoop(); // while (count > 0)
+   // shaders that only write a texel or a constant to gl_FragColor are not called;
+   // the color stays integer from the texel fetch through blending
+   GGLFragmentPassthrough passthrough;
+   glsl_fragment_passthrough(program->_LinkedShaders[MESA_SHADER_FRAGMENT]->ir, &passthrough);
+   GGLChannelType passthroughType = GGL_CHANNEL_FIXED8;
+   Value * passthroughColor = NULL;
+   if (GGLFragmentPassthrough::GGL_PASSTHROUGH_TEXTURE == passthrough.type) {
+      const GGLTexture & texture = gglCtx->textureState.textures[passthrough.sampler];
+      if (0 == texture.minFilter && 0 == texture.magFilter) // GL_NEAREST
+         passthroughType = GGL_CHANNEL_PACKED8;
+   } else if (GGLFragmentPassthrough::GGL_PASSTHROUGH_NONE != passthrough.type) {
+      // constant color is converted once per scanline, and constant folded if literal
+      if (GGLFragmentPassthrough::GGL_PASSTHROUGH_UNIFORM == passthrough.type)
+         passthroughColor = builder.CreateLoad(builder.CreateConstInBoundsGEP1_32(constants,
+                                               passthrough.location), "uniformColor");
+      else
+         passthroughColor = constFloatVec(builder, passthrough.color[0], passthrough.color[1],
+                                          passthrough.color[2], passthrough.color[3]);
+      passthroughColor = builder.CreateFMul(passthroughColor, constFloatVec(builder,255,255,255,255));
+      passthroughColor = builder.CreateFPToSI(passthroughColor, intVecType(builder));
+      passthroughColor = Saturate(builder, passthroughColor);
+      if (!gglCtx->blendState.enable)
+         passthroughColor = IntVectorToScreenColor(builder, gglCtx->bufferState.colorFormat,
+                                                   passthroughColor);
+   }
 
-   assert(framePtr && gglCtx);
-   // get values
-   Value * frame = NULL;
-   if (GGL_PIXEL_FORMAT_RGBA_8888 == gglCtx->bufferState.colorFormat)
-      frame = builder.CreateLoad(framePtr);
-   else if (GGL_PIXEL_FORMAT_RGB_565 == gglCtx->bufferState.colorFormat) {
-      frame = builder.CreateLoad(framePtr);
-      frame = builder.CreateBitCast(frame, PointerType::get(builder.getInt16Ty(), 0));
-   } else if (GGL_PIXEL_FORMAT_UNKNOWN == gglCtx->bufferState.colorFormat)
-      frame = builder.CreateLoad(framePtr); // color buffer not set yet
-   else
-      assert(0);
+   Function * fsFunction = mod->getFunction(shaderName);
+   assert(fsFunction);
 
-   frame->setName("frame");
-   Value * depth = NULL, * stencil = NULL;
-   if (gglCtx->bufferState.depthTest) {
-      assert(GGL_PIXEL_FORMAT_Z_32 == gglCtx->bufferState.depthFormat);
-      depth = builder.CreateLoad(depthPtr);
-      depth->setName("depth");
-   }
+   // stencil ops are per pixel read-modify-write, so stencil test stays per pixel
+   if (!gglCtx->bufferState.stencilTest &&
+         GGL_PIXEL_FORMAT_UNKNOWN != gglCtx->bufferState.colorFormat)
+      GenerateScanLineGroups(builder, gglCtx, program, fsFunction, passthrough,
+                             passthroughType, passthroughColor, start, step, varyings,
+                             constants, frame, depth, count);
 
-   Value * count = builder.CreateLoad(countPtr);
-   count->setName("count");
+   BasicBlock * preheader = builder.GetInsertBlock();
+   condBranch.beginLoop(); // while (count > 0)
+
+   assert(frame && gglCtx);
+   PHINode * framePhi = LoopValue(builder, preheader, frame, "framePtr");
+   PHINode * depthPhi = NULL, * stencilPhi = NULL;
+   if (depthBuffer)
+      depthPhi = LoopValue(builder, preheader, depth, "depth");
+   if (stencilBuffer)
+      stencilPhi = LoopValue(builder, preheader, stencil, "stencil");
+   PHINode * countPhi = LoopValue(builder, preheader, count, "count");
 
-   Value * cmp = builder.CreateICmpEQ(count, builder.getInt32(0));
+   // get values
+   frame = framePhi;
+   if (GGL_PIXEL_FORMAT_RGB_565 == gglCtx->bufferState.colorFormat)
+      frame = builder.CreateBitCast(frame, PointerType::get(builder.getInt16Ty(), 0), "frame");
+   else // GGL_PIXEL_FORMAT_UNKNOWN when color buffer not set yet
+      assert(GGL_PIXEL_FORMAT_RGBA_8888 == gglCtx->bufferState.colorFormat ||
+             GGL_PIXEL_FORMAT_UNKNOWN == gglCtx->bufferState.colorFormat);
+   depth = depthPhi;
+   stencil = stencilPhi;
+
+   Value * cmp = builder.CreateICmpEQ(countPhi, builder.getInt32(0));
    condBranch.ifCond(cmp, "if_break_loop"); // if (count == 0)
    condBranch.brk(); // break;
    condBranch.endif();
 
-   Value * sCmpPtr = NULL, * sCmp = NULL, * sPtr = NULL, * s = NULL;
-   if (gglCtx->bufferState.stencilTest) {
-      stencil = builder.CreateLoad(stencilPtr);
-      stencil->setName("stencil");
-
-      // temporaries to load/store value
-      sCmpPtr = builder.CreateAlloca(builder.getInt1Ty());
-      sCmpPtr->setName("sCmpPtr");
-      sPtr = builder.CreateAlloca(byteType);
-      sPtr->setName("sPtr");
+   Value * depthValue = NULL; // as stored, SZ_24 also has stencil
+   if (depthBuffer)
+      depthValue = builder.CreateLoad(depth, "depthValue");
 
-      s = builder.CreateLoad(stencil);
-      s = builder.CreateAnd(s, sMask);
-      builder.CreateStore(s, sPtr);
+   Value * sCmp = NULL, * s = NULL;
+   if (gglCtx->bufferState.stencilTest) {
+      if (packedStencil)
+         s = builder.CreateTrunc(builder.CreateLShr(depthValue, builder.getInt32(24)),
+                                 builder.getInt8Ty());
+      else
+         s = builder.CreateLoad(stencil);
+      s = builder.CreateAnd(s, sMask, "s");
 
+      sCmp = StencilFunc(builder, gglCtx->frontStencil.func, s, sRef);
       if (gglCtx->frontStencil.func != gglCtx->backStencil.func)
-         condBranch.ifCond(builder.CreateICmpEQ(sFace, builder.getInt8(0)));
-
-      StencilFunc(builder, gglCtx->frontStencil.func, s, sRef, sCmpPtr);
-
-      if (gglCtx->frontStencil.func != gglCtx->backStencil.func) {
-         condBranch.elseop();
-         StencilFunc(builder, gglCtx->backStencil.func, s, sRef, sCmpPtr);
-         condBranch.endif();
-      }
-
-      sCmp = builder.CreateLoad(sCmpPtr);
+         sCmp = builder.CreateSelect(builder.CreateICmpEQ(sFace, builder.getInt8(0)), sCmp,
+                                     StencilFunc(builder, gglCtx->backStencil.func, s, sRef));
    } else
       sCmp = ConstantInt::getTrue(mod->getContext());
    sCmp->setName("sCmp");
 
-   Value * depthZ = NULL, * zPtr = NULL, * z = NULL, * zCmp = NULL;
+   Value * depthZ = NULL, * z = NULL, * zCmp = NULL;
    if (gglCtx->bufferState.depthTest) {
-      depthZ  = builder.CreateLoad(depth, "depthZ"); // z stored in buffer
-      zPtr = builder.CreateAlloca(intType); // temp store for modifying incoming z
-      zPtr->setName("zPtr");
+      depthZ = LoadedDepth(builder, depthFormat, depthValue); // z stored in buffer
+      depthZ->setName("depthZ");
 
       // modified incoming z
-      z = builder.CreateBitCast(start, intPointerType);
-      z = builder.CreateConstInBoundsGEP1_32(z, (GGL_FS_INPUT_OFFSET +
-                                             GGL_FS_INPUT_FRAGCOORD_INDEX) * 4 + 2);
-      z = builder.CreateLoad(z, "z");
-
-      builder.CreateStore(z, zPtr);
-
-      Value * zNegative = builder.CreateICmpSLT(z, builder.getInt32(0));
-      condBranch.ifCond(zNegative);
-      // if (0x80000000 & z) z ^= 0x7fffffff since smaller -ve float means bigger -ve int
-      z = builder.CreateXor(z, builder.getInt32(0x7fffffff));
-      builder.CreateStore(z, zPtr);
-
-      condBranch.endif();
-
-      z = builder.CreateLoad(zPtr, "z");
-
-      switch (0x200 | gglCtx->bufferState.depthFunc) {
-      case GL_NEVER:
-         zCmp = ConstantInt::getFalse(mod->getContext());
-         break;
-      case GL_LESS:
-         zCmp = builder.CreateICmpSLT(z, depthZ);
-         break;
-      case GL_EQUAL:
-         zCmp = builder.CreateICmpEQ(z, depthZ);
-         break;
-      case GL_LEQUAL:
-         zCmp = builder.CreateICmpSLE(z, depthZ);
-         break;
-      case GL_GREATER:
-         zCmp = builder.CreateICmpSGT(z, depthZ);
-         break;
-      case GL_NOTEQUAL:
-         zCmp = builder.CreateICmpNE(z, depthZ);
-         break;
-      case GL_GEQUAL:
-         zCmp = builder.CreateICmpSGE(z, depthZ);
-         break;
-      case GL_ALWAYS:
-         zCmp = ConstantInt::getTrue(mod->getContext());
-         break;
-      default:
-         assert(0);
-         break;
+      const unsigned zIndex = (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_FRAGCOORD_INDEX) * 4 + 2;
+      if (GGL_PIXEL_FORMAT_Z_32 == depthFormat) {
+         z = builder.CreateBitCast(start, intPointerType);
+         z = builder.CreateConstInBoundsGEP1_32(z, zIndex);
+         z = builder.CreateLoad(z, "z");
+
+         // if (0x80000000 & z) z ^= 0x7fffffff since smaller -ve float means bigger -ve int
+         Value * zNegative = builder.CreateICmpSLT(z, builder.getInt32(0));
+         z = builder.CreateSelect(zNegative, builder.CreateXor(z, builder.getInt32(0x7fffffff)),
+                                  z, "z");
+      } else {
+         z = builder.CreateBitCast(start, PointerType::get(builder.getFloatTy(), 0));
+         z = builder.CreateLoad(builder.CreateConstInBoundsGEP1_32(z, zIndex), "zf");
+         z = FixedDepth(builder, depthFormat, z);
       }
+
+      zCmp = DepthFunc(builder, gglCtx->bufferState.depthFunc, z, depthZ);
    } else // no depth test means always pass
       zCmp = ConstantInt::getTrue(mod->getContext());
    zCmp->setName("zCmp");
@@ -626,113 +982,51 @@ void GenerateScanLine(const GGLState * gglCtx, const gl_shader_program * program
    condBranch.ifCond(sCmp, "if_sCmp", "sCmp_fail");
    condBranch.ifCond(zCmp, "if_zCmp", "zCmp_fail");
 
-   Value * inputs = start;
-   Value * outputs = start;
-
-   Value * fsOutputs = builder.CreateConstInBoundsGEP1_32(start,
-                       offsetof(VertexOutput,fragColor)/sizeof(Vector4));
-
-   Function * fsFunction = mod->getFunction(shaderName);
-   assert(fsFunction);
-   CallInst *call = builder.CreateCall3(fsFunction,inputs, outputs, constants);
-   call->setCallingConv(CallingConv::C);
-   call->setTailCall(false);
-
-   Value * dst = Constant::getNullValue(intVecType(builder));
-   if (gglCtx->blendState.enable && (0 != gglCtx->blendState.dcf || 0 != gglCtx->blendState.daf)) {
-      Value * frameColor = builder.CreateLoad(frame, "frameColor");
-      dst = ScreenColorToIntVector(builder, gglCtx->bufferState.colorFormat, frameColor);
-   }
-
-   Value * src = builder.CreateConstInBoundsGEP1_32(fsOutputs, 0);
-   src = builder.CreateLoad(src);
-
-   Value * color = GenerateFSBlend(gglCtx, gglCtx->bufferState.colorFormat,/*&prog->outputRegDesc,*/ builder, src, dst);
+   Value * color = ShadeFragment(builder, gglCtx, program, fsFunction, passthrough,
+                                 passthroughType, passthroughColor, start, constants, frame);
    builder.CreateStore(color, frame);
    // TODO DXL depthmask check
-   if (gglCtx->bufferState.depthTest) {
+   if (gglCtx->bufferState.depthTest && !packedStencil) {
       z = builder.CreateBitCast(z, intType);
-      builder.CreateStore(z, depth); // store z
+      builder.CreateStore(StoredDepth(builder, depthFormat, z, depthValue), depth); // store z
    }
 
    if (gglCtx->bufferState.stencilTest)
-      builder.CreateStore(StencilOp(builder, sFace, gglCtx->frontStencil.dPass,
-                                    gglCtx->backStencil.dPass, sPtr, sRef), stencil);
+      StoreStencil(builder, packedStencil, StencilOp(builder, sFace, gglCtx->frontStencil.dPass,
+                   gglCtx->backStencil.dPass, s, sRef), stencil, depth, depthValue,
+                   gglCtx->bufferState.depthTest ? z : NULL);
 
    condBranch.elseop(); // failed z test
 
    if (gglCtx->bufferState.stencilTest)
-      builder.CreateStore(StencilOp(builder, sFace, gglCtx->frontStencil.dFail,
-                                    gglCtx->backStencil.dFail, sPtr, sRef), stencil);
+      StoreStencil(builder, packedStencil, StencilOp(builder, sFace, gglCtx->frontStencil.dFail,
+                   gglCtx->backStencil.dFail, s, sRef), stencil, depth, depthValue, NULL);
    condBranch.endif();
    condBranch.elseop(); // failed s test
 
    if (gglCtx->bufferState.stencilTest)
-      builder.CreateStore(StencilOp(builder, sFace, gglCtx->frontStencil.sFail,
-                                    gglCtx->backStencil.sFail, sPtr, sRef), stencil);
+      StoreStencil(builder, packedStencil, StencilOp(builder, sFace, gglCtx->frontStencil.sFail,
+                   gglCtx->backStencil.sFail, s, sRef), stencil, depth, depthValue, NULL);
 
    condBranch.endif();
    assert(frame);
    frame = builder.CreateConstInBoundsGEP1_32(frame, 1); // frame++
    // frame may have been casted to short* from int*, so cast back
    frame = builder.CreateBitCast(frame, PointerType::get(builder.getInt32Ty(), 0));
-   builder.CreateStore(frame, framePtr);
-   if (gglCtx->bufferState.depthTest) {
+   if (depthBuffer)
       depth = builder.CreateConstInBoundsGEP1_32(depth, 1); // depth++
-      builder.CreateStore(depth, depthPtr);
-   }
-   if (gglCtx->bufferState.stencilTest) {
+   if (stencilBuffer)
       stencil = builder.CreateConstInBoundsGEP1_32(stencil, 1); // stencil++
-      builder.CreateStore(stencil, stencilPtr);
-   }
-   Value * vPtr = NULL, * v = NULL, * dx = NULL;
-   if (program->UsesFragCoord) {
-      vPtr = builder.CreateConstInBoundsGEP1_32(start, GGL_FS_INPUT_OFFSET +
-             GGL_FS_INPUT_FRAGCOORD_INDEX);
-      v = builder.CreateLoad(vPtr);
-      dx = builder.CreateConstInBoundsGEP1_32(step, GGL_FS_INPUT_OFFSET +
-                                              GGL_FS_INPUT_FRAGCOORD_INDEX);
-      dx = builder.CreateLoad(dx);
-      v = builder.CreateFAdd(v, dx);
-      builder.CreateStore(v, vPtr);
-   } else if (gglCtx->bufferState.depthTest) {
-      Type * floatType = builder.getFloatTy();
-      PointerType * floatPointerType = PointerType::get(floatType, 0);
-      vPtr = builder.CreateBitCast(start, floatPointerType);
-      vPtr = builder.CreateConstInBoundsGEP1_32(vPtr,
-             (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_FRAGCOORD_INDEX) * 4 + 2);
-      v = builder.CreateLoad(vPtr);
-      dx = builder.CreateBitCast(step, floatPointerType);
-      dx = builder.CreateConstInBoundsGEP1_32(dx,
-                                              (GGL_FS_INPUT_OFFSET + GGL_FS_INPUT_FRAGCOORD_INDEX) * 4 + 2);
-      dx = builder.CreateLoad(dx);
-      v = builder.CreateFAdd(v, dx);
-      builder.CreateStore(v, vPtr);
-   }
-
-   if (program->UsesPointCoord) {
-      vPtr = builder.CreateConstInBoundsGEP1_32(start, GGL_FS_INPUT_OFFSET +
-             GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX);
-      v = builder.CreateLoad(vPtr);
-      dx = builder.CreateConstInBoundsGEP1_32(step, GGL_FS_INPUT_OFFSET +
-                                              GGL_FS_INPUT_FRONTFACINGPOINTCOORD_INDEX);
-      dx = builder.CreateLoad(dx);
-      v = builder.CreateFAdd(v, dx);
-      builder.CreateStore(v, vPtr);
-   }
-
-   for (unsigned i = 0; i < program->VaryingSlots; ++i) {
-      vPtr = builder.CreateConstInBoundsGEP1_32(start, offsetof(VertexOutput,varyings)/sizeof(Vector4) + i);
-      v = builder.CreateLoad(vPtr);
-      dx = builder.CreateConstInBoundsGEP1_32(step, GGL_FS_INPUT_OFFSET +
-                                              GGL_FS_INPUT_VARYINGS_INDEX + i);
-      dx = builder.CreateLoad(dx);
-      v = builder.CreateFAdd(v, dx);
-      builder.CreateStore(v, vPtr);
-   }
-
-   count = builder.CreateSub(count, builder.getInt32(1));
-   builder.CreateStore(count, countPtr); // count--;
+   StepFragmentInputs(builder, gglCtx, program, start, step, varyings, 1);
+   count = builder.CreateSub(countPhi, builder.getInt32(1)); // count--;
+
+   BasicBlock * latch = builder.GetInsertBlock();
+   framePhi->addIncoming(frame, latch);
+   if (depthBuffer)
+      depthPhi->addIncoming(depth, latch);
+   if (stencilBuffer)
+      stencilPhi->addIncoming(stencil, latch);
+   countPhi->addIncoming(count, latch);
 
    condBranch.endLoop();
 
@@ -23,12 +23,15 @@
 #include <llvm/Module.h>
 
 #include "src/pixelflinger2/llvm_helper.h"
+#include "src/glsl/ir_to_llvm.h"
 
 using namespace llvm;
 
 // texture data is int pointer to surface (will cast to short for 16bpp), index is linear texel index,
-// format is GGLPixelFormat for surface, return type is <4 x i32> rgba
-static Value * pointSample(IRBuilder<> & builder, Value * textureData, Value * index, const GGLPixelFormat format)
+// format is GGLPixelFormat for surface, return type is <4 x i32> rgba, or the i32
+// RGBA_8888 texel for GGL_CHANNEL_PACKED8
+static Value * pointSample(IRBuilder<> & builder, Value * textureData, Value * index,
+                           const GGLPixelFormat format, const GGLChannelType dstType)
 {
    Value * texel = NULL;
    switch (format) {
@@ -103,6 +106,9 @@ static Value * pointSample(IRBuilder<> & builder, Value * textureData, Value * i
       assert(0);
       break;
    }
+   if (GGL_CHANNEL_PACKED8 == dstType)
+      return texel;
+
    Value * channels = Constant::getNullValue(intVecType(builder));
 
 //   if (dstDesc && dstDesc->IsInt32Color()) {
@@ -157,25 +163,25 @@ static Value * linearSample(IRBuilder<> & builder, Value * textureData, Value *
    Value * index = builder.CreateMul(y0, width);
    index = builder.CreateAdd(index, x0);
    index = builder.CreateAdd(index, indexOffset);
-   Value * s0 = pointSample(builder, textureData, index, format/*, &regDesc*/);
+   Value * s0 = pointSample(builder, textureData, index, format, GGL_CHANNEL_FIXED8);
 //   s0 = builder.CreateBitCast(s0, intVecType(builder));
 
    index = builder.CreateMul(y0, width);
    index = builder.CreateAdd(index, x1);
    index = builder.CreateAdd(index, indexOffset);
-   Value * s1 = pointSample(builder, textureData, index, format/*, &regDesc*/);
+   Value * s1 = pointSample(builder, textureData, index, format, GGL_CHANNEL_FIXED8);
 //   s1 = builder.CreateBitCast(s1, intVecType(builder));
 
    index = builder.CreateMul(y1, width);
    index = builder.CreateAdd(index, x1);
    index = builder.CreateAdd(index, indexOffset);
-   Value * s2 = pointSample(builder, textureData, index, format/*, &regDesc*/);
+   Value * s2 = pointSample(builder, textureData, index, format, GGL_CHANNEL_FIXED8);
 //   s2 = builder.CreateBitCast(s2, intVecType(builder));
 
    index = builder.CreateMul(y1, width);
    index = builder.CreateAdd(index, x0);
    index = builder.CreateAdd(index, indexOffset);
-   Value * s3 = pointSample(builder, textureData, index, format/*, &regDesc*/);
+   Value * s3 = pointSample(builder, textureData, index, format, GGL_CHANNEL_FIXED8);
 //   s3 = builder.CreateBitCast(s3, intVecType(builder));
 
    Value * xLerpVec = intVec(builder, xLerp, xLerp, xLerp, xLerp);
@@ -273,7 +279,7 @@ static Value * texcoordWrap(IRBuilder<> & builder, const unsigned wrap,
 
 Value * tex2D(IRBuilder<> & builder, Value * in1, const unsigned sampler,
               /*const RegDesc * in1Desc, const RegDesc * dstDesc,*/
-              const GGLState * gglCtx)
+              const GGLState * gglCtx, const GGLChannelType dstType)
 {
    Type * intType = builder.getInt32Ty();
    PointerType * intPointerType = PointerType::get(intType, 0);
@@ -321,13 +327,18 @@ Value * tex2D(IRBuilder<> & builder, Value * in1, const unsigned sampler,
    if (0 == gglCtx->textureState.textures[sampler].minFilter &&
          0 == gglCtx->textureState.textures[sampler].magFilter) { // GL_NEAREST
       Value * ret = pointSample(builder, textureData, index,
-                                gglCtx->textureState.textures[sampler].format/*, dstDesc*/);
+                                gglCtx->textureState.textures[sampler].format, dstType);
+      if (GGL_CHANNEL_FLOAT != dstType)
+         return ret;
       return intColorVecToFloatColorVec(builder, ret);
    } else if (1 == gglCtx->textureState.textures[sampler].minFilter &&
               1 == gglCtx->textureState.textures[sampler].magFilter) { // GL_LINEAR
+      assert(GGL_CHANNEL_PACKED8 != dstType);
       Value * ret = linearSample(builder, textureData, builder.getInt32(0), x, y, xLerp, yLerp,
                                  textureW, textureH,  textureWidth, textureHeight,
                                  gglCtx->textureState.textures[sampler].format/*, dstDesc*/);
+      if (GGL_CHANNEL_FIXED8 == dstType)
+         return ret;
       return intColorVecToFloatColorVec(builder, ret);
    } else
       assert(!"unsupported texture filter");
@@ -363,8 +374,9 @@ static Value * Fabs(IRBuilder<> & builder, Value * val)
 
 Value * texCube(IRBuilder<> & builder, Value * in1, const unsigned sampler,
                 /*const RegDesc * in1Desc, const RegDesc * dstDesc,*/
-                const GGLState * gglCtx)
+                const GGLState * gglCtx, const GGLChannelType dstType)
 {
+   assert(GGL_CHANNEL_PACKED8 != dstType);
 //   if (in1Desc) // the major axis determination code is only float for now
 //      assert(in1Desc->IsVectorType(Float));
 
@@ -516,7 +528,9 @@ Value * texCube(IRBuilder<> & builder, Value * in1, const unsigned sampler,
    if (0 == gglCtx->textureState.textures[sampler].minFilter &&
          0 == gglCtx->textureState.textures[sampler].magFilter) { // GL_NEAREST
       textureData = pointSample(builder, textureData, builder.CreateAdd(indexOffset, index),
-                                gglCtx->textureState.textures[sampler].format/*, dstDesc*/);
+                                gglCtx->textureState.textures[sampler].format, GGL_CHANNEL_FIXED8);
+      if (GGL_CHANNEL_FIXED8 == dstType)
+         return textureData;
       return intColorVecToFloatColorVec(builder, textureData);
 
    } else if (1 == gglCtx->textureState.textures[sampler].minFilter &&
@@ -524,6 +538,8 @@ Value * texCube(IRBuilder<> & builder, Value * in1, const unsigned sampler,
       textureData = linearSample(builder, textureData, indexOffset, x, y, xLerp, yLerp,
                                  textureW, textureH,  textureWidth, textureHeight,
                                  gglCtx->textureState.textures[sampler].format/*, dstDesc*/);
+      if (GGL_CHANNEL_FIXED8 == dstType)
+         return textureData;
       return intColorVecToFloatColorVec(builder, textureData);
    } else
       assert(!"unsupported texture filter");
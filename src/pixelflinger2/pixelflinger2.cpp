@@ -45,6 +45,33 @@ static void Viewport(GGLInterface * iface, GLint x, GLint y, GLsizei width, GLsi
    ctx->viewport.h = VectorComp_t_CTR(height / 2);
 }
 
+static void Scissor(GGLInterface * iface, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+   GGL_GET_CONTEXT(ctx, iface);
+   if (width < 0 || height < 0)
+      return gglError(GL_INVALID_VALUE);
+   ctx->scissor.x = x;
+   ctx->scissor.y = y;
+   ctx->scissor.width = width;
+   ctx->scissor.height = height;
+}
+
+void ScissorRect(const GGLContext * ctx, const unsigned width, const unsigned height,
+                 GGLRect * rect)
+{
+   rect->left = 0;
+   rect->top = 0;
+   rect->right = (int)width - 1;
+   rect->bottom = (int)height - 1;
+   if (!ctx->scissor.enable)
+      return;
+   // 64 bit so that huge boxes do not overflow
+   rect->left = MAX2(rect->left, ctx->scissor.x);
+   rect->top = MAX2(rect->top, ctx->scissor.y);
+   rect->right = MIN2((long long)rect->right, (long long)ctx->scissor.x + ctx->scissor.width - 1);
+   rect->bottom = MIN2((long long)rect->bottom, (long long)ctx->scissor.y + ctx->scissor.height - 1);
+}
+
 static void CullFace(GGLInterface * iface, GLenum mode)
 {
    GGL_GET_CONTEXT(ctx, iface);
@@ -167,12 +194,22 @@ static void EnableDisable(GGLInterface * iface, GLenum cap, GLboolean enable)
    case GL_DITHER:
 //      ALOGD("pf2: EnableDisable GL_DITHER \n");
       break;
-   case GL_SCISSOR_TEST:
-//      ALOGD("pf2: EnableDisable GL_SCISSOR_TEST \n");
+   case GL_SCISSOR_TEST: // not part of GGLState, applied by raster and Clear
+      ctx->scissor.enable = enable;
       break;
    case GL_TEXTURE_2D:
 //      ALOGD("pf2: EnableDisable GL_SCISSOR_TEST %d", enable);
       break;
+   case GGL_REDUCED_PRECISION:
+      changed |= ctx->state.reducedPrecision ^ enable;
+      ctx->state.reducedPrecision = enable;
+      break;
+   case GGL_DEFERRED_RENDERING:
+      changed |= SetDeferredRendering(iface, enable); // picks DeferTriangle for RasterTriangle
+      break;
+   case GGL_VERTEX_CACHE:
+      SetVertexCache(iface, enable);
+      break;
    default:
       ALOGD("pf2: EnableDisable 0x%.4X causes GL_INVALID_ENUM (maybe not implemented or ES 1.0) \n", cap);
 //      gglError(GL_INVALID_ENUM);
@@ -190,6 +227,7 @@ void InitializeGGLState(GGLInterface * iface)
 #endif
    iface->DepthRangef = DepthRangef;
    iface->Viewport = Viewport;
+   iface->Scissor = Scissor;
    iface->CullFace = CullFace;
    iface->FrontFace = FrontFace;
    iface->BlendColor = BlendColor;
@@ -197,8 +235,10 @@ void InitializeGGLState(GGLInterface * iface)
    iface->BlendFuncSeparate = BlendFuncSeparate;
    iface->EnableDisable = EnableDisable;
 
+   InitializeDeferredFunctions(iface);
    InitializeBufferFunctions(iface);
    InitializeRasterFunctions(iface);
+   InitializeRectFunctions(iface);
    InitializeScanLineFunctions(iface);
    InitializeShaderFunctions(iface);
    InitializeTextureFunctions(iface);
@@ -248,6 +288,8 @@ GGLInterface * CreateGGLInterface()
 
 void UninitializeGGLState(GGLInterface * iface)
 {
+   SetDeferredRendering(iface, false);
+   SetVertexCache(iface, false);
 #if USE_DUAL_THREAD
    reinterpret_cast<GGLContext *>(iface)->worker.~Worker();
 #endif
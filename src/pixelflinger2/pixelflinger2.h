@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
+#include <stddef.h>
 
 #ifdef __arm__
 #include <cutils/log.h>
@@ -81,6 +82,10 @@ typedef void (*ShaderFunction_t)(const void*,void*,const void*);
 #define GGL_GET_CONST_CONTEXT(context, interface) const GGLContext * context = \
     (const GGLContext *)interface; (void)context;
 
+struct GGLRect { // inclusive pixel bounds, empty if right < left or bottom < top
+   int left, top, right, bottom;
+};
+
 struct GGLContext {
    GGLInterface interface; // must be first member so that GGLContext * == GGLInterface *
 
@@ -90,7 +95,7 @@ struct GGLContext {
 
    bcc::BCCContext * bccCtx;
 
-   struct {
+   struct ClearState {
       int depth; // assuming ieee 754 32 bit float and 32 bit 2's complement int; z_32
       unsigned color; // clear value; rgba_8888
       unsigned stencil; // s_8; repeated to clear 4 pixels at a time
@@ -102,12 +107,16 @@ struct GGLContext {
 
    GGLState state; // states affecting jit
 
+   struct GGLDeferred * deferred; // non NULL while GGL_DEFERRED_RENDERING is enabled
+
+   struct GGLVertexCache * vertexCache; // non NULL while GGL_VERTEX_CACHE is enabled
+
 #if USE_DUAL_THREAD
    mutable struct Worker {
       const GGLInterface * iface;
-      unsigned startY, endY, varyingCount;
+      unsigned startY, endY, varyingCount, interpolated;
       VertexOutput bV, cV, bDx, cDx;
-      int width, height;
+      int left, right; // span clip
       bool assignedWork; // only used by main; worker uses assignCond & quit
       bool quit;
 
@@ -164,19 +173,113 @@ unsigned frontFace :
 unsigned cullFace :
       2; // GL_FRONT = 0, GL_BACK, GL_FRONT_AND_BACK, value = GLenum - GL_FRONT
    } cullState;
+
+   struct {
+      GLint x, y;
+      GLsizei width, height;
+      bool enable; // GL_SCISSOR_TEST
+   } scissor;
 };
 
+// Vector4s of VertexOutput that raster and scanline use, through the last varying;
+// vertices they copy or record only carry this part
+static inline unsigned VertexOutputVectors(const unsigned varyingCount)
+{
+   return offsetof(VertexOutput, varyings) / sizeof(Vector4) + varyingCount;
+}
+
+static inline void CopyVertexOutput(VertexOutput * dst, const VertexOutput * src,
+                                    const unsigned varyingCount)
+{
+   memcpy(dst, src, VertexOutputVectors(varyingCount) * sizeof(Vector4));
+}
+
+// [0, width) x [0, height) intersected with scissor box if enabled
+void ScissorRect(const GGLContext * ctx, const unsigned width, const unsigned height,
+                 GGLRect * rect);
+
 #define _PF2_TEXTURE_DATA_NAME_ "gl_PF2TEXTURE_DATA" /* sampler data pointers used by LLVM */
 #define _PF2_TEXTURE_DIMENSIONS_NAME_ "gl_PF2TEXTURE_DIMENSIONS" /* sampler dimensions used by LLVM */
 
 void gglError(unsigned error); // not implmented, just an assert
 
+// what GGLScanLine reads from program and context, resolved when a deferred
+// triangle is recorded so replay does not see later state changes
+struct GGLScanLineTarget {
+   void (* function)(); // JIT scanline for the GGLState at record time
+   unsigned varyingCount;
+   unsigned varyingFlat; // gl_shader_program::VaryingFlat
+   const float (* constants)[4]; // copy of ValuesUniform at record time
+   GGLPixelFormat colorFormat, depthFormat;
+   void * frameBuffer;
+   void * depthBuffer; // Z_32, Z_16 or SZ_24, which also holds stencil
+   unsigned char * stencilBuffer; // S_8
+   unsigned width, height; // of frame surface, also used for depth and stencil
+   GGLRect clip; // frame surface bounds intersected with scissor box
+};
+
+// GGLScanLine with function and values from target, writing line y
+void ScanLineSpan(const GGLScanLineTarget * target, GGLActiveStencil * activeStencil,
+                  const unsigned y, const VertexOutput * start, const VertexOutput * end);
+// RasterTriangle clipped to tile and target->clip, scan lines go to ScanLineSpan
+void RasterTriangleTile(const GGLScanLineTarget * target, GGLActiveStencil * activeStencil,
+                        const VertexOutput * v1, const VertexOutput * v2,
+                        const VertexOutput * v3, const GGLRect * tile);
+// Clear limited to rect, which must not start left or above 0
+void ClearRect(const GGLSurface * frameSurface, const GGLSurface * depthSurface,
+               const GGLSurface * stencilSurface, const GGLContext::ClearState * clearState,
+               GLbitfield buf, const GGLRect * rect);
+
+// DrawRect state, resolved at call so deferred replay does not see later state changes
+struct GGLRectBlit {
+   GGLTexture texture; // shallow copy of sampler
+   GGLPixelFormat colorFormat;
+   void * frameBuffer;
+   unsigned frameWidth;
+   int x, y; // window rect origin, texel u, v lands there
+   int u, v;
+   unsigned width, height, cropWidth, cropHeight; // not 0
+   unsigned blend; // GGL_RECT_COPY or GGL_RECT_BLEND with GGL_RECT_*_SRC_ALPHA flags
+   GGLRect clip; // window rect intersected with frame surface and scissor
+};
+
+// source over is src * (1 or src alpha) + dst * (1 - src alpha), per color and alpha
+enum GGLRectBlend {
+   GGL_RECT_COPY = 0,
+   GGL_RECT_BLEND = 1,
+   GGL_RECT_COLOR_SRC_ALPHA = 2, // GL_SRC_ALPHA source color factor, otherwise GL_ONE
+   GGL_RECT_ALPHA_SRC_ALPHA = 4, // GL_SRC_ALPHA source alpha factor, otherwise GL_ONE
+};
+
+// DrawRect on part of blit->clip; rect must lie in frame surface
+void BlitRect(const GGLRectBlit * blit, const GGLRect * rect);
+
+// deferred rendering command buffer, see deferred.cpp
+bool SetDeferredRendering(GGLInterface * iface, bool enable); // returns true if changed
+void DeferTriangle(const GGLInterface * iface, const VertexOutput * v1,
+                   const VertexOutput * v2, const VertexOutput * v3);
+void DeferClear(const GGLInterface * iface, GLbitfield buf);
+void DeferRect(const GGLInterface * iface, const GGLRectBlit * blit);
+
+// perspective divide, viewport transform, facing and RasterTriangle of vertex shader
+// outputs, which are modified
+void SetupTriangle(const GGLInterface * iface, VertexOutput * v1, VertexOutput * v2,
+                   VertexOutput * v3);
+
+// vertex shader output cache, see vertex_cache.cpp
+void SetVertexCache(GGLInterface * iface, bool enable);
+void VertexCacheRemoveProgram(GGLInterface * iface, const gl_shader_program * program);
+void DrawTriangles(const GGLInterface * iface, const VertexInput * vertices,
+                   unsigned count, unsigned cacheKey);
+
 void InitializeGGLState(GGLInterface * iface); // should be private
 void UninitializeGGLState(GGLInterface * iface); // should be private
 
 // they just set the function pointers
 void InitializeBufferFunctions(GGLInterface * iface);
+void InitializeDeferredFunctions(GGLInterface * iface);
 void InitializeRasterFunctions(GGLInterface * iface);
+void InitializeRectFunctions(GGLInterface * iface);
 void InitializeScanLineFunctions(GGLInterface * iface);
 void InitializeTextureFunctions(GGLInterface * iface);
 
@@ -0,0 +1,824 @@
+/**
+ **
+ ** Copyright 2011, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+// Headless benchmark: renders canned scenes through GGLInterface into in memory
+// surfaces and reports triangle and pixel throughput plus shader JIT counters.
+// Final frames can be written as PPM and compared against golden PPMs.
+//
+// usage: pixelflinger2_bench [-W width] [-H height] [-n frames] [-s scene]
+//                            [-o output dir] [-g golden dir] [-t tolerance] [-d] [-c]
+// -d enables GGL_DEFERRED_RENDERING; frame times then include Finish
+// -c runs the rendering checks instead of timing; they need no golden images,
+// each compares two paths that must give identical pixels or known values
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "include/pixelflinger2/pixelflinger2_interface.h"
+
+enum { POSITION = 0, TEXCOORD = 1, COLOR = 2 }; // attribute locations
+
+static const char vertexShader[] =
+   "attribute vec4 aPosition; \n"
+   "attribute vec4 aTexCoord; \n"
+   "attribute vec4 aColor; \n"
+   "varying vec4 vTexCoord; \n"
+   "varying vec4 vColor; \n"
+   "void main() { \n"
+   "   gl_Position = aPosition; \n"
+   "   vTexCoord = aTexCoord; \n"
+   "   vColor = aColor; \n"
+   "} \n";
+
+static const char textureShader[] =
+   "precision mediump float; \n"
+   "uniform sampler2D uTexture; \n"
+   "varying vec4 vTexCoord; \n"
+   "void main() { \n"
+   "   gl_FragColor = texture2D(uTexture, vTexCoord.xy); \n"
+   "} \n";
+
+static const char modulateShader[] =
+   "precision mediump float; \n"
+   "uniform sampler2D uTexture; \n"
+   "uniform vec4 uColor; \n"
+   "varying vec4 vTexCoord; \n"
+   "void main() { \n"
+   "   gl_FragColor = uColor * texture2D(uTexture, vTexCoord.xy); \n"
+   "} \n";
+
+static const char colorShader[] =
+   "precision mediump float; \n"
+   "varying vec4 vColor; \n"
+   "void main() { \n"
+   "   gl_FragColor = vColor; \n"
+   "} \n";
+
+struct Bench {
+   GGLInterface_t * iface;
+   unsigned width, height;
+   GGLSurface_t frameSurface, depthSurface, stencilSurface;
+   GGLTexture_t texture;
+   gl_shader_program_t * textureProgram, * modulateProgram, * colorProgram;
+   GLint modulateColor;
+   unsigned tolerance; // per channel difference allowed against golden or reference frames
+
+   // accumulated by Draw; pixels is rasterized area, including overdraw
+   double triangles, pixels;
+};
+
+struct Scene {
+   const char * name;
+   void (* draw)(Bench * bench);
+};
+
+static double Now()
+{
+   timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static gl_shader_program_t * CreateProgram(const GGLInterface_t * iface, const char * fragmentShader)
+{
+   const char * infoLog = NULL;
+   gl_shader_t * vs = iface->ShaderCreate(iface, GL_VERTEX_SHADER);
+   gl_shader_t * fs = iface->ShaderCreate(iface, GL_FRAGMENT_SHADER);
+   if (!iface->ShaderCompile(iface, vs, vertexShader, &infoLog) ||
+         !iface->ShaderCompile(iface, fs, fragmentShader, &infoLog)) {
+      fprintf(stderr, "shader compile failed:\n%s\n", infoLog);
+      exit(1);
+   }
+   gl_shader_program_t * program = iface->ShaderProgramCreate(iface);
+   iface->ShaderAttach(iface, program, vs);
+   iface->ShaderAttach(iface, program, fs);
+   iface->ShaderAttributeBind(program, POSITION, "aPosition");
+   iface->ShaderAttributeBind(program, TEXCOORD, "aTexCoord");
+   iface->ShaderAttributeBind(program, COLOR, "aColor");
+   if (!iface->ShaderProgramLink(iface, program, &infoLog)) {
+      fprintf(stderr, "program link failed:\n%s\n", infoLog);
+      exit(1);
+   }
+   iface->ShaderDelete(iface, vs);
+   iface->ShaderDelete(iface, fs);
+
+   const GLint sampler = iface->ShaderUniformLocation(program, "uTexture");
+   if (0 <= sampler) {
+      const GLint unit = 0;
+      iface->ShaderUniform(program, sampler, 1, &unit, GL_INT);
+   }
+   return program;
+}
+
+static void SetVertex(VertexInput_t * v, float x, float y, float z, float s, float t,
+                      float r, float g, float b, float a)
+{
+   memset(v, 0, sizeof(*v));
+   v->attributes[POSITION] = Vector4(x, y, z, 1);
+   v->attributes[TEXCOORD] = Vector4(s, t, 0, 1);
+   v->attributes[COLOR] = Vector4(r, g, b, a);
+}
+
+static void Draw(Bench * bench, const VertexInput_t * v0, const VertexInput_t * v1,
+                 const VertexInput_t * v2)
+{
+   bench->iface->DrawTriangle(bench->iface, v0, v1, v2);
+   const Vector4 & p0 = v0->attributes[POSITION];
+   const Vector4 & p1 = v1->attributes[POSITION];
+   const Vector4 & p2 = v2->attributes[POSITION];
+   const float area = fabsf((p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y));
+   bench->triangles += 1;
+   bench->pixels += area * 0.125f * bench->width * bench->height; // ndc is 2x2
+}
+
+// axis aligned quad in ndc with texture coordinates [0,1]
+static void DrawQuad(Bench * bench, float x0, float y0, float x1, float y1, float z,
+                     float r, float g, float b, float a)
+{
+   VertexInput_t v[4];
+   SetVertex(v + 0, x0, y0, z, 0, 0, r, g, b, a);
+   SetVertex(v + 1, x1, y0, z, 1, 0, r, g, b, a);
+   SetVertex(v + 2, x0, y1, z, 0, 1, r, g, b, a);
+   SetVertex(v + 3, x1, y1, z, 1, 1, r, g, b, a);
+   Draw(bench, v + 0, v + 1, v + 2);
+   Draw(bench, v + 2, v + 1, v + 3);
+}
+
+static void ResetState(Bench * bench)
+{
+   GGLInterface_t * iface = bench->iface;
+   iface->EnableDisable(iface, GL_BLEND, false);
+   iface->EnableDisable(iface, GL_DEPTH_TEST, false);
+   iface->EnableDisable(iface, GL_STENCIL_TEST, false);
+   iface->ClearColor(iface, 0.1f, 0.2f, 0.3f, 1);
+   iface->ClearDepthf(iface, 1);
+   iface->ClearStencil(iface, 0);
+   iface->Clear(iface, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+static void TexturedQuad(Bench * bench)
+{
+   ResetState(bench);
+   bench->iface->ShaderUse(bench->iface, bench->textureProgram);
+   DrawQuad(bench, -1, -1, 1, 1, 0, 1, 1, 1, 1);
+}
+
+static void BlendedLayers(Bench * bench)
+{
+   GGLInterface_t * iface = bench->iface;
+   ResetState(bench);
+   iface->ShaderUse(iface, bench->modulateProgram);
+   iface->EnableDisable(iface, GL_BLEND, true);
+   iface->BlendFuncSeparate(iface, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+   for (unsigned i = 0; i < 8; i++) {
+      const float color[4] = {1 - i / 8.0f, 0.5f, i / 8.0f, 0.6f};
+      iface->ShaderUniform(bench->modulateProgram, bench->modulateColor, 1, color, GL_FLOAT_VEC4);
+      const float inset = i * 0.1f;
+      DrawQuad(bench, -1 + inset, -1 + inset * 0.5f, 1 - inset * 0.5f, 1 - inset, 0,
+               1, 1, 1, 1);
+   }
+}
+
+// blended_layers as a compositor would draw them, with DrawRect and 1:1 repeated texels
+static void RectLayers(Bench * bench)
+{
+   GGLInterface_t * iface = bench->iface;
+   ResetState(bench);
+   iface->ShaderUse(iface, bench->textureProgram); // only for the fallback
+   iface->EnableDisable(iface, GL_BLEND, true);
+   iface->BlendFuncSeparate(iface, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+   for (unsigned i = 0; i < 8; i++) {
+      const float inset = i * 0.1f;
+      const int x = inset * 0.5f * bench->width, y = inset * 0.5f * bench->height;
+      const int width = bench->width - x - inset * 0.25f * bench->width;
+      const int height = bench->height - y - inset * 0.25f * bench->height;
+      if (iface->DrawRect(iface, 0, x, y, width, height, i * 16, 0, width, height))
+         bench->pixels += width * height;
+      else // general path, texture coordinates only approximate the rect
+         DrawQuad(bench, x * 2.0f / bench->width - 1, 1 - (y + height) * 2.0f / bench->height,
+                  (x + width) * 2.0f / bench->width - 1, 1 - y * 2.0f / bench->height, 0,
+                  1, 1, 1, 1);
+   }
+}
+
+// two interpenetrating height field grids, so about half the fragments fail depth test
+static void DepthMesh(Bench * bench)
+{
+   GGLInterface_t * iface = bench->iface;
+   ResetState(bench);
+   iface->ShaderUse(iface, bench->colorProgram);
+   iface->EnableDisable(iface, GL_DEPTH_TEST, true);
+   iface->DepthFunc(iface, GL_LESS);
+   const unsigned cells = 32;
+   for (unsigned mesh = 0; mesh < 2; mesh++)
+      for (unsigned j = 0; j < cells; j++)
+         for (unsigned i = 0; i < cells; i++) {
+            VertexInput_t v[4];
+            for (unsigned k = 0; k < 4; k++) {
+               const float x = (i + (k & 1)) * 2.0f / cells - 1;
+               const float y = (j + (k >> 1)) * 2.0f / cells - 1;
+               const float z = mesh ? 0.5f * cosf(x * 5) * sinf(y * 3) :
+                               0.5f * sinf(x * 4 + y * 2);
+               SetVertex(v + k, x, y, z, 0, 0, mesh, 0.5f + z, 1 - mesh, 1);
+            }
+            Draw(bench, v + 0, v + 1, v + 2);
+            Draw(bench, v + 2, v + 1, v + 3);
+         }
+}
+
+// writes a diamond into stencil without touching color, then textures through it
+static void StencilMask(Bench * bench)
+{
+   GGLInterface_t * iface = bench->iface;
+   ResetState(bench);
+   iface->EnableDisable(iface, GL_STENCIL_TEST, true);
+
+   iface->ShaderUse(iface, bench->colorProgram);
+   iface->EnableDisable(iface, GL_BLEND, true);
+   iface->BlendFuncSeparate(iface, GL_ZERO, GL_ONE, GL_ZERO, GL_ONE);
+   iface->StencilFuncSeparate(iface, GL_FRONT_AND_BACK, GL_ALWAYS, 1, 0xff);
+   iface->StencilOpSeparate(iface, GL_FRONT_AND_BACK, GL_KEEP, GL_KEEP, GL_REPLACE);
+   VertexInput_t v[5];
+   SetVertex(v + 0, 0, 0, 0, 0, 0, 1, 1, 1, 1);
+   SetVertex(v + 1, 0.8f, 0, 0, 0, 0, 1, 1, 1, 1);
+   SetVertex(v + 2, 0, 0.8f, 0, 0, 0, 1, 1, 1, 1);
+   SetVertex(v + 3, -0.8f, 0, 0, 0, 0, 1, 1, 1, 1);
+   SetVertex(v + 4, 0, -0.8f, 0, 0, 0, 1, 1, 1, 1);
+   for (unsigned i = 0; i < 4; i++)
+      Draw(bench, v + 0, v + 1 + i, v + 1 + (i + 1) % 4);
+
+   iface->EnableDisable(iface, GL_BLEND, false);
+   iface->ShaderUse(iface, bench->textureProgram);
+   iface->StencilFuncSeparate(iface, GL_FRONT_AND_BACK, GL_EQUAL, 1, 0xff);
+   iface->StencilOpSeparate(iface, GL_FRONT_AND_BACK, GL_KEEP, GL_KEEP, GL_KEEP);
+   DrawQuad(bench, -1, -1, 1, 1, 0, 1, 1, 1, 1);
+}
+
+// 4x4 pixel cells split into 2 triangles, covering the whole surface
+static void TinyTriangles(Bench * bench)
+{
+   ResetState(bench);
+   bench->iface->ShaderUse(bench->iface, bench->colorProgram);
+   const unsigned cell = 4;
+   const float dx = 2.0f * cell / bench->width, dy = 2.0f * cell / bench->height;
+   for (unsigned j = 0; j < bench->height / cell; j++)
+      for (unsigned i = 0; i < bench->width / cell; i++) {
+         const float x = i * dx - 1, y = j * dy - 1;
+         VertexInput_t v[4];
+         SetVertex(v + 0, x, y, 0, 0, 0, (i & 7) / 7.0f, (j & 7) / 7.0f, 0.5f, 1);
+         SetVertex(v + 1, x + dx, y, 0, 0, 0, 1, 0, 0, 1);
+         SetVertex(v + 2, x, y + dy, 0, 0, 0, 0, 1, 0, 1);
+         SetVertex(v + 3, x + dx, y + dy, 0, 0, 0, 0, 0, 1, 1);
+         Draw(bench, v + 0, v + 1, v + 2);
+         Draw(bench, v + 2, v + 1, v + 3);
+      }
+}
+
+static const Scene scenes[] = {
+   {"textured_quad", TexturedQuad},
+   {"blended_layers", BlendedLayers},
+   {"rect_layers", RectLayers},
+   {"depth_mesh", DepthMesh},
+   {"stencil_mask", StencilMask},
+   {"tiny_triangles", TinyTriangles},
+};
+
+static bool WritePPM(const Bench * bench, const char * fileName)
+{
+   FILE * file = fopen(fileName, "wb");
+   if (!file)
+      return false;
+   fprintf(file, "P6\n%u %u\n255\n", bench->width, bench->height);
+   const unsigned char * pixels = (const unsigned char *)bench->frameSurface.data;
+   for (unsigned i = 0; i < bench->width * bench->height; i++)
+      fwrite(pixels + i * 4, 3, 1, file); // RGBA_8888 is r, g, b, a in memory
+   return 0 == fclose(file);
+}
+
+// returns number of pixels differing by more than tolerance, or -1 if golden is unusable
+static int ComparePPM(const Bench * bench, const char * fileName, unsigned tolerance,
+                      unsigned * maxDiff)
+{
+   FILE * file = fopen(fileName, "rb");
+   if (!file)
+      return -1;
+   unsigned width = 0, height = 0, maxValue = 0;
+   if (3 != fscanf(file, "P6 %u %u %u", &width, &height, &maxValue) ||
+         width != bench->width || height != bench->height || 255 != maxValue) {
+      fclose(file);
+      return -1;
+   }
+   fgetc(file); // single whitespace after header
+   std::vector<unsigned char> golden(width * height * 3);
+   const bool read = golden.size() == fread(&golden[0], 1, golden.size(), file);
+   fclose(file);
+   if (!read)
+      return -1;
+
+   int mismatches = 0;
+   *maxDiff = 0;
+   const unsigned char * pixels = (const unsigned char *)bench->frameSurface.data;
+   for (unsigned i = 0; i < width * height; i++) {
+      unsigned diff = 0;
+      for (unsigned c = 0; c < 3; c++)
+         diff = std::max(diff, (unsigned)abs(pixels[i * 4 + c] - golden[i * 3 + c]));
+      *maxDiff = std::max(*maxDiff, diff);
+      mismatches += diff > tolerance;
+   }
+   return mismatches;
+}
+
+static void CreateSurfaces(Bench * bench)
+{
+   const unsigned count = bench->width * bench->height;
+   GGLSurface_t * const surfaces[3] = {&bench->frameSurface, &bench->depthSurface, &bench->stencilSurface};
+   const GGLPixelFormat formats[3] = {GGL_PIXEL_FORMAT_RGBA_8888, GGL_PIXEL_FORMAT_Z_32, GGL_PIXEL_FORMAT_S_8};
+   const unsigned sizes[3] = {4, 4, 1};
+   const GLenum types[3] = {GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT, GL_STENCIL_BUFFER_BIT};
+   for (unsigned i = 0; i < 3; i++) {
+      GGLSurface_t * surface = surfaces[i];
+      memset(surface, 0, sizeof(*surface));
+      surface->width = bench->width;
+      surface->height = bench->height;
+      surface->stride = bench->width;
+      surface->format = formats[i];
+      surface->data = calloc(count, sizes[i]);
+      bench->iface->SetBuffer(bench->iface, types[i], surface);
+   }
+
+   // 256x256 checker board with alpha gradient
+   const unsigned size = 256;
+   unsigned char * texels = (unsigned char *)malloc(size * size * 4);
+   for (unsigned y = 0; y < size; y++)
+      for (unsigned x = 0; x < size; x++) {
+         unsigned char * texel = texels + (y * size + x) * 4;
+         const bool odd = ((x >> 5) ^ (y >> 5)) & 1;
+         texel[0] = odd ? 255 : x;
+         texel[1] = odd ? 255 : y;
+         texel[2] = odd ? 64 : 192;
+         texel[3] = x;
+      }
+   memset(&bench->texture, 0, sizeof(bench->texture));
+   bench->texture.type = GL_TEXTURE_2D;
+   bench->texture.format = GGL_PIXEL_FORMAT_RGBA_8888;
+   bench->texture.width = size;
+   bench->texture.height = size;
+   bench->texture.levelCount = 1;
+   bench->texture.levels = texels;
+   bench->texture.wrapS = bench->texture.wrapT = GGLTexture::GGL_REPEAT;
+   bench->texture.minFilter = bench->texture.magFilter = GGLTexture::GGL_LINEAR;
+   bench->iface->SetSampler(bench->iface, 0, &bench->texture);
+}
+
+// copy of the bench surfaces, to compare two renders of the same frame
+struct Frame {
+   std::vector<unsigned> color, depth;
+   std::vector<unsigned char> stencil;
+};
+
+static void ReadFrame(const Bench * bench, Frame * frame)
+{
+   const unsigned count = bench->width * bench->height;
+   const unsigned * color = (const unsigned *)bench->frameSurface.data;
+   const unsigned * depth = (const unsigned *)bench->depthSurface.data;
+   const unsigned char * stencil = (const unsigned char *)bench->stencilSurface.data;
+   frame->color.assign(color, color + count);
+   frame->depth.assign(depth, depth + count);
+   frame->stencil.assign(stencil, stencil + count);
+}
+
+// returns number of differing color, depth and stencil values
+static unsigned CompareFrames(const Frame & a, const Frame & b)
+{
+   unsigned mismatches = 0;
+   for (unsigned i = 0; i < a.color.size(); i++)
+      mismatches += (a.color[i] != b.color[i]) + (a.depth[i] != b.depth[i]) +
+                    (a.stencil[i] != b.stencil[i]);
+   return mismatches;
+}
+
+// returns number of pixels whose color differs by more than tolerance or whose stencil differs
+static unsigned ComparePixels(const Frame & a, const Frame & b, const unsigned tolerance,
+                              const unsigned first, const unsigned count, unsigned * maxDiff)
+{
+   unsigned mismatches = 0;
+   for (unsigned i = first; i < first + count; i++) {
+      const unsigned char * colorA = (const unsigned char *)&a.color[i];
+      const unsigned char * colorB = (const unsigned char *)&b.color[i];
+      unsigned diff = 0;
+      for (unsigned c = 0; c < 4; c++)
+         diff = std::max(diff, (unsigned)abs(colorA[c] - colorB[c]));
+      *maxDiff = std::max(*maxDiff, diff);
+      mismatches += diff > tolerance || a.stencil[i] != b.stencil[i];
+   }
+   return mismatches;
+}
+
+static void DrawScene(Bench * bench, const Scene & scene, const bool deferred, Frame * frame)
+{
+   GGLInterface_t * iface = bench->iface;
+   iface->EnableDisable(iface, GGL_DEFERRED_RENDERING, deferred);
+   scene.draw(bench);
+   iface->Finish(iface);
+   iface->EnableDisable(iface, GGL_DEFERRED_RENDERING, false);
+   ReadFrame(bench, frame);
+}
+
+// deferred rendering replays the same commands per tile, but each tile steps varyings
+// and depth from its own edge, so colors may differ within tolerance and a depth test
+// may flip where surfaces meet; allow that for at most 1 in 1000 pixels of each scene
+static bool CheckDeferred(Bench * bench, char * status, const unsigned size)
+{
+   bool ok = true;
+   unsigned maxDiff = 0, worst = 0;
+   for (unsigned i = 0; i < sizeof(scenes) / sizeof(*scenes); i++) {
+      Frame immediate, deferred;
+      DrawScene(bench, scenes[i], false, &immediate);
+      DrawScene(bench, scenes[i], true, &deferred);
+      const unsigned count = immediate.color.size();
+      const unsigned mismatches = ComparePixels(immediate, deferred, bench->tolerance, 0, count,
+                                                &maxDiff);
+      worst = std::max(worst, mismatches);
+      if (mismatches > count / 1000 && ok) {
+         snprintf(status, size, "%s differs in %u pixels", scenes[i].name, mismatches);
+         ok = false;
+      }
+   }
+   if (ok)
+      snprintf(status, size, "ok, max diff %u, at most %u pixels over tolerance", maxDiff, worst);
+   return ok;
+}
+
+// programs restored with ShaderProgramBinary must serialize to the same bytes and
+// render every scene exactly like the linked ones; a truncated binary must be rejected
+static bool CheckBinary(Bench * bench, char * status, const unsigned size)
+{
+   GGLInterface_t * iface = bench->iface;
+   gl_shader_program_t ** const programs[3] = {&bench->textureProgram,
+                                               &bench->modulateProgram, &bench->colorProgram};
+   gl_shader_program_t * linked[3], * restored[3];
+   bool ok = true;
+   for (unsigned i = 0; i < 3; i++) {
+      linked[i] = *programs[i];
+      restored[i] = iface->ShaderProgramCreate(iface);
+      GLsizei length = 0, restoredLength = 0;
+      iface->ShaderProgramGetBinary(linked[i], 0, &length, NULL);
+      std::vector<unsigned char> binary(length), copy(length);
+      if (!length || !iface->ShaderProgramGetBinary(linked[i], length, &length, &binary[0])) {
+         snprintf(status, size, "program %u has no binary", i);
+         ok = false;
+      } else if (iface->ShaderProgramBinary(iface, restored[i], &binary[0], length - 1)) {
+         snprintf(status, size, "program %u accepted a truncated binary", i);
+         ok = false;
+      } else if (!iface->ShaderProgramBinary(iface, restored[i], &binary[0], length)) {
+         snprintf(status, size, "program %u binary rejected", i);
+         ok = false;
+      } else if (!iface->ShaderProgramGetBinary(restored[i], length, &restoredLength, &copy[0]) ||
+                 restoredLength != length || copy != binary) {
+         snprintf(status, size, "program %u binary changed after restore", i);
+         ok = false;
+      }
+   }
+
+   for (unsigned i = 0; ok && i < sizeof(scenes) / sizeof(*scenes); i++) {
+      Frame reference, frame;
+      DrawScene(bench, scenes[i], false, &reference);
+      for (unsigned j = 0; j < 3; j++)
+         *programs[j] = restored[j];
+      bench->modulateColor = iface->ShaderUniformLocation(bench->modulateProgram, "uColor");
+      DrawScene(bench, scenes[i], false, &frame);
+      for (unsigned j = 0; j < 3; j++)
+         *programs[j] = linked[j];
+      bench->modulateColor = iface->ShaderUniformLocation(bench->modulateProgram, "uColor");
+      const unsigned mismatches = CompareFrames(reference, frame);
+      if (mismatches) {
+         snprintf(status, size, "%s differs in %u values", scenes[i].name, mismatches);
+         ok = false;
+      }
+   }
+
+   iface->ShaderUse(iface, NULL);
+   for (unsigned i = 0; i < 3; i++)
+      iface->ShaderProgramDelete(iface, restored[i]);
+   return ok;
+}
+
+// Z_32, Z_16 and SZ_24 clear values, SZ_24 depth or stencil only clears keeping the
+// other bits, and a scissored clear touching only the box; immediate and deferred
+static bool CheckClears(Bench * bench, char * status, const unsigned size)
+{
+   GGLInterface_t * iface = bench->iface;
+   const unsigned width = 16, height = 8;
+   unsigned color[width * height], depth[width * height];
+   GGLSurface_t frameSurface, depthSurface;
+   memset(&frameSurface, 0, sizeof(frameSurface));
+   frameSurface.width = width;
+   frameSurface.height = height;
+   frameSurface.stride = width;
+   frameSurface.format = GGL_PIXEL_FORMAT_RGBA_8888;
+   frameSurface.data = color;
+   depthSurface = frameSurface; // format is set by each case
+   depthSurface.data = depth;
+
+   const float clearDepth = 0.25f;
+   const unsigned depth32 = *(const unsigned *)&clearDepth, depth24 = clearDepth * 0xffffff;
+   const unsigned filled = 0x12345678, stencil = 0x1ab; // ClearStencil keeps the low byte
+   const GLint boxX = 3, boxY = 2, boxWidth = 5, boxHeight = 4;
+   struct {
+      const char * name;
+      GGLPixelFormat format;
+      GLbitfield buf;
+      bool scissor;
+      unsigned inside, outside;
+   } const cases[] = {
+      {"Z_32", GGL_PIXEL_FORMAT_Z_32, GL_DEPTH_BUFFER_BIT, false, depth32, depth32},
+      {"Z_16", GGL_PIXEL_FORMAT_Z_16, GL_DEPTH_BUFFER_BIT, false,
+       (unsigned)(clearDepth * 0xffff), (unsigned)(clearDepth * 0xffff)},
+      {"SZ_24 depth", GGL_PIXEL_FORMAT_SZ_24, GL_DEPTH_BUFFER_BIT, false,
+       0x12000000 | depth24, 0x12000000 | depth24},
+      {"SZ_24 stencil", GGL_PIXEL_FORMAT_SZ_24, GL_STENCIL_BUFFER_BIT, false,
+       0xab345678, 0xab345678},
+      {"SZ_24 both", GGL_PIXEL_FORMAT_SZ_24, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, false,
+       0xab000000 | depth24, 0xab000000 | depth24},
+      {"scissored SZ_24", GGL_PIXEL_FORMAT_SZ_24, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, true,
+       0xab000000 | depth24, filled},
+      {"scissored color", GGL_PIXEL_FORMAT_Z_32, GL_COLOR_BUFFER_BIT, true, 0xff0000ff, filled},
+   };
+
+   bool ok = true;
+   iface->ClearColor(iface, 1, 0, 0, 1);
+   iface->ClearDepthf(iface, clearDepth);
+   iface->ClearStencil(iface, stencil);
+   iface->Scissor(iface, boxX, boxY, boxWidth, boxHeight);
+   for (unsigned deferred = 0; ok && deferred < 2; deferred++)
+      for (unsigned i = 0; ok && i < sizeof(cases) / sizeof(*cases); i++) {
+         depthSurface.format = cases[i].format;
+         iface->SetBuffer(iface, GL_COLOR_BUFFER_BIT, &frameSurface);
+         iface->SetBuffer(iface, GL_DEPTH_BUFFER_BIT, &depthSurface);
+         iface->SetBuffer(iface, GL_STENCIL_BUFFER_BIT, GGL_PIXEL_FORMAT_SZ_24 == cases[i].format ?
+                          &depthSurface : &bench->stencilSurface);
+         for (unsigned j = 0; j < width * height; j++)
+            color[j] = depth[j] = filled;
+
+         iface->EnableDisable(iface, GL_SCISSOR_TEST, cases[i].scissor);
+         iface->EnableDisable(iface, GGL_DEFERRED_RENDERING, deferred);
+         iface->Clear(iface, cases[i].buf);
+         iface->Finish(iface);
+         iface->EnableDisable(iface, GGL_DEFERRED_RENDERING, false);
+         iface->EnableDisable(iface, GL_SCISSOR_TEST, false);
+
+         const unsigned * values = GL_COLOR_BUFFER_BIT == cases[i].buf ? color : depth;
+         for (int y = 0; ok && y < (int)height; y++)
+            for (int x = 0; ok && x < (int)width; x++) {
+               const bool inside = boxX <= x && x < boxX + boxWidth &&
+                                   boxY <= y && y < boxY + boxHeight;
+               unsigned value = values[y * width + x];
+               if (GGL_PIXEL_FORMAT_Z_16 == cases[i].format)
+                  value = ((const unsigned short *)values)[y * width + x];
+               const unsigned expected = inside ? cases[i].inside : cases[i].outside;
+               if (value != expected) {
+                  snprintf(status, size, "%s%s at %d,%d is %.8x instead of %.8x", cases[i].name,
+                           deferred ? " deferred" : "", x, y, value, expected);
+                  ok = false;
+               }
+            }
+      }
+
+   iface->SetBuffer(iface, GL_COLOR_BUFFER_BIT, &bench->frameSurface);
+   iface->SetBuffer(iface, GL_DEPTH_BUFFER_BIT, &bench->depthSurface);
+   iface->SetBuffer(iface, GL_STENCIL_BUFFER_BIT, &bench->stencilSurface);
+   return ok;
+}
+
+// a scissored draw keeps the clear outside the box and inside matches the unscissored
+// draw within tolerance, since trapezoid setup then starts from the box edges
+static bool CheckScissor(Bench * bench, char * status, const unsigned size)
+{
+   GGLInterface_t * iface = bench->iface;
+   const GLint boxX = bench->width / 4, boxY = bench->height / 3;
+   const GLint boxWidth = bench->width / 3, boxHeight = bench->height / 2;
+   Frame reference, cleared, frame;
+   DrawScene(bench, scenes[0], false, &reference);
+   ResetState(bench);
+   ReadFrame(bench, &cleared);
+
+   iface->Scissor(iface, boxX, boxY, boxWidth, boxHeight);
+   iface->EnableDisable(iface, GL_SCISSOR_TEST, true);
+   iface->ShaderUse(iface, bench->textureProgram);
+   DrawQuad(bench, -1, -1, 1, 1, 0, 1, 1, 1, 1);
+   iface->Finish(iface);
+   iface->EnableDisable(iface, GL_SCISSOR_TEST, false);
+   ReadFrame(bench, &frame);
+
+   unsigned mismatches = 0, maxDiff = 0;
+   for (int y = 0; y < (int)bench->height; y++)
+      for (int x = 0; x < (int)bench->width; x++) {
+         const bool inside = boxX <= x && x < boxX + boxWidth && boxY <= y && y < boxY + boxHeight;
+         const unsigned i = y * bench->width + x;
+         if (inside)
+            mismatches += ComparePixels(reference, frame, bench->tolerance, i, 1, &maxDiff);
+         else
+            mismatches += frame.color[i] != cleared.color[i];
+      }
+   if (mismatches)
+      snprintf(status, size, "%u pixels differ", mismatches);
+   else
+      snprintf(status, size, "ok, max diff %u", maxDiff);
+   return !mismatches;
+}
+
+// an unblended 1:1 DrawRect copies repeated texels, clipped to the scissor box
+static bool CheckDrawRect(Bench * bench, char * status, const unsigned size)
+{
+   GGLInterface_t * iface = bench->iface;
+   const GLint x = 5, y = 7, width = 100, height = 60, u = 250, v = 3;
+   const GLint boxX = 20, boxY = 0, boxWidth = 50, boxHeight = 40;
+   Frame cleared, frame;
+   ResetState(bench);
+   ReadFrame(bench, &cleared);
+
+   iface->Scissor(iface, boxX, boxY, boxWidth, boxHeight);
+   iface->EnableDisable(iface, GL_SCISSOR_TEST, true);
+   const bool drawn = iface->DrawRect(iface, 0, x, y, width, height, u, v, width, height);
+   iface->Finish(iface);
+   iface->EnableDisable(iface, GL_SCISSOR_TEST, false);
+   if (!drawn) {
+      snprintf(status, size, "DrawRect fell back to the general path");
+      return false;
+   }
+   ReadFrame(bench, &frame);
+
+   const unsigned * texels = (const unsigned *)bench->texture.levels;
+   unsigned mismatches = 0;
+   for (int j = 0; j < (int)bench->height; j++)
+      for (int i = 0; i < (int)bench->width; i++) {
+         const bool inside = x <= i && i < x + width && y <= j && j < y + height &&
+                             boxX <= i && i < boxX + boxWidth && boxY <= j && j < boxY + boxHeight;
+         const unsigned texel = (v + j - y) % bench->texture.height * bench->texture.width +
+                                (u + i - x) % bench->texture.width;
+         const unsigned index = j * bench->width + i;
+         mismatches += frame.color[index] != (inside ? texels[texel] : cleared.color[index]);
+      }
+   if (mismatches)
+      snprintf(status, size, "%u pixels differ", mismatches);
+   return !mismatches;
+}
+
+static const struct {
+   const char * name;
+   bool (* run)(Bench * bench, char * status, const unsigned size);
+} checks[] = {
+   {"deferred", CheckDeferred},
+   {"binary", CheckBinary},
+   {"clears", CheckClears},
+   {"scissor", CheckScissor},
+   {"draw_rect", CheckDrawRect},
+};
+
+int main(int argc, char ** argv)
+{
+   Bench bench;
+   memset(&bench, 0, sizeof(bench));
+   bench.width = 800;
+   bench.height = 480;
+   unsigned frames = 30;
+   bench.tolerance = 2;
+   const char * only = NULL, * outputDir = NULL, * goldenDir = NULL;
+   bool deferred = false, check = false;
+
+   int c;
+   while ((c = getopt(argc, argv, "W:H:n:s:o:g:t:dc")) != -1) {
+      switch (c) {
+      case 'W': bench.width = atoi(optarg); break;
+      case 'H': bench.height = atoi(optarg); break;
+      case 'n': frames = atoi(optarg); break;
+      case 's': only = optarg; break;
+      case 'o': outputDir = optarg; break;
+      case 'g': goldenDir = optarg; break;
+      case 't': bench.tolerance = atoi(optarg); break;
+      case 'd': deferred = true; break;
+      case 'c': check = true; break;
+      default:
+         fprintf(stderr, "usage: %s [-W width] [-H height] [-n frames] [-s scene] "
+                 "[-o output dir] [-g golden dir] [-t tolerance] [-d] [-c]\n", argv[0]);
+         return 1;
+      }
+   }
+   if (!bench.width || !bench.height || !frames) {
+      fprintf(stderr, "width, height and frames must be positive\n");
+      return 1;
+   }
+
+   bench.iface = CreateGGLInterface();
+   GGLInterface_t * iface = bench.iface;
+   iface->Viewport(iface, 0, 0, bench.width, bench.height);
+   CreateSurfaces(&bench);
+   if (deferred)
+      iface->EnableDisable(iface, GGL_DEFERRED_RENDERING, true);
+   bench.textureProgram = CreateProgram(iface, textureShader);
+   bench.modulateProgram = CreateProgram(iface, modulateShader);
+   bench.colorProgram = CreateProgram(iface, colorShader);
+   bench.modulateColor = iface->ShaderUniformLocation(bench.modulateProgram, "uColor");
+
+   int failures = 0;
+   if (check) {
+      for (unsigned i = 0; i < sizeof(checks) / sizeof(*checks); i++) {
+         char status[256] = "ok";
+         const bool ok = checks[i].run(&bench, status, sizeof(status));
+         printf("%-16s %s%s\n", checks[i].name, ok ? "" : "FAIL ", status);
+         failures += !ok;
+      }
+   } else {
+      printf("%ux%u, %u frames per scene%s\n", bench.width, bench.height, frames,
+             deferred ? ", deferred" : "");
+      printf("%-16s %10s %12s %10s %5s %8s %6s %s\n", "scene", "ms/frame", "triangles/s",
+             "Mpixels/s", "jit", "jit ms", "hit %", "golden");
+
+      bool found = false;
+      for (unsigned i = 0; i < sizeof(scenes) / sizeof(*scenes); i++) {
+         const Scene & scene = scenes[i];
+         if (only && strcmp(only, scene.name))
+            continue;
+         found = true;
+
+         // first frame includes the JIT for each state the scene uses
+         GGLShaderStatistics_t jit;
+         GGLShaderGetStatistics(&jit, GL_TRUE);
+         scene.draw(&bench);
+         iface->Finish(iface);
+         bench.triangles = bench.pixels = 0;
+         const double start = Now();
+         for (unsigned f = 0; f < frames; f++)
+            scene.draw(&bench);
+         iface->Finish(iface); // no-op unless deferred
+         const double seconds = Now() - start;
+         GGLShaderGetStatistics(&jit, GL_TRUE);
+
+         char status[64] = "-";
+         char fileName[1024];
+         if (outputDir) {
+            snprintf(fileName, sizeof(fileName), "%s/%s.ppm", outputDir, scene.name);
+            if (!WritePPM(&bench, fileName))
+               fprintf(stderr, "failed to write %s\n", fileName);
+         }
+         if (goldenDir) {
+            snprintf(fileName, sizeof(fileName), "%s/%s.ppm", goldenDir, scene.name);
+            unsigned maxDiff = 0;
+            const int mismatches = ComparePPM(&bench, fileName, bench.tolerance, &maxDiff);
+            if (mismatches < 0)
+               snprintf(status, sizeof(status), "missing %s", fileName);
+            else if (mismatches)
+               snprintf(status, sizeof(status), "FAIL %d pixels, max diff %u", mismatches, maxDiff);
+            else
+               snprintf(status, sizeof(status), "ok, max diff %u", maxDiff);
+            failures += 0 != mismatches;
+         }
+
+         const unsigned lookups = jit.jitCount + jit.cacheHits;
+         printf("%-16s %10.3f %12.0f %10.2f %5u %8.2f %6.1f %s\n", scene.name,
+                seconds * 1000 / frames, bench.triangles / seconds, bench.pixels / seconds / 1e6,
+                jit.jitCount, jit.jitSeconds * 1000,
+                lookups ? jit.cacheHits * 100.0 / lookups : 0.0, status);
+      }
+      if (!found) {
+         fprintf(stderr, "unknown scene '%s'\n", only);
+         failures++;
+      }
+   }
+
+   iface->ShaderUse(iface, NULL);
+   iface->ShaderProgramDelete(iface, bench.textureProgram);
+   iface->ShaderProgramDelete(iface, bench.modulateProgram);
+   iface->ShaderProgramDelete(iface, bench.colorProgram);
+   iface->SetSampler(iface, 0, NULL);
+   free(bench.texture.levels);
+   free(bench.frameSurface.data);
+   free(bench.depthSurface.data);
+   free(bench.stencilSurface.data);
+   DestroyGGLInterface(iface);
+   return failures ? 1 : 0;
+}
@@ -86,11 +86,38 @@ static void ProcessVertex(const GGLInterface * iface, const VertexInput * input,
 //#endif
 }
 
+// horizontally clips the line from bV to cV to [left, right]; false if it is outside
+static inline bool ClipSpan(const VertexOutput * bV, const VertexOutput * cV,
+                            const int left, const int right, const unsigned varyingCount,
+                            VertexOutput * clip0, VertexOutput * clip1,
+                            const VertexOutput ** start, const VertexOutput ** end)
+{
+   // also catches crossed edges, whose negative end would wrap when cast to unsigned
+   if (cV->position.x < left || bV->position.x >= right + 1)
+      return false;
+   if (bV->position.x < left) {
+      InterpolateVertex(bV, cV, (left - bV->position.x) / (cV->position.x - bV->position.x),
+                        clip0, varyingCount);
+      clip0->position.x = left; // rounding must not reach the pixel before left
+      *start = clip0;
+   } else
+      *start = bV;
+   if (cV->position.x >= right + 1) { // not (int) cast, x may not fit
+      InterpolateVertex(bV, cV, (right - bV->position.x) / (cV->position.x - bV->position.x),
+                        clip1, varyingCount);
+      clip1->position.x = right;
+      *end = clip1;
+   } else
+      *end = cV;
+   return true;
+}
+
 #if USE_DUAL_THREAD
 static void * RasterTrapezoidWorker(void * threadArgs)
 {
    GGLContext::Worker * args = (GGLContext::Worker *)threadArgs;
-   VertexOutput clip0, clip1, * left, * right;
+   VertexOutput clip0, clip1;
+   const VertexOutput * left, * right;
 
    pthread_mutex_lock(&args->finishLock);
    pthread_mutex_lock(&args->assignLock);
@@ -108,28 +135,12 @@ static void * RasterTrapezoidWorker(void * threadArgs)
           assert(args->assignedWork);
 
       for (unsigned y = args->startY; y <= args->endY; y += 2) {
-         do {
-            if (args->bV.position.x < 0) {
-               if (args->cV.position.x < 0)
-                  break;
-               InterpolateVertex(&args->bV, &args->cV, -args->bV.position.x /
-                                 (args->cV.position.x - args->bV.position.x),
-                                 &clip0, args->varyingCount);
-               left = &clip0;
-            } else
-               left = &args->bV;
-            if ((int)args->cV.position.x >= (int)args->width) {
-               if (args->bV.position.x >= (int)args->width)
-                  break;
-               InterpolateVertex(&args->bV, &args->cV, (args->width - 1 - args->bV.position.x) /
-                                 (args->cV.position.x - args->bV.position.x),
-                                 &clip1, args->varyingCount);
-               right = &clip1;
-            } else
-               right = &args->cV;
+         if (ClipSpan(&args->bV, &args->cV, args->left, args->right, args->varyingCount,
+                      &clip0, &clip1, &left, &right))
             args->iface->ScanLine(args->iface, left, right);
-         } while (false);
          for (unsigned i = 0; i < args->varyingCount; i++) {
+            if (!(args->interpolated & (1 << i)))
+               continue;
             args->bV.varyings[i] += args->bDx.varyings[i];
             args->cV.varyings[i] += args->cDx.varyings[i];
          }
@@ -148,84 +159,83 @@ static void * RasterTrapezoidWorker(void * threadArgs)
 }
 #endif
 
-static void RasterTrapezoid(const GGLInterface * iface, const VertexOutput * tl,
-                            const VertexOutput * tr, const VertexOutput * bl,
-                            const VertexOutput * br)
+// trapezoid vertically clipped to [clip->top, clip->bottom] and set up for stepping down lines;
+// bV and cV are left and right vertices on a horizontal line in quad
+// bDx and cDx are iterators from tlv to blv, trv to brv for bV and cV
+// varyings equal at all four corners have zero steps and are not stepped
+struct TrapezoidSteps {
+   VertexOutput bV, cV, bDx, cDx;
+   unsigned startY, endY;
+   unsigned interpolated; // bit i set if varyings[i] changes over the trapezoid
+};
+
+static bool SetupTrapezoid(const VertexOutput * tl, const VertexOutput * tr,
+                           const VertexOutput * bl, const VertexOutput * br,
+                           const GGLRect * clip, const unsigned varyingCount,
+                           TrapezoidSteps * steps)
 {
-   GGL_GET_CONST_CONTEXT(ctx, iface);
-
    assert(tl->position.x <= tr->position.x && bl->position.x <= br->position.x);
    assert(tl->position.y <= bl->position.y && tr->position.y <= br->position.y);
    assert(fabs(tl->position.y - tr->position.y) < 1 && fabs(bl->position.y - br->position.y) < 1);
 
-   const unsigned width = ctx->frameSurface.width, height = ctx->frameSurface.height;
-   const unsigned varyingCount = ctx->CurrentProgram->VaryingSlots;
-
-
    // tlv-trv and blv-brv are parallel and horizontal
-   VertexOutput tlv(*tl), trv(*tr), blv(*bl), brv(*br);
+   VertexOutput tlv, trv, blv, brv;
+   CopyVertexOutput(&tlv, tl, varyingCount);
+   CopyVertexOutput(&trv, tr, varyingCount);
+   CopyVertexOutput(&blv, bl, varyingCount);
+   CopyVertexOutput(&brv, br, varyingCount);
    VertexOutput tmp;
 
    // vertically clip
 
-   if ((int)tlv.position.y < 0) {
-      InterpolateVertex(&tlv, &blv, (0 - tlv.position.y) / (blv.position.y - tlv.position.y),
+   if ((int)tlv.position.y < clip->top) {
+      InterpolateVertex(&tlv, &blv, (clip->top - tlv.position.y) / (blv.position.y - tlv.position.y),
                         &tmp, varyingCount);
-      tlv = tmp;
+      tmp.position.y = clip->top; // so line is not rounded outside clip
+      CopyVertexOutput(&tlv, &tmp, varyingCount);
    }
-   if ((int)trv.position.y < 0) {
-      InterpolateVertex(&trv, &brv, (0 - trv.position.y) / (brv.position.y - trv.position.y),
+   if ((int)trv.position.y < clip->top) {
+      InterpolateVertex(&trv, &brv, (clip->top - trv.position.y) / (brv.position.y - trv.position.y),
                         &tmp, varyingCount);
-      trv = tmp;
+      tmp.position.y = clip->top;
+      CopyVertexOutput(&trv, &tmp, varyingCount);
    }
-   if ((int)blv.position.y >= (int)height) {
-      InterpolateVertex(&tlv, &blv, (height - 1 - tlv.position.y) / (blv.position.y - tlv.position.y),
+   if ((int)blv.position.y > clip->bottom) {
+      InterpolateVertex(&tlv, &blv, (clip->bottom - tlv.position.y) / (blv.position.y - tlv.position.y),
                         &tmp, varyingCount);
-      blv = tmp;
+      tmp.position.y = clip->bottom;
+      CopyVertexOutput(&blv, &tmp, varyingCount);
    }
-   if ((int)brv.position.y >= (int)height) {
-      InterpolateVertex(&trv, &brv, (height - 1 - trv.position.y) / (brv.position.y - trv.position.y),
+   if ((int)brv.position.y > clip->bottom) {
+      InterpolateVertex(&trv, &brv, (clip->bottom - trv.position.y) / (brv.position.y - trv.position.y),
                         &tmp, varyingCount);
-      brv = tmp;
+      tmp.position.y = clip->bottom;
+      CopyVertexOutput(&brv, &tmp, varyingCount);
    }
 
-//   // horizontally clip
-//   if ((int)tlv.position.x < 0) {
-//      InterpolateVertex(&tlv, &trv, (0 - tlv.position.x) / (trv.position.x - tlv.position.x),
-//                        &tmp, varyingCount);
-//      tlv = tmp;
-//   }
-//   if ((int)blv.position.x < 0) {
-//      InterpolateVertex(&blv, &brv, (0 - blv.position.x) / (brv.position.x - blv.position.x),
-//                        &tmp, varyingCount);
-//      blv = tmp;
-//   }
-//   if ((int)trv.position.x >= (int)width) {
-//      InterpolateVertex(&tlv, &trv, (width - 1 - tlv.position.x) / (trv.position.x - tlv.position.x),
-//                        &tmp, varyingCount);
-//      trv = tmp;
-//   }
-//   if ((int)brv.position.x >= (int)width) {
-//      InterpolateVertex(&blv, &brv, (width - 1 - blv.position.x) / (brv.position.x - blv.position.x),
-//                        &tmp, varyingCount);
-//      brv = tmp;
-//   }
+   steps->startY = tlv.position.y;
+   steps->endY = blv.position.y;
 
-   const unsigned int startY = tlv.position.y;
-   const unsigned int endY = blv.position.y;
+   if (steps->endY < steps->startY)
+      return false;
 
-   if (endY < startY)
-      return;
+   const VectorComp_t yDistInv = VectorComp_t_CTR(1.0f / (steps->endY - steps->startY));
 
-   const VectorComp_t yDistInv = VectorComp_t_CTR(1.0f / (endY - startY));
-
-   // bV and cV are left and right vertices on a horizontal line in quad
-   // bDx and cDx are iterators from tlv to blv, trv to brv for bV and cV
-
-   VertexOutput bV(tlv), cV(trv);
-   VertexOutput bDx(blv), cDx(brv);
+   CopyVertexOutput(&steps->bV, &tlv, varyingCount);
+   CopyVertexOutput(&steps->cV, &trv, varyingCount);
+   VertexOutput & bDx = steps->bDx, & cDx = steps->cDx;
+   CopyVertexOutput(&bDx, &blv, varyingCount);
+   CopyVertexOutput(&cDx, &brv, varyingCount);
 
+   steps->interpolated = 0;
    for (unsigned i = 0; i < varyingCount; i++) {
+      const Vector4 & varying = tl->varyings[i];
+      if (varying == tr->varyings[i] && varying == bl->varyings[i] && varying == br->varyings[i]) {
+         bDx.varyings[i] = cDx.varyings[i] = Vector4_CTR(0, 0, 0, 0);
+         continue;
+      }
+      steps->interpolated |= 1 << i;
+
       bDx.varyings[i] -= tlv.varyings[i];
       bDx.varyings[i] *= yDistInv;
 
@@ -245,6 +255,41 @@ static void RasterTrapezoid(const GGLInterface * iface, const VertexOutput * tl,
    cDx.frontFacingPointCoord -= trv.frontFacingPointCoord; // gl_PointCoord
    cDx.frontFacingPointCoord *= yDistInv;
    cDx.frontFacingPointCoord.y = VectorComp_t_Zero; // gl_FrontFacing not interpolated
+   return true;
+}
+
+static inline void StepTrapezoid(TrapezoidSteps * steps, const unsigned varyingCount)
+{
+   for (unsigned i = 0; i < varyingCount; i++) {
+      if (!(steps->interpolated & (1 << i)))
+         continue;
+      steps->bV.varyings[i] += steps->bDx.varyings[i];
+      steps->cV.varyings[i] += steps->cDx.varyings[i];
+   }
+   steps->bV.position += steps->bDx.position;
+   steps->cV.position += steps->cDx.position;
+   steps->bV.frontFacingPointCoord += steps->bDx.frontFacingPointCoord;
+   steps->cV.frontFacingPointCoord += steps->cDx.frontFacingPointCoord;
+}
+
+static void RasterTrapezoid(const GGLInterface * iface, const VertexOutput * tl,
+                            const VertexOutput * tr, const VertexOutput * bl,
+                            const VertexOutput * br)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+
+   const unsigned varyingCount = ctx->CurrentProgram->VaryingSlots;
+
+   GGLRect clip; // off scissor lines and pixels are never stepped or shaded
+   ScissorRect(ctx, ctx->frameSurface.width, ctx->frameSurface.height, &clip);
+   if (clip.right < clip.left || clip.bottom < clip.top)
+      return;
+
+   TrapezoidSteps steps;
+   if (!SetupTrapezoid(tl, tr, bl, br, &clip, varyingCount, &steps))
+      return;
+   const unsigned startY = steps.startY, endY = steps.endY;
+   VertexOutput & bV = steps.bV, & cV = steps.cV, & bDx = steps.bDx, & cDx = steps.cDx;
 
 #if USE_DUAL_THREAD
    GGLContext::Worker & args = ctx->worker;
@@ -262,9 +307,11 @@ static void RasterTrapezoid(const GGLInterface * iface, const VertexOutput * tl,
    if (args.startY <= args.endY) {
       pthread_mutex_lock(&args.assignLock);
 
-      args.bV = bV;
-      args.cV = cV;
+      CopyVertexOutput(&args.bV, &bV, varyingCount);
+      CopyVertexOutput(&args.cV, &cV, varyingCount);
       for (unsigned i = 0; i < varyingCount; i++) {
+         if (!(steps.interpolated & (1 << i)))
+            continue;
          args.bV.varyings[i] += bDx.varyings[i];
          bDx.varyings[i] += bDx.varyings[i];
          args.cV.varyings[i] += cDx.varyings[i];
@@ -279,11 +326,12 @@ static void RasterTrapezoid(const GGLInterface * iface, const VertexOutput * tl,
       args.cV.frontFacingPointCoord += cDx.frontFacingPointCoord;
       cDx.frontFacingPointCoord += cDx.frontFacingPointCoord;
       args.iface = iface;
-      args.bDx = bDx;
-      args.cDx = cDx;
+      CopyVertexOutput(&args.bDx, &bDx, varyingCount);
+      CopyVertexOutput(&args.cDx, &cDx, varyingCount);
       args.varyingCount = varyingCount;
-      args.width = width;
-      args.height = height;
+      args.interpolated = steps.interpolated;
+      args.left = clip.left;
+      args.right = clip.right;
       args.assignedWork = true;
 
       pthread_cond_signal(&args.assignCond);
@@ -291,37 +339,13 @@ static void RasterTrapezoid(const GGLInterface * iface, const VertexOutput * tl,
    }
 #endif
 
-   VertexOutput * left, * right;
+   const VertexOutput * left, * right;
    VertexOutput clip0, clip1;
 
    for (unsigned y = startY; y <= endY; y += 1 + USE_DUAL_THREAD) {
-      do {
-         if (bV.position.x < 0) {
-            if (cV.position.x < 0)
-               break;
-            InterpolateVertex(&bV, &cV, -bV.position.x / (cV.position.x - bV.position.x),
-                              &clip0, varyingCount);
-            left = &clip0;
-         } else
-            left = &bV;
-         if ((int)cV.position.x >= (int)width) {
-            if (bV.position.x >= (int)width)
-               break;
-            InterpolateVertex(&bV, &cV, (width - 1 - bV.position.x) / (cV.position.x - bV.position.x),
-                              &clip1, varyingCount);
-            right = &clip1;
-         } else
-            right = &cV;
+      if (ClipSpan(&bV, &cV, clip.left, clip.right, varyingCount, &clip0, &clip1, &left, &right))
          iface->ScanLine(iface, left, right);
-      } while (false);
-      for (unsigned i = 0; i < varyingCount; i++) {
-         bV.varyings[i] += bDx.varyings[i];
-         cV.varyings[i] += cDx.varyings[i];
-      }
-      bV.position += bDx.position;
-      cV.position += cDx.position;
-      bV.frontFacingPointCoord += bDx.frontFacingPointCoord;
-      cV.frontFacingPointCoord += cDx.frontFacingPointCoord;
+      StepTrapezoid(&steps, varyingCount);
    }
 
 #if USE_DUAL_THREAD
@@ -333,12 +357,29 @@ static void RasterTrapezoid(const GGLInterface * iface, const VertexOutput * tl,
 #endif
 }
 
-static void RasterTriangle(const GGLInterface * iface, const VertexOutput * v1,
-                           const VertexOutput * v2, const VertexOutput * v3)
+// flat varyings take the value of the provoking (last) vertex over the whole triangle;
+// v1 and v2 are replaced by copies in flatVertices carrying v3's flat varyings
+static void FlatVaryings(const unsigned flat, const unsigned varyingCount,
+                         const VertexOutput ** v1, const VertexOutput ** v2,
+                         const VertexOutput * v3, VertexOutput flatVertices[2])
+{
+   if (!flat)
+      return;
+   CopyVertexOutput(flatVertices + 0, *v1, varyingCount);
+   CopyVertexOutput(flatVertices + 1, *v2, varyingCount);
+   for (unsigned i = 0; i < varyingCount; i++)
+      if (flat & (1 << i))
+         flatVertices[0].varyings[i] = flatVertices[1].varyings[i] = v3->varyings[i];
+   *v1 = flatVertices + 0;
+   *v2 = flatVertices + 1;
+}
+
+// sorts triangle by y and splits it into trapezoids abc and bcd sharing horizontal edge bc;
+// c is created in cVertex and b is left of c
+static void SplitTriangle(const VertexOutput * v1, const VertexOutput * v2,
+                          const VertexOutput * v3, const unsigned varyingCount,
+                          VertexOutput * cVertex, const VertexOutput * trapezoid[4])
 {
-   GGL_GET_CONST_CONTEXT(ctx, iface);
-   const unsigned varyingCount = ctx->CurrentProgram->VaryingSlots;
-   const unsigned height = ctx->frameSurface.height;
    const VertexOutput * a = v1, * b = v2, * d = v3;
    //abc is a triangle, bcd is another triangle, they share bc as horizontal edge
    //c is between a and d, xy is screen coord
@@ -359,13 +400,12 @@ static void RasterTriangle(const GGLInterface * iface, const VertexOutput * v1,
 
    assert(a->position.y <= b->position.y && b->position.y <= d->position.y);
 
-   VertexOutput cVertex;
-   const VertexOutput* c = &cVertex;
+   const VertexOutput* c = cVertex;
 
    const VectorComp_t cLerp = (b->position.y - a->position.y) /
                               MAX2(VectorComp_t_One, (d->position.y - a->position.y));
    // create 4th vertex, same y as b to form two triangles/trapezoids sharing horizontal edge
-   InterpolateVertex(a, d, cLerp, &cVertex, varyingCount);
+   InterpolateVertex(a, d, cLerp, cVertex, varyingCount);
 
    if (c->position.x < b->position.x) {
       const VertexOutput * tmp = c;
@@ -373,21 +413,130 @@ static void RasterTriangle(const GGLInterface * iface, const VertexOutput * v1,
       b = tmp;
    }
 
-   if ((int)a->position.y < (int)height && (int)b->position.y >= 0)
+   trapezoid[0] = a;
+   trapezoid[1] = b;
+   trapezoid[2] = c;
+   trapezoid[3] = d;
+}
+
+static void RasterTriangle(const GGLInterface * iface, const VertexOutput * v1,
+                           const VertexOutput * v2, const VertexOutput * v3)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   const unsigned varyingCount = ctx->CurrentProgram->VaryingSlots;
+   GGLRect clip;
+   ScissorRect(ctx, ctx->frameSurface.width, ctx->frameSurface.height, &clip);
+   if (clip.right < clip.left || clip.bottom < clip.top)
+      return;
+
+   VertexOutput flatVertices[2];
+   FlatVaryings(ctx->CurrentProgram->VaryingFlat, varyingCount, &v1, &v2, v3, flatVertices);
+
+   VertexOutput cVertex;
+   const VertexOutput * trapezoid[4];
+   SplitTriangle(v1, v2, v3, varyingCount, &cVertex, trapezoid);
+   const VertexOutput * a = trapezoid[0], * b = trapezoid[1], * c = trapezoid[2],
+                        * d = trapezoid[3];
+
+   if ((int)a->position.y <= clip.bottom && (int)b->position.y >= clip.top)
       RasterTrapezoid(iface, a, a, b, c);
    //b->position.y += VectorComp_t_One;
    //c->position.y += VectorComp_t_One;
-   if ((int)b->position.y < (int)height && (int)d->position.y >= 0)
+   if ((int)b->position.y <= clip.bottom && (int)d->position.y >= clip.top)
       RasterTrapezoid(iface, b, c, d, d);
 }
 
+static void RasterTrapezoidTile(const GGLScanLineTarget * target, GGLActiveStencil * activeStencil,
+                                const VertexOutput * tl, const VertexOutput * tr,
+                                const VertexOutput * bl, const VertexOutput * br,
+                                const GGLRect * tile)
+{
+   const unsigned varyingCount = target->varyingCount;
+   // set up against the whole clip like RasterTrapezoid, so every tile steps the same lines
+   TrapezoidSteps steps;
+   if (!SetupTrapezoid(tl, tr, bl, br, &target->clip, varyingCount, &steps))
+      return;
+   if ((int)steps.endY < tile->top || (int)steps.startY > tile->bottom)
+      return;
+
+   unsigned y = steps.startY;
+   if ((int)y < tile->top) { // skip lines above tile
+      const VectorComp_t lines = VectorComp_t_CTR(tile->top - y);
+      VertexOutput skip;
+      CopyVertexOutput(&skip, &steps.bDx, varyingCount);
+      for (unsigned i = 0; i < varyingCount; i++) {
+         if (!(steps.interpolated & (1 << i)))
+            continue;
+         skip.varyings[i] *= lines;
+         steps.bV.varyings[i] += skip.varyings[i];
+         skip.varyings[i] = steps.cDx.varyings[i];
+         skip.varyings[i] *= lines;
+         steps.cV.varyings[i] += skip.varyings[i];
+      }
+      skip.position *= lines;
+      steps.bV.position += skip.position;
+      skip.position = steps.cDx.position;
+      skip.position *= lines;
+      steps.cV.position += skip.position;
+      skip.frontFacingPointCoord *= lines;
+      steps.bV.frontFacingPointCoord += skip.frontFacingPointCoord;
+      skip.frontFacingPointCoord = steps.cDx.frontFacingPointCoord;
+      skip.frontFacingPointCoord *= lines;
+      steps.cV.frontFacingPointCoord += skip.frontFacingPointCoord;
+      y = tile->top;
+   }
+   const unsigned endY = MIN2(steps.endY, (unsigned)tile->bottom);
+
+   const VertexOutput * left, * right;
+   VertexOutput clip0, clip1;
+
+   for (; y <= endY; y++) {
+      // line comes from y rather than interpolated position, so it cannot leave the tile
+      if (ClipSpan(&steps.bV, &steps.cV, tile->left, tile->right, varyingCount,
+                   &clip0, &clip1, &left, &right))
+         ScanLineSpan(target, activeStencil, y, left, right);
+      StepTrapezoid(&steps, varyingCount);
+   }
+}
+
+void RasterTriangleTile(const GGLScanLineTarget * target, GGLActiveStencil * activeStencil,
+                        const VertexOutput * v1, const VertexOutput * v2,
+                        const VertexOutput * v3, const GGLRect * tile)
+{
+   // tiles may extend past frame surface if depth or stencil is bigger
+   GGLRect clipped = *tile;
+   clipped.left = MAX2(clipped.left, target->clip.left);
+   clipped.top = MAX2(clipped.top, target->clip.top);
+   clipped.right = MIN2(clipped.right, target->clip.right);
+   clipped.bottom = MIN2(clipped.bottom, target->clip.bottom);
+   if (clipped.right < clipped.left || clipped.bottom < clipped.top)
+      return;
+
+   VertexOutput flatVertices[2];
+   FlatVaryings(target->varyingFlat, target->varyingCount, &v1, &v2, v3, flatVertices);
+
+   VertexOutput cVertex;
+   const VertexOutput * trapezoid[4];
+   SplitTriangle(v1, v2, v3, target->varyingCount, &cVertex, trapezoid);
+   const VertexOutput * a = trapezoid[0], * b = trapezoid[1], * c = trapezoid[2],
+                        * d = trapezoid[3];
+
+   // same split and row ownership as RasterTriangle, so tiles add up to the immediate result
+   if ((int)a->position.y <= clipped.bottom && (int)b->position.y >= clipped.top)
+      RasterTrapezoidTile(target, activeStencil, a, a, b, c, &clipped);
+   if ((int)b->position.y <= clipped.bottom && (int)d->position.y >= clipped.top)
+      RasterTrapezoidTile(target, activeStencil, b, c, d, d, &clipped);
+}
+
 static void DrawTriangle(const GGLInterface * iface, const VertexInput * vin1,
                          const VertexInput * vin2, const VertexInput * vin3)
 {
    GGL_GET_CONST_CONTEXT(ctx, iface);
 
    VertexOutput vouts[3];
-   memset(vouts, 0, sizeof(vouts));
+   const unsigned size = VertexOutputVectors(ctx->CurrentProgram->VaryingSlots) * sizeof(Vector4);
+   for (unsigned i = 0; i < 3; i++)
+      memset(vouts + i, 0, size);
    VertexOutput * v1 = vouts + 0, * v2 = vouts + 1, * v3 = vouts + 2;
 
 //   ALOGD("pf2: DrawTriangle");
@@ -464,6 +613,14 @@ static void DrawTriangle(const GGLInterface * iface, const VertexInput * vin1,
 //        v2->position.x, v2->position.y, v2->position.z, v2->position.w,
 //        v3->position.x, v3->position.y, v3->position.z, v3->position.w);
 
+   SetupTriangle(iface, v1, v2, v3);
+}
+
+void SetupTriangle(const GGLInterface * iface, VertexOutput * v1, VertexOutput * v2,
+                   VertexOutput * v3)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+
    v1->position /= v1->position.w;
    v2->position /= v2->position.w;
    v3->position /= v3->position.w;
@@ -562,7 +719,10 @@ static void PickRaster(GGLInterface * iface)
 {
    iface->ProcessVertex = ProcessVertex;
    iface->DrawTriangle = DrawTriangle;
-   iface->RasterTriangle = RasterTriangle;
+   iface->DrawTriangles = DrawTriangles;
+   // deferred rendering records vertex processed triangles and rasters them at Flush
+   iface->RasterTriangle = reinterpret_cast<GGLContext *>(iface)->deferred ?
+                           DeferTriangle : RasterTriangle;
    iface->RasterTrapezoid = RasterTrapezoid;
 }
 
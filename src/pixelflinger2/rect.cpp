@@ -0,0 +1,293 @@
+/**
+ **
+ ** Copyright 2011, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+// DrawRect: screen aligned texture blits for 2D compositing. Instead of vertex
+// shading, trapezoid setup and per pixel varying stepping, each row maps window
+// pixel centers to texels with an integer quotient and remainder walk and converts,
+// copies or source over blends them straight from GGLTexture::levels into the
+// frame surface.
+// Texel decode and blend arithmetic match texture.cpp and the scanline JIT.
+
+#include <string.h>
+
+#include "pixelflinger2.h"
+
+// texel to RGBA_8888 as PointSample does
+template<GGLPixelFormat format>
+static inline unsigned LoadTexel(const void * texels, const unsigned index)
+{
+   if (GGL_PIXEL_FORMAT_RGBA_8888 == format)
+      return ((const unsigned *)texels)[index];
+   else if (GGL_PIXEL_FORMAT_RGBX_8888 == format)
+      return ((const unsigned *)texels)[index] | 0xff000000;
+   else {
+      const unsigned texel = ((const unsigned short *)texels)[index];
+      unsigned r = (texel & 0x1f) << 3, g = (texel & 0x7e0) << 5, b = (texel & 0xf800) << 8;
+      r |= r >> 5;
+      g = (g | (g >> 6)) & 0xff00;
+      b = (b | (b >> 5)) & 0xff0000;
+      return r | g | b | 0xff000000;
+   }
+}
+
+// frame surface pixel to RGBA_8888 as ScreenColorToIntVector does
+template<GGLPixelFormat format>
+static inline unsigned LoadPixel(const void * pixels, const unsigned index)
+{
+   if (GGL_PIXEL_FORMAT_RGBA_8888 == format)
+      return ((const unsigned *)pixels)[index];
+   const unsigned pixel = ((const unsigned short *)pixels)[index];
+   return ((pixel & 0xf800) >> 8) | ((pixel & 0x7e0) << 5) | ((pixel & 0x1f) << 19) | 0xff000000;
+}
+
+// RGBA_8888 to frame surface pixel as IntVectorToScreenColor does
+template<GGLPixelFormat format>
+static inline void StorePixel(void * pixels, const unsigned index, const unsigned color)
+{
+   if (GGL_PIXEL_FORMAT_RGBA_8888 == format)
+      ((unsigned *)pixels)[index] = color;
+   else
+      ((unsigned short *)pixels)[index] = ((color & 0xf8) << 8) | ((color & 0xfc00) >> 5) |
+                                          ((color & 0xf80000) >> 19);
+}
+
+// same integer math as the scanline JIT: factors scaled by 256 / 255, sum >> 8, saturated
+template<unsigned blend>
+static inline unsigned Blend(const unsigned src, const unsigned dst)
+{
+   const unsigned srcA = src >> 24;
+   unsigned df = 255 - srcA;
+   df += df >> 7;
+   unsigned sfColor = blend & GGL_RECT_COLOR_SRC_ALPHA ? srcA : 255;
+   sfColor += sfColor >> 7;
+   unsigned sfAlpha = blend & GGL_RECT_ALPHA_SRC_ALPHA ? srcA : 255;
+   sfAlpha += sfAlpha >> 7;
+
+   unsigned result = 0;
+   for (unsigned i = 0; i < 32; i += 8) {
+      const unsigned sf = 24 == i ? sfAlpha : sfColor;
+      const unsigned c = (((src >> i) & 0xff) * sf + ((dst >> i) & 0xff) * df) >> 8;
+      result |= MIN2(c, 255u) << i;
+   }
+   return result;
+}
+
+static inline unsigned Wrap(int coord, const unsigned size, const unsigned wrap)
+{
+   if (GGLTexture::GGL_CLAMP_TO_EDGE == wrap)
+      return MIN2(MAX2(coord, 0), (int)size - 1);
+   const int period = GGLTexture::GGL_MIRRORED_REPEAT == wrap ? size * 2 : size;
+   coord %= period;
+   if (coord < 0)
+      coord += period;
+   return coord < (int)size ? coord : period - 1 - coord;
+}
+
+template<GGLPixelFormat textureFormat, GGLPixelFormat colorFormat, unsigned blend>
+static void BlitRows(const GGLRectBlit * blit, const GGLRect * rect)
+{
+   const GGLTexture & texture = blit->texture;
+   const unsigned texelSize = GGL_PIXEL_FORMAT_RGB_565 == textureFormat ? 2 : 4;
+   const unsigned count = rect->right - rect->left + 1;
+   // pixel center d + 0.5 is at texel (2d + 1) * crop / (2 * size) from u or v, exactly
+   const unsigned long long startX = (2ull * (rect->left - blit->x) + 1) * blit->cropWidth;
+   const unsigned divisor = 2 * blit->width;
+   const int u = blit->u + startX / divisor;
+   const unsigned stepQuotient = blit->cropWidth / blit->width;
+   const unsigned stepRemainder = 2 * blit->cropWidth % divisor;
+   // neither scaled nor wrapped
+   const bool contiguous = blit->cropWidth == blit->width && u >= 0 &&
+                           (unsigned)u + count <= texture.width;
+
+   for (int y = rect->top; y <= rect->bottom; y++) {
+      const int v = blit->v + (2ull * (y - blit->y) + 1) * blit->cropHeight / (2 * blit->height);
+      const unsigned row = Wrap(v, texture.height, texture.wrapT);
+      const void * texels = (const char *)texture.levels + row * texture.width * texelSize;
+      const unsigned pixel = y * blit->frameWidth + rect->left;
+
+      // RGB_565 textures keep red in the low bits, surfaces in the high bits
+      if (contiguous && GGL_RECT_COPY == blend && GGL_PIXEL_FORMAT_RGBA_8888 == textureFormat &&
+            GGL_PIXEL_FORMAT_RGBA_8888 == colorFormat) {
+         memcpy((char *)blit->frameBuffer + pixel * texelSize,
+                (const char *)texels + u * texelSize, count * texelSize);
+         continue;
+      }
+      int column = u;
+      unsigned remainder = startX % divisor;
+      for (unsigned x = 0; x < count; x++) {
+         const unsigned texel = LoadTexel<textureFormat>(texels, contiguous ? u + x :
+                                Wrap(column, texture.width, texture.wrapS));
+         column += stepQuotient;
+         remainder += stepRemainder;
+         if (remainder >= divisor) {
+            remainder -= divisor;
+            column++;
+         }
+         if (GGL_RECT_COPY == blend)
+            StorePixel<colorFormat>(blit->frameBuffer, pixel + x, texel);
+         else
+            StorePixel<colorFormat>(blit->frameBuffer, pixel + x, Blend<blend>(texel,
+                                    LoadPixel<colorFormat>(blit->frameBuffer, pixel + x)));
+      }
+   }
+}
+
+template<GGLPixelFormat textureFormat, GGLPixelFormat colorFormat>
+static void BlitRows(const GGLRectBlit * blit, const GGLRect * rect)
+{
+   switch (blit->blend) {
+   case GGL_RECT_COPY:
+      return BlitRows<textureFormat, colorFormat, GGL_RECT_COPY>(blit, rect);
+   case GGL_RECT_BLEND:
+      return BlitRows<textureFormat, colorFormat, GGL_RECT_BLEND>(blit, rect);
+   case GGL_RECT_BLEND | GGL_RECT_COLOR_SRC_ALPHA:
+      return BlitRows<textureFormat, colorFormat,
+             GGL_RECT_BLEND | GGL_RECT_COLOR_SRC_ALPHA>(blit, rect);
+   case GGL_RECT_BLEND | GGL_RECT_ALPHA_SRC_ALPHA:
+      return BlitRows<textureFormat, colorFormat,
+             GGL_RECT_BLEND | GGL_RECT_ALPHA_SRC_ALPHA>(blit, rect);
+   case GGL_RECT_BLEND | GGL_RECT_COLOR_SRC_ALPHA | GGL_RECT_ALPHA_SRC_ALPHA:
+      return BlitRows<textureFormat, colorFormat,
+             GGL_RECT_BLEND | GGL_RECT_COLOR_SRC_ALPHA | GGL_RECT_ALPHA_SRC_ALPHA>(blit, rect);
+   default:
+      assert(0);
+   }
+}
+
+template<GGLPixelFormat textureFormat>
+static void BlitRows(const GGLRectBlit * blit, const GGLRect * rect)
+{
+   if (GGL_PIXEL_FORMAT_RGBA_8888 == blit->colorFormat)
+      BlitRows<textureFormat, GGL_PIXEL_FORMAT_RGBA_8888>(blit, rect);
+   else
+      BlitRows<textureFormat, GGL_PIXEL_FORMAT_RGB_565>(blit, rect);
+}
+
+void BlitRect(const GGLRectBlit * blit, const GGLRect * rect)
+{
+   GGLRect clipped;
+   clipped.left = MAX2(rect->left, blit->clip.left);
+   clipped.top = MAX2(rect->top, blit->clip.top);
+   clipped.right = MIN2(rect->right, blit->clip.right);
+   clipped.bottom = MIN2(rect->bottom, blit->clip.bottom);
+   if (clipped.right < clipped.left || clipped.bottom < clipped.top)
+      return;
+
+   switch (blit->texture.format) {
+   case GGL_PIXEL_FORMAT_RGBA_8888:
+      return BlitRows<GGL_PIXEL_FORMAT_RGBA_8888>(blit, &clipped);
+   case GGL_PIXEL_FORMAT_RGBX_8888:
+      return BlitRows<GGL_PIXEL_FORMAT_RGBX_8888>(blit, &clipped);
+   case GGL_PIXEL_FORMAT_RGB_565:
+      return BlitRows<GGL_PIXEL_FORMAT_RGB_565>(blit, &clipped);
+   default:
+      assert(0);
+   }
+}
+
+// source color and alpha factors GL_ONE or GL_SRC_ALPHA, destination GL_ONE_MINUS_SRC_ALPHA
+static bool RectBlend(const GGLBlendState * blendState, const bool opaque, unsigned * blend)
+{
+   *blend = GGL_RECT_COPY;
+   if (!blendState->enable)
+      return true;
+   if (GGLBlendState::GGL_FUNC_ADD != blendState->ce || GGLBlendState::GGL_FUNC_ADD != blendState->ae)
+      return false;
+   if (GGLBlendState::GGL_ONE_MINUS_SRC_ALPHA != blendState->dcf ||
+         GGLBlendState::GGL_ONE_MINUS_SRC_ALPHA != blendState->daf)
+      return false;
+   if (GGLBlendState::GGL_ONE != blendState->scf && GGLBlendState::GGL_SRC_ALPHA != blendState->scf)
+      return false;
+   if (GGLBlendState::GGL_ONE != blendState->saf && GGLBlendState::GGL_SRC_ALPHA != blendState->saf)
+      return false;
+   if (opaque) // source alpha is 1, so blending keeps the source
+      return true;
+   *blend = GGL_RECT_BLEND;
+   if (GGLBlendState::GGL_SRC_ALPHA == blendState->scf)
+      *blend |= GGL_RECT_COLOR_SRC_ALPHA;
+   if (GGLBlendState::GGL_SRC_ALPHA == blendState->saf)
+      *blend |= GGL_RECT_ALPHA_SRC_ALPHA;
+   return true;
+}
+
+static GLboolean DrawRect(const GGLInterface * iface, const unsigned sampler,
+                          GLint x, GLint y, GLsizei width, GLsizei height,
+                          GLint u, GLint v, GLsizei cropWidth, GLsizei cropHeight)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   if (GGL_MAXCOMBINEDTEXTUREIMAGEUNITS <= sampler || width < 0 || height < 0 ||
+         cropWidth < 0 || cropHeight < 0) {
+      gglError(GL_INVALID_VALUE);
+      return GL_FALSE;
+   }
+
+   const GGLState & state = ctx->state;
+   const GGLTexture & texture = state.textureState.textures[sampler];
+   if (GL_TEXTURE_2D != texture.type || !texture.levels || !texture.width || !texture.height)
+      return GL_FALSE;
+   if (GGL_PIXEL_FORMAT_RGBA_8888 != texture.format &&
+         GGL_PIXEL_FORMAT_RGBX_8888 != texture.format && GGL_PIXEL_FORMAT_RGB_565 != texture.format)
+      return GL_FALSE;
+   if (GGL_PIXEL_FORMAT_RGBA_8888 != ctx->frameSurface.format &&
+         GGL_PIXEL_FORMAT_RGB_565 != ctx->frameSurface.format)
+      return GL_FALSE;
+   if (state.bufferState.depthTest || state.bufferState.stencilTest)
+      return GL_FALSE;
+   // GGL_LINEAR samples between texels unless each pixel center lands on a texel center
+   if ((cropWidth > width || cropHeight > height) && GGLTexture::GGL_LINEAR == texture.minFilter)
+      return GL_FALSE;
+   if ((cropWidth < width || cropHeight < height) && GGLTexture::GGL_LINEAR == texture.magFilter)
+      return GL_FALSE;
+
+   GGLRectBlit blit;
+   if (!RectBlend(&state.blendState, GGL_PIXEL_FORMAT_RGBA_8888 != texture.format, &blit.blend))
+      return GL_FALSE;
+   if (!width || !height || !cropWidth || !cropHeight || !ctx->frameSurface.data)
+      return GL_TRUE;
+
+   blit.texture = texture;
+   blit.colorFormat = ctx->frameSurface.format;
+   blit.frameBuffer = ctx->frameSurface.data;
+   blit.frameWidth = ctx->frameSurface.width;
+   blit.x = x;
+   blit.y = y;
+   blit.u = u;
+   blit.v = v;
+   blit.width = width;
+   blit.height = height;
+   blit.cropWidth = cropWidth;
+   blit.cropHeight = cropHeight;
+
+   ScissorRect(ctx, ctx->frameSurface.width, ctx->frameSurface.height, &blit.clip);
+   blit.clip.left = MAX2(blit.clip.left, x);
+   blit.clip.top = MAX2(blit.clip.top, y);
+   blit.clip.right = MIN2((long long)blit.clip.right, (long long)x + width - 1);
+   blit.clip.bottom = MIN2((long long)blit.clip.bottom, (long long)y + height - 1);
+   if (blit.clip.right < blit.clip.left || blit.clip.bottom < blit.clip.top)
+      return GL_TRUE;
+
+   if (ctx->deferred)
+      DeferRect(iface, &blit);
+   else
+      BlitRect(&blit, &blit.clip);
+   return GL_TRUE;
+}
+
+void InitializeRectFunctions(GGLInterface * iface)
+{
+   iface->DrawRect = DrawRect;
+}
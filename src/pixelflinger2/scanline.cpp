@@ -179,14 +179,12 @@ unsigned char StencilOp(const unsigned op, unsigned char s, const unsigned char
 #ifdef USE_LLVM_SCANLINE
 typedef void (* ScanLineFunction_t)(VertexOutput * start, VertexOutput * step,
                                     const float (*constants)[4], void * frame,
-                                    int * depth, unsigned char * stencil,
+                                    void * depth, unsigned char * stencil,
                                     GGLActiveStencil *, unsigned count);
 #endif
 
-void GGLScanLine(const gl_shader_program * program, const GGLPixelFormat colorFormat,
-                 void * frameBuffer, int * depthBuffer, unsigned char * stencilBuffer,
-                 unsigned bufferWidth, unsigned bufferHeight, GGLActiveStencil * activeStencil,
-                 const VertexOutput_t * start, const VertexOutput_t * end, const float (*constants)[4])
+void ScanLineSpan(const GGLScanLineTarget * target, GGLActiveStencil * activeStencil,
+                  const unsigned y, const VertexOutput * start, const VertexOutput * end)
 {
 #if !USE_LLVM_SCANLINE
    assert(!"only for USE_LLVM_SCANLINE");
@@ -195,14 +193,15 @@ void GGLScanLine(const gl_shader_program * program, const GGLPixelFormat colorFo
 //   ALOGD("pf2: GGLScanLine program=%p format=0x%.2X frameBuffer=%p depthBuffer=%p stencilBuffer=%p ",
 //      program, colorFormat, frameBuffer, depthBuffer, stencilBuffer);
 
-   const unsigned int varyingCount = program->VaryingSlots;
-   const unsigned y = start->position.y, startX = start->position.x,
-                      endX = end->position.x;
+   const GGLPixelFormat colorFormat = target->colorFormat;
+   const unsigned bufferWidth = target->width, bufferHeight = target->height;
+   const unsigned int varyingCount = target->varyingCount;
+   const unsigned startX = start->position.x, endX = end->position.x;
 
    assert(bufferWidth > startX && bufferWidth > endX);
    assert(bufferHeight > y);
 
-   char * frame = (char *)frameBuffer;
+   char * frame = (char *)target->frameBuffer;
    if (GGL_PIXEL_FORMAT_RGBA_8888 == colorFormat)
       frame += (y * bufferWidth + startX) * 4;
    else if (GGL_PIXEL_FORMAT_RGB_565 == colorFormat)
@@ -214,8 +213,9 @@ void GGLScanLine(const gl_shader_program * program, const GGLPixelFormat colorFo
    //memcpy(ctx->glCtx->CurrentProgram->ValuesVertexOutput, start, sizeof(*start));
    // shader symbols are mapped to gl_shader_program_Values*
    //VertexOutput & vertex(*(VertexOutput*)ctx->glCtx->CurrentProgram->ValuesVertexOutput);
-   VertexOutput vertex(*start);
-   VertexOutput vertexDx(*end);
+   VertexOutput vertex, vertexDx;
+   CopyVertexOutput(&vertex, start, varyingCount);
+   CopyVertexOutput(&vertexDx, end, varyingCount);
 
    vertexDx.position -= start->position;
    vertexDx.position *= div;
@@ -228,28 +228,61 @@ void GGLScanLine(const gl_shader_program * program, const GGLPixelFormat colorFo
    vertexDx.frontFacingPointCoord *= div; // gl_PointCoord, only zw
    vertexDx.frontFacingPointCoord.y = 0; // gl_FrontFacing not interpolated
 
-   int * depth = depthBuffer + y * bufferWidth + startX;
-   unsigned char * stencil = stencilBuffer + y * bufferWidth + startX;
+   char * depth = (char *)target->depthBuffer;
+   unsigned char * stencil = target->stencilBuffer + y * bufferWidth + startX;
+   if (GGL_PIXEL_FORMAT_Z_16 == target->depthFormat)
+      depth += (y * bufferWidth + startX) * 2;
+   else // Z_32 and SZ_24, scanline reads stencil from depth for SZ_24
+      depth += (y * bufferWidth + startX) * 4;
 
    // TODO DXL consider inverting gl_FragCoord.y
-   ScanLineFunction_t scanLineFunction = (ScanLineFunction_t)
-                                         program->_LinkedShaders[MESA_SHADER_FRAGMENT]->function;
+   ScanLineFunction_t scanLineFunction = (ScanLineFunction_t)target->function;
 //   ALOGD("pf2 GGLScanLine scanline=%p start=%p constants=%p", scanLineFunction, &vertex, constants);
    if (endX >= startX)
-      scanLineFunction(&vertex, &vertexDx, constants, frame, depth, stencil, activeStencil, endX - startX + 1);
+      scanLineFunction(&vertex, &vertexDx, target->constants, frame, depth, stencil, activeStencil, endX - startX + 1);
 
 //   ALOGD("pf2: GGLScanLine end");
 
 }
 
+void GGLScanLine(const gl_shader_program * program, const GGLPixelFormat colorFormat,
+                 void * frameBuffer, int * depthBuffer, unsigned char * stencilBuffer,
+                 unsigned bufferWidth, unsigned bufferHeight, GGLActiveStencil * activeStencil,
+                 const VertexOutput_t * start, const VertexOutput_t * end, const float (*constants)[4])
+{
+   GGLScanLineTarget target;
+   target.function = program->_LinkedShaders[MESA_SHADER_FRAGMENT]->function;
+   target.varyingCount = program->VaryingSlots;
+   target.varyingFlat = program->VaryingFlat;
+   target.constants = constants;
+   target.colorFormat = colorFormat;
+   target.depthFormat = GGL_PIXEL_FORMAT_Z_32;
+   target.frameBuffer = frameBuffer;
+   target.depthBuffer = depthBuffer;
+   target.stencilBuffer = stencilBuffer;
+   target.width = bufferWidth;
+   target.height = bufferHeight;
+   ScanLineSpan(&target, activeStencil, start->position.y, start, end);
+}
+
 template <bool StencilTest, bool DepthTest, bool DepthWrite, bool BlendEnable>
 void ScanLine(const GGLInterface * iface, const VertexOutput * start, const VertexOutput * end)
 {
    GGL_GET_CONST_CONTEXT(ctx, iface);
-   GGLScanLine(ctx->CurrentProgram, ctx->frameSurface.format, ctx->frameSurface.data,
-               (int *)ctx->depthSurface.data, (unsigned char *)ctx->stencilSurface.data,
-               ctx->frameSurface.width, ctx->frameSurface.height, &ctx->activeStencil,
-               start, end, ctx->CurrentProgram->ValuesUniform);
+   const gl_shader_program * program = ctx->CurrentProgram;
+   GGLScanLineTarget target;
+   target.function = program->_LinkedShaders[MESA_SHADER_FRAGMENT]->function;
+   target.varyingCount = program->VaryingSlots;
+   target.varyingFlat = program->VaryingFlat;
+   target.constants = program->ValuesUniform;
+   target.colorFormat = ctx->frameSurface.format;
+   target.depthFormat = ctx->depthSurface.format;
+   target.frameBuffer = ctx->frameSurface.data;
+   target.depthBuffer = ctx->depthSurface.data;
+   target.stencilBuffer = (unsigned char *)ctx->stencilSurface.data;
+   target.width = ctx->frameSurface.width;
+   target.height = ctx->frameSurface.height;
+   ScanLineSpan(&target, &ctx->activeStencil, start->position.y, start, end);
 //   GGL_GET_CONST_CONTEXT(ctx, iface);
 //   //    assert((unsigned)start->position.y == (unsigned)end->position.y);
 //   //
@@ -16,8 +16,11 @@
 #include "src/pixelflinger2/pixelflinger2.h"
 
 #include <assert.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <map>
 
 #include <llvm/LLVMContext.h>
@@ -42,6 +45,7 @@
 #include "src/glsl/glsl_types.h"
 #include "src/glsl/ir_to_llvm.h"
 #include "src/glsl/ir_print_visitor.h"
+#include "src/glsl/ir_serialize.h"
 
 //#undef ALOGD
 //#define ALOGD(...)
@@ -110,6 +114,7 @@ struct ShaderKey {
    } scanLineKey;
    GGLPixelFormat textureFormats[GGL_MAXCOMBINEDTEXTUREIMAGEUNITS];
    unsigned char textureParameters[GGL_MAXCOMBINEDTEXTUREIMAGEUNITS]; // wrap and filter
+   unsigned char reducedPrecision;
    bool operator <(const ShaderKey & rhs) const {
       return memcmp(this, &rhs, sizeof(*this)) < 0;
    }
@@ -130,9 +135,41 @@ struct Executable { // codegen info
    std::map<ShaderKey, Instance *> instances;
 };
 
+// process wide, read with GGLShaderGetStatistics; each context has its own bcc context
+// and may JIT on its own thread, so updated and read under statisticsLock
+static GGLShaderStatistics statistics;
+static pthread_mutex_t statisticsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void AddStatistics(const GGLShaderStatistics & add)
+{
+   pthread_mutex_lock(&statisticsLock);
+   statistics.jitCount += add.jitCount;
+   statistics.cacheHits += add.cacheHits;
+   statistics.jitSeconds += add.jitSeconds;
+   statistics.llvmSeconds += add.llvmSeconds;
+   pthread_mutex_unlock(&statisticsLock);
+}
+
+static double ElapsedSeconds(const timespec & start)
+{
+   timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void GGLShaderGetStatistics(GGLShaderStatistics_t * stats, GLboolean reset)
+{
+   pthread_mutex_lock(&statisticsLock);
+   *stats = statistics;
+   if (reset)
+      memset(&statistics, 0, sizeof(statistics));
+   pthread_mutex_unlock(&statisticsLock);
+}
+
 bool do_mat_op_to_vec(exec_list *instructions);
 
 extern void link_shaders(const struct gl_context *ctx, struct gl_shader_program *prog);
+extern bool link_allocate_values(struct gl_shader_program *prog);
 
 extern "C" void compile_shader(const struct gl_context *ctx, struct gl_shader *shader);
 
@@ -284,11 +321,277 @@ GLboolean GGLShaderProgramLink(gl_shader_program * program, const char ** infoLo
    return program->LinkStatus;
 }
 
-static GLboolean ShaderProgramLink(gl_shader_program * program, const char ** infoLog)
+static GLboolean ShaderProgramLink(GGLInterface * iface, gl_shader_program * program,
+                                   const char ** infoLog)
 {
+   iface->Finish(iface); // relinking frees the JIT functions recorded triangles may use
+   VertexCacheRemoveProgram(iface, program);
    return GGLShaderProgramLink(program, infoLog);
 }
 
+// program binary layout: magic, version, VertexInput/VertexOutput sizes (varying and
+// attribute locations index into them), program state, then each linked shader's IR
+static const char PROGRAM_BINARY_MAGIC[4] = {'G', 'G', 'L', 'B'};
+// 2: packed varyings (location_frac), 3: VaryingFlat, 4: varyings after frontFacingPointCoord
+static const unsigned PROGRAM_BINARY_VERSION = 4;
+
+static void WriteParameters(ir_blob_writer * blob, const gl_program_parameter_list * list)
+{
+   blob->write_uint(list->NumParameters);
+   for (unsigned i = 0; i < list->NumParameters; i++) {
+      const gl_program_parameter & param = list->Parameters[i];
+      blob->write_string(param.Name);
+      blob->write_uint(param.Slots);
+      blob->write_int(param.BindLocation);
+      blob->write_int(param.Location);
+   }
+}
+
+// -1 for unassigned, else slots starting at location must fit in limit vec4 slots
+static bool ValidLocation(const int location, const unsigned slots, const unsigned limit)
+{
+   return -1 == location || (location >= 0 && slots <= limit && (unsigned)location <= limit - slots);
+}
+
+// Location (and BindLocation if checkBind) index into limit vec4 slots of VertexInput or
+// VertexOutput; attribute BindLocation is only what the application asked for
+static bool ReadParameters(ir_blob_reader * blob, gl_program_parameter_list * list,
+                           const unsigned limit, const bool checkBind)
+{
+   const unsigned count = blob->read_uint();
+   list->NumParameters = 0;
+   if (count > blob->remaining())
+      return false;
+   for (unsigned i = 0; i < count && !blob->failed; i++) {
+      const char * name = blob->read_string();
+      if (!name)
+         return false;
+      const int index = _mesa_add_parameter(list, name); // may realloc Parameters
+      gl_program_parameter & param = list->Parameters[index];
+      param.Slots = blob->read_uint();
+      param.BindLocation = blob->read_int();
+      param.Location = blob->read_int();
+      const unsigned slots = MAX2(param.Slots, 1u);
+      if (!ValidLocation(param.Location, slots, limit) ||
+            (checkBind && !ValidLocation(param.BindLocation, slots, limit)))
+         return false;
+   }
+   return !blob->failed;
+}
+
+// vec4 slots the linker allocates for a variable of type, saturated at UINT_MAX
+static unsigned TypeSlots(const glsl_type * type)
+{
+   if (type->is_array()) {
+      const unsigned element = TypeSlots(type->fields.array);
+      return element && type->length > UINT_MAX / element ? UINT_MAX : type->length * element;
+   }
+   if (type->is_record()) {
+      unsigned slots = 0;
+      for (unsigned i = 0; i < type->length; i++)
+         slots = MIN2(slots + (unsigned long long)TypeSlots(type->fields.structure[i].type),
+                      (unsigned long long)UINT_MAX);
+      return slots;
+   }
+   if (type->is_sampler())
+      return 1;
+   return type->matrix_columns;
+}
+
+static bool IsSamplerUniform(const glsl_type * type)
+{
+   return type->is_sampler() || (type->is_array() && type->fields.array->is_sampler());
+}
+
+// locations of uniforms, attributes and varyings in the IR are used as is by the JIT
+static bool ValidVariableLocations(const gl_shader_program * program, const gl_shader * shader)
+{
+   const unsigned outputSlots = sizeof(VertexOutput) / sizeof(Vector4);
+   foreach_list(node, shader->ir) {
+      const ir_variable * var = ((ir_instruction *)node)->as_variable();
+      if (!var || ir_var_auto == var->mode || ir_var_temporary == var->mode)
+         continue;
+      const unsigned slots = TypeSlots(var->type);
+      unsigned limit = outputSlots;
+      if (ir_var_uniform == var->mode)
+         limit = IsSamplerUniform(var->type) ? program->Uniforms->SamplerSlots :
+                 program->Uniforms->Slots;
+      else if (ir_var_in == var->mode && GL_VERTEX_SHADER == shader->Type)
+         limit = GGL_MAXVERTEXATTRIBS;
+      if (!ValidLocation(var->location, slots, limit) ||
+            var->location_frac + var->type->vector_elements > 4)
+         return false;
+   }
+   return true;
+}
+
+GLboolean GGLShaderProgramGetBinary(const gl_shader_program_t * program, GLsizei bufSize,
+                                    GLsizei * length, void * binary)
+{
+   if (length)
+      *length = 0;
+   if (!program->LinkStatus)
+      return GL_FALSE;
+
+   void * mem_ctx = hieralloc_new(NULL);
+   ir_blob_writer blob(mem_ctx);
+   blob.write_bytes(PROGRAM_BINARY_MAGIC, sizeof(PROGRAM_BINARY_MAGIC));
+   blob.write_uint(PROGRAM_BINARY_VERSION);
+   blob.write_uint(sizeof(VertexInput));
+   blob.write_uint(sizeof(VertexOutput));
+
+   blob.write_uint(program->Version);
+   blob.write_uint(program->AttributeSlots);
+   blob.write_uint(program->VaryingSlots);
+   blob.write_uint(program->VaryingFlat);
+   blob.write_uint(program->UsesFragCoord | program->UsesPointCoord << 1);
+   WriteParameters(&blob, program->Attributes);
+   WriteParameters(&blob, program->Varying);
+
+   const gl_uniform_list * uniforms = program->Uniforms;
+   blob.write_uint(uniforms->NumUniforms);
+   blob.write_uint(uniforms->Slots);
+   blob.write_uint(uniforms->SamplerSlots);
+   for (unsigned i = 0; i < uniforms->NumUniforms; i++) {
+      blob.write_string(uniforms->Uniforms[i].Name);
+      blob.write_int(uniforms->Uniforms[i].Pos);
+      blob.write_type(uniforms->Uniforms[i].Type);
+   }
+
+   bool serialized = true;
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+      const gl_shader * shader = program->_LinkedShaders[i];
+      blob.write_uint(shader != NULL);
+      if (!shader)
+         continue;
+      blob.write_uint(shader->Type);
+      blob.write_uint(shader->Version);
+      blob.write_uint(shader->SamplersUsed);
+      serialized = ir_serialize(&blob, shader->ir) && serialized;
+   }
+
+   GLboolean result = GL_FALSE;
+   if (serialized && !blob.failed && (!binary || blob.size <= (unsigned)bufSize)) {
+      if (binary)
+         memcpy(binary, blob.data, blob.size);
+      if (length)
+         *length = blob.size;
+      result = GL_TRUE;
+   }
+   hieralloc_free(mem_ctx);
+   return result;
+}
+
+static GLboolean ReadProgramBinary(gl_shader_program_t * program, ir_blob_reader * blob)
+{
+   char magic[sizeof(PROGRAM_BINARY_MAGIC)];
+   blob->read_bytes(magic, sizeof(magic));
+   if (memcmp(magic, PROGRAM_BINARY_MAGIC, sizeof(magic)) ||
+         blob->read_uint() != PROGRAM_BINARY_VERSION ||
+         blob->read_uint() != sizeof(VertexInput) ||
+         blob->read_uint() != sizeof(VertexOutput))
+      return GL_FALSE;
+
+   program->Version = blob->read_uint();
+   program->AttributeSlots = blob->read_uint();
+   program->VaryingSlots = blob->read_uint();
+   program->VaryingFlat = blob->read_uint();
+   const unsigned flags = blob->read_uint();
+   program->UsesFragCoord = flags & 1;
+   program->UsesPointCoord = (flags >> 1) & 1;
+   if (program->AttributeSlots > GGL_MAXVERTEXATTRIBS ||
+         program->VaryingSlots > GGL_MAXVARYINGVECTORS ||
+         program->VaryingFlat >> program->VaryingSlots)
+      return GL_FALSE;
+   const unsigned outputSlots = sizeof(VertexOutput) / sizeof(Vector4);
+   if (!ReadParameters(blob, program->Attributes, GGL_MAXVERTEXATTRIBS, false) ||
+         !ReadParameters(blob, program->Varying, outputSlots, true))
+      return GL_FALSE;
+
+   gl_uniform_list * uniforms = hieralloc_zero(program, gl_uniform_list);
+   if (program->Uniforms)
+      hieralloc_free(program->Uniforms);
+   program->Uniforms = uniforms;
+   const unsigned count = blob->read_uint();
+   if (count > blob->remaining())
+      return GL_FALSE;
+   uniforms->Slots = blob->read_uint();
+   uniforms->SamplerSlots = blob->read_uint();
+   // link_allocate_values sizes ValuesUniform from these, and sampler Pos index sampler2tmu
+   if (uniforms->Slots > GGL_MAXVERTEXUNIFORMVECTORS + GGL_MAXFRAGMENTUNIFORMVECTORS ||
+         uniforms->SamplerSlots > GGL_MAXCOMBINEDTEXTUREIMAGEUNITS)
+      return GL_FALSE;
+   uniforms->Uniforms = (gl_uniform *)hieralloc_zero_size(uniforms, count * sizeof(gl_uniform));
+   if (count && !uniforms->Uniforms)
+      return GL_FALSE;
+   uniforms->Size = uniforms->NumUniforms = count;
+   for (unsigned i = 0; i < count && !blob->failed; i++) {
+      const char * name = blob->read_string();
+      if (!name)
+         return GL_FALSE;
+      gl_uniform & uniform = uniforms->Uniforms[i];
+      uniform.Name = hieralloc_strdup(uniforms, name);
+      uniform.Pos = blob->read_int();
+      uniform.Type = blob->read_type();
+      if (blob->failed || uniform.Type->is_record() || uniform.Pos < 0 ||
+            !ValidLocation(uniform.Pos, TypeSlots(uniform.Type), IsSamplerUniform(uniform.Type) ?
+                           uniforms->SamplerSlots : uniforms->Slots))
+         return GL_FALSE;
+   }
+
+   for (unsigned i = 0; i < MESA_SHADER_TYPES && !blob->failed; i++) {
+      if (!blob->read_uint())
+         continue;
+      const GLenum type = blob->read_uint();
+      if ((MESA_SHADER_VERTEX == i && GL_VERTEX_SHADER != type) ||
+            (MESA_SHADER_FRAGMENT == i && GL_FRAGMENT_SHADER != type) ||
+            (MESA_SHADER_VERTEX != i && MESA_SHADER_FRAGMENT != i))
+         return GL_FALSE;
+      gl_shader * shader = _mesa_new_shader(program, 0, type);
+      program->_LinkedShaders[i] = shader;
+      shader->Version = blob->read_uint();
+      shader->SamplersUsed = blob->read_uint();
+      shader->ir = new(shader) exec_list;
+      if (!ir_deserialize(blob, shader, shader->ir) || !ir_tree_is_valid(shader->ir) ||
+            !ValidVariableLocations(program, shader) ||
+            shader->SamplersUsed >> program->Uniforms->SamplerSlots)
+         return GL_FALSE;
+   }
+   return !blob->failed && !blob->remaining();
+}
+
+GLboolean GGLShaderProgramBinary(gl_shader_program_t * program, const void * binary,
+                                 GLsizei length)
+{
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+      GGLShaderDelete(program->_LinkedShaders[i]);
+      program->_LinkedShaders[i] = NULL;
+   }
+   program->LinkStatus = GL_FALSE;
+
+   ir_blob_reader blob(binary, length > 0 ? length : 0);
+   if (!ReadProgramBinary(program, &blob) || !link_allocate_values(program)) {
+      for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+         GGLShaderDelete(program->_LinkedShaders[i]);
+         program->_LinkedShaders[i] = NULL;
+      }
+      program->InfoLog = hieralloc_strdup(program, "error: invalid program binary\n");
+      return GL_FALSE;
+   }
+
+   program->InfoLog = hieralloc_strdup(program, "");
+   program->LinkStatus = GL_TRUE;
+   return GL_TRUE;
+}
+
+static GLboolean ShaderProgramBinary(GGLInterface * iface, gl_shader_program * program,
+                                     const void * binary, GLsizei length)
+{
+   iface->Finish(iface); // loading frees the JIT functions recorded triangles may use
+   VertexCacheRemoveProgram(iface, program);
+   return GGLShaderProgramBinary(program, binary, length);
+}
+
 static void GetShaderKey(const GGLState * ctx, const gl_shader * shader, ShaderKey * key)
 {
    memset(key, 0, sizeof(*key));
@@ -298,6 +601,7 @@ static void GetShaderKey(const GGLState * ctx, const gl_shader * shader, ShaderK
       key->scanLineKey.bufferState = ctx->bufferState;
       key->scanLineKey.blendState = ctx->blendState;
    }
+   key->reducedPrecision = ctx->reducedPrecision;
 
    for (unsigned i = 0; i < GGL_MAXCOMBINEDTEXTUREIMAGEUNITS; i++)
       if (shader->SamplersUsed & (1 << i)) {
@@ -319,7 +623,7 @@ static inline char HexDigit(unsigned char d)
    return (d > 9 ? d + 'A' - 10 : d + '0');
 }
 
-static const unsigned SHADER_KEY_STRING_LEN = GGL_MAXCOMBINEDTEXTUREIMAGEUNITS * 4 + 2;
+static const unsigned SHADER_KEY_STRING_LEN = GGL_MAXCOMBINEDTEXTUREIMAGEUNITS * 4 + 3;
 
 static void GetShaderKeyString(const GLenum type, const ShaderKey * key,
                                char * buffer, const unsigned bufferSize)
@@ -340,6 +644,7 @@ static void GetShaderKeyString(const GLenum type, const ShaderKey * key,
       *str++ = HexDigit(key->textureParameters[i] / 16);
       *str++ = HexDigit(key->textureParameters[i] % 16);
    }
+   *str++ = HexDigit(key->reducedPrecision);
    *str++ = '\0';
 }
 
@@ -444,6 +749,7 @@ void GenerateScanLine(const GGLState * gglCtx, const gl_shader_program * program
 void GGLShaderUse(void * bccCtx, const GGLState * gglState, gl_shader_program * program)
 {
 //   ALOGD("%s", program->Shaders[MESA_SHADER_FRAGMENT]->Source);
+   GGLShaderStatistics used = {0}; // added to statistics once all stages are done
    for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
       if (!program->_LinkedShaders[i])
          continue;
@@ -460,6 +766,8 @@ void GGLShaderUse(void * bccCtx, const GGLState * gglState, gl_shader_program *
       bcc::BCCContext * compilerCtx = reinterpret_cast<bcc::BCCContext *>(bccCtx);
       if (!instance) {
 //         puts("begin jit new shader");
+         timespec jitStart;
+         clock_gettime(CLOCK_MONOTONIC, &jitStart);
          instance = hieralloc_zero(shader->executable, Instance);
 
          llvm::Module * module = new llvm::Module("glsl", compilerCtx->getLLVMContext());
@@ -495,6 +803,7 @@ void GGLShaderUse(void * bccCtx, const GGLState * gglState, gl_shader_program *
             assert(0);
             delete module;
          }
+         used.llvmSeconds += ElapsedSeconds(jitStart);
          bcc::Source * source = bcc::Source::CreateFromModule(*compilerCtx, *module);
          if (!source) {
             delete module;
@@ -552,20 +861,26 @@ void GGLShaderUse(void * bccCtx, const GGLState * gglState, gl_shader_program *
          if (GL_FRAGMENT_SHADER == shader->Type) {
             char scanlineName [SCANLINE_KEY_STRING_LEN] = {0};
             GetScanlineKeyString(&shaderKey, scanlineName, sizeof scanlineName / sizeof *scanlineName);
+            timespec scanlineStart;
+            clock_gettime(CLOCK_MONOTONIC, &scanlineStart);
             GenerateScanLine(gglState, program, module, mainName, scanlineName);
+            used.llvmSeconds += ElapsedSeconds(scanlineStart);
             CodeGen(instance, scanlineName, shader, program, gglState);
          } else
 #endif
             CodeGen(instance, mainName, shader, program, gglState);
 
          shader->executable->instances[shaderKey] = instance;
+         used.jitCount++;
+         used.jitSeconds += ElapsedSeconds(jitStart);
 //         debug_printf("jit new shader '%s'(%p) \n", mainName, instance->function);
       } else
 //         debug_printf("use cached shader %p \n", instance->function);
-         ;
+         used.cacheHits++;
 
       shader->function  = instance->function;
    }
+   AddStatistics(used);
 //   puts("pf2: GGLShaderUse end");
 
 //   assert(0);
@@ -637,6 +952,8 @@ void GGLShaderProgramDelete(gl_shader_program * program)
 static void ShaderProgramDelete(GGLInterface * iface, gl_shader_program * program)
 {
    GGL_GET_CONTEXT(ctx, iface);
+   iface->Finish(iface); // recorded triangles may use its JIT functions
+   VertexCacheRemoveProgram(iface, program);
    if (ctx->CurrentProgram == program) {
       ctx->CurrentProgram = NULL;
       SetShaderVerifyFunctions(iface);
@@ -822,6 +1139,7 @@ GLint GGLShaderUniform(gl_shader_program * program, GLint location, GLsizei coun
       start = uniform.Pos + program->Uniforms->Slots;
       assert(GL_INT == type && 1 == count);
       program->ValuesUniform[start][0] = *(float *)values;
+      program->UniformGeneration++;
       return uniform.Pos;
    }
    else if (uniform.Type->is_array() && uniform.Type->fields.array->is_sampler()) {
@@ -864,6 +1182,7 @@ GLint GGLShaderUniform(gl_shader_program * program, GLint location, GLsizei coun
       assert(0);
    for (int i = 0; i < slots; i++)
       memcpy(program->ValuesUniform + start + i, values, elems * sizeof(float));
+   program->UniformGeneration++;
 //   ALOGD("pf2: GGLShaderUniform copied");
    return -2;
 }
@@ -885,6 +1204,7 @@ void GGLShaderUniformMatrix(gl_shader_program * program, GLint cols, GLint rows,
       for (unsigned j = 0; j < rows; j++)
          column[j] = values[i * 4 + j];
    }
+   program->UniformGeneration++;
 
 //   if (!strstr(program->Shaders[MESA_SHADER_FRAGMENT]->Source,
 //               "gl_FragColor = color * texture2D(sampler, outTexCoords).a;"))
@@ -920,6 +1240,17 @@ static void ShaderVerifyDrawTriangle(const GGLInterface * iface, const VertexInp
    }
 }
 
+static void ShaderVerifyDrawTriangles(const GGLInterface * iface, const VertexInput * vertices,
+                                      unsigned count, unsigned cacheKey)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   if (ctx->CurrentProgram) {
+      ShaderUse(const_cast<GGLInterface *>(iface), ctx->CurrentProgram);
+      if (ShaderVerifyDrawTriangles != iface->DrawTriangles)
+         iface->DrawTriangles(iface, vertices, count, cacheKey);
+   }
+}
+
 static void ShaderVerifyRasterTriangle(const GGLInterface * iface, const VertexOutput * v1,
                                        const VertexOutput * v2, const VertexOutput * v3)
 {
@@ -959,6 +1290,7 @@ void SetShaderVerifyFunctions(struct GGLInterface * iface)
 {
    iface->ProcessVertex = ShaderVerifyProcessVertex;
    iface->DrawTriangle = ShaderVerifyDrawTriangle;
+   iface->DrawTriangles = ShaderVerifyDrawTriangles;
    iface->RasterTriangle = ShaderVerifyRasterTriangle;
    iface->RasterTrapezoid = ShaderVerifyRasterTrapezoid;
    iface->ScanLine = ShaderVerifyScanLine;
@@ -979,6 +1311,8 @@ void InitializeShaderFunctions(struct GGLInterface * iface)
    iface->ShaderAttach = ShaderAttach;
    iface->ShaderDetach = ShaderDetach;
    iface->ShaderProgramLink = ShaderProgramLink;
+   iface->ShaderProgramGetBinary = GGLShaderProgramGetBinary;
+   iface->ShaderProgramBinary = ShaderProgramBinary;
    iface->ShaderUse = ShaderUse;
    iface->ShaderProgramDelete = ShaderProgramDelete;
    iface->ShaderGetiv = GGLShaderGetiv;
@@ -390,6 +390,8 @@ static void SetSampler(GGLInterface * iface, const unsigned sampler, GGLTexture
 {
     assert(GGL_MAXCOMBINEDTEXTUREIMAGEUNITS > sampler);
     GGL_GET_CONTEXT(ctx, iface);
+    // JIT texture sampler reads textureData and textureDimensions from state when it runs
+    iface->Finish(iface);
     if (!texture)
         SetShaderVerifyFunctions(iface);
     else if (ctx->state.textureState.textures[sampler].format != texture->format)
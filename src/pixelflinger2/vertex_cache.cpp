@@ -0,0 +1,150 @@
+/**
+ **
+ ** Copyright 2011, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+// Vertex shader output cache: UI and static scenes draw the same vertices with the same
+// uniforms every frame. DrawTriangles keeps the outputs of vertices drawn with a cache key
+// and reuses them while the vertices, program, its vertex shader code and its uniform
+// generation match, so only triangle setup and rasterization are redone. Textures sampled
+// by the vertex shader are not tracked.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+#include "pixelflinger2.h"
+#include "src/mesa/main/mtypes.h"
+
+static const unsigned MAX_CACHED_VERTICES = 16384; // all entries are dropped when exceeded
+
+struct CachedVertices {
+   const VertexInput * vertices; // caller's vertex buffer
+   unsigned count;
+   const gl_shader_program * program;
+   void (* function)(); // vertex shader the outputs came from
+   unsigned uniformGeneration; // of program when the outputs were made
+   // GGLProcessVertex JIT code stores with aligned vector stores, so not std::vector;
+   // only copied while still empty, when std::map inserts it
+   VertexOutput * outputs;
+
+   CachedVertices() : outputs(NULL) {}
+   ~CachedVertices() {
+      free(outputs);
+   }
+};
+
+struct GGLVertexCache {
+   std::map<unsigned, CachedVertices> entries; // by cache key
+   unsigned vertexCount; // in all entries
+
+   GGLVertexCache() : vertexCount(0) {}
+};
+
+// outputs of vertices for the current program, from cache or run and stored under key
+static const VertexOutput * CachedOutputs(GGLVertexCache * cache, const gl_shader_program * program,
+                                          const VertexInput * vertices, const unsigned count,
+                                          const unsigned key)
+{
+   void (* const function)() = program->_LinkedShaders[MESA_SHADER_VERTEX]->function;
+   std::map<unsigned, CachedVertices>::iterator it = cache->entries.find(key);
+   if (it != cache->entries.end()) {
+      CachedVertices & entry = it->second;
+      if (entry.vertices == vertices && entry.count == count && entry.program == program &&
+            entry.function == function && entry.uniformGeneration == program->UniformGeneration)
+         return entry.outputs;
+      cache->vertexCount -= entry.count;
+      cache->entries.erase(it);
+   }
+
+   if (count > MAX_CACHED_VERTICES)
+      return NULL;
+   if (cache->vertexCount + count > MAX_CACHED_VERTICES) {
+      cache->entries.clear();
+      cache->vertexCount = 0;
+   }
+
+   void * outputs = NULL;
+   if (posix_memalign(&outputs, 16, count * sizeof(VertexOutput)))
+      return NULL;
+   CachedVertices & entry = cache->entries[key];
+   entry.outputs = (VertexOutput *)outputs;
+   entry.vertices = vertices;
+   entry.count = count;
+   entry.program = program;
+   entry.function = function;
+   entry.uniformGeneration = program->UniformGeneration;
+   memset(entry.outputs, 0, count * sizeof(VertexOutput));
+   for (unsigned i = 0; i < count; i++)
+      GGLProcessVertex(program, vertices + i, entry.outputs + i, program->ValuesUniform);
+   cache->vertexCount += count;
+   return entry.outputs;
+}
+
+void DrawTriangles(const GGLInterface * iface, const VertexInput * vertices,
+                   unsigned count, unsigned cacheKey)
+{
+   GGL_GET_CONST_CONTEXT(ctx, iface);
+   count -= count % 3;
+   if (!count)
+      return;
+
+   const VertexOutput * outputs = NULL;
+   if (ctx->vertexCache && cacheKey)
+      outputs = CachedOutputs(ctx->vertexCache, ctx->CurrentProgram, vertices, count, cacheKey);
+
+   const unsigned varyingCount = ctx->CurrentProgram->VaryingSlots;
+   VertexOutput vouts[3];
+   for (unsigned i = 0; i < count; i += 3) {
+      for (unsigned j = 0; j < 3; j++)
+         if (outputs) // SetupTriangle modifies them
+            CopyVertexOutput(vouts + j, outputs + i + j, varyingCount);
+         else {
+            memset(vouts + j, 0, VertexOutputVectors(varyingCount) * sizeof(Vector4));
+            iface->ProcessVertex(iface, vertices + i + j, vouts + j);
+         }
+      SetupTriangle(iface, vouts + 0, vouts + 1, vouts + 2);
+   }
+}
+
+void VertexCacheRemoveProgram(GGLInterface * iface, const gl_shader_program * program)
+{
+   GGL_GET_CONTEXT(ctx, iface);
+   GGLVertexCache * cache = ctx->vertexCache;
+   if (!cache)
+      return;
+   // a later program may be allocated at the same address
+   std::map<unsigned, CachedVertices>::iterator it = cache->entries.begin();
+   while (it != cache->entries.end())
+      if (it->second.program == program) {
+         cache->vertexCount -= it->second.count;
+         cache->entries.erase(it++);
+      } else
+         ++it;
+}
+
+void SetVertexCache(GGLInterface * iface, bool enable)
+{
+   GGL_GET_CONTEXT(ctx, iface);
+   if (enable == (NULL != ctx->vertexCache))
+      return;
+   if (enable)
+      ctx->vertexCache = new GGLVertexCache();
+   else {
+      delete ctx->vertexCache;
+      ctx->vertexCache = NULL;
+   }
+}
@@ -33,6 +33,17 @@ static hieralloc_header_t hieralloc_global_header = {BEGIN_MAGIC(), 0, 0, 0, 0,
 static std::set<void *> allocations;
 #endif
 
+// payload bytes of all live allocations, and the high water mark of it
+static unsigned long hieralloc_current_bytes, hieralloc_peak_bytes;
+
+static inline void account_bytes(unsigned added, unsigned removed)
+{
+   hieralloc_current_bytes += added;
+   hieralloc_current_bytes -= removed;
+   if (hieralloc_current_bytes > hieralloc_peak_bytes)
+      hieralloc_peak_bytes = hieralloc_current_bytes;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -155,6 +166,7 @@ void * hieralloc_allocate(const void * context, unsigned size, const char * name
 	ptr->refCount = 1;
    ptr->destructor = NULL;
 	ptr->endMagic = END_MAGIC(ptr);
+   account_bytes(size, 0);
 
 	hieralloc_header_t * parent = NULL;
 	if (!context)
@@ -190,8 +202,10 @@ void * hieralloc_reallocate(const void * context, void * ptr, unsigned size, con
 		add_to_parent(parent, header);
 	}
 
+	const unsigned old_size = header->size;
 	header = (hieralloc_header_t *)realloc(header, size + sizeof(hieralloc_header_t));
 	assert(header);
+	account_bytes(size, old_size);
 	header->size = size;
 	header->name = name;
 	if (ptr == (header + 1))
@@ -262,6 +276,7 @@ int hieralloc_free(void * ptr)
    assert(0 == header->childCount);
    assert(!header->child);
 	remove_from_parent(header);
+   account_bytes(0, header->size);
    memset(header, 0xfe, header->size + sizeof(*header));
 #if CHECK_ALLOCATION
    assert(allocations.find(ptr) != allocations.end());
@@ -273,6 +288,16 @@ int hieralloc_free(void * ptr)
 	return 0;
 }
 
+void hieralloc_usage(unsigned long * current, unsigned long * peak, int reset_peak)
+{
+   if (current)
+      *current = hieralloc_current_bytes;
+   if (peak)
+      *peak = hieralloc_peak_bytes;
+   if (reset_peak)
+      hieralloc_peak_bytes = hieralloc_current_bytes;
+}
+
 // not implemented from talloc_reference
 void * hieralloc_reference(const void * ref_ctx, const void * ptr)
 {
@@ -293,9 +318,11 @@ int hieralloc_unlink(const void * ctx, void *ptr)
 // returns ptr on success
 void * hieralloc_steal(const void * new_ctx, const void * ptr)
 {
+	if (!ptr)
+		return NULL; // as talloc_steal; glcpp steals empty macro bodies
 	hieralloc_header_t * header = get_header(ptr);
 	remove_from_parent(header);
-	add_to_parent(get_header(new_ctx), header);
+	add_to_parent(new_ctx ? get_header(new_ctx) : &hieralloc_global_header, header);
 	return (void *)ptr;
 }
 
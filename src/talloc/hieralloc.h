@@ -21,8 +21,8 @@
 #define hieralloc_new(ctx) hieralloc_allocate(ctx, 0, "nw:" __location__)
 #define hieralloc_zero(ctx, type) (type *)_hieralloc_zero(ctx, sizeof(type), "zr:"#type)
 #define hieralloc_zero_size(ctx, size) _hieralloc_zero(ctx, size, "zrsz:"__location__)
-#define hieralloc_array(ctx, type, count) (type *)hieralloc_allocate(ctx, sizeof(type) * count, "ar:"#type)
-#define hieralloc_realloc(ctx, p, type, count) (type *)hieralloc_reallocate(ctx, p, sizeof(type) * count, "re:"#type)
+#define hieralloc_array(ctx, type, count) (type *)hieralloc_allocate(ctx, sizeof(type) * (count), "ar:"#type)
+#define hieralloc_realloc(ctx, p, type, count) (type *)hieralloc_reallocate(ctx, p, sizeof(type) * (count), "re:"#type)
 
 #ifdef __cplusplus
 extern "C" {
@@ -86,6 +86,10 @@ char * hieralloc_vasprintf_append(char * str, const char * fmt, va_list va);
 // reallocate and append sprintf
 char * hieralloc_asprintf_append(char * str, const char * fmt, ...);
 
+// bytes requested by live allocations, excluding headers, and the peak since
+// the last reset; reset_peak restarts the peak from the current value
+void hieralloc_usage(unsigned long * current, unsigned long * peak, int reset_peak);
+
 // report self and child allocations
 void hieralloc_report(const void * ptr, FILE * file);
 